@@ -0,0 +1,125 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <bit>
+#include <stdexcept>
+
+// 二进制编码的辅助类，所有定长整数均按小端序写入
+
+// 追加写入到一个std::string缓冲区中
+class BufferWriter {
+public:
+    std::string& buffer;
+
+    BufferWriter(std::string& buffer) : buffer(buffer) {}
+
+    void writeU8(uint8_t value) { buffer.push_back(static_cast<char>(value)); }
+    void writeU32(uint32_t value) { writeScalar(value); }
+    void writeU64(uint64_t value) { writeScalar(value); }
+
+    // 长度前缀（u32）+ 字节内容
+    void writeString(std::string_view str) {
+        writeU32(str.size());
+        buffer.append(str.data(), str.size());
+    }
+
+    // 连续的int32数组，直接拷贝内存
+    void writeInts(const int* values, size_t count) {
+        if constexpr (std::endian::native == std::endian::little) {
+            buffer.append(reinterpret_cast<const char*>(values), count * sizeof(int32_t));
+        } else {
+            for (size_t i = 0; i < count; i++) {
+                writeScalar(static_cast<uint32_t>(values[i]));
+            }
+        }
+    }
+
+    // 连续的uint64数组，直接拷贝内存
+    void writeWords(const uint64_t* values, size_t count) {
+        if constexpr (std::endian::native == std::endian::little) {
+            buffer.append(reinterpret_cast<const char*>(values), count * sizeof(uint64_t));
+        } else {
+            for (size_t i = 0; i < count; i++) {
+                writeScalar(values[i]);
+            }
+        }
+    }
+
+private:
+    template <typename T>
+    void writeScalar(T value) {
+        char bytes[sizeof(T)];
+        for (size_t i = 0; i < sizeof(T); i++) {
+            bytes[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+        }
+        buffer.append(bytes, sizeof(T));
+    }
+};
+
+// 从一段只读字节中顺序读取，越界时抛出异常
+class BufferReader {
+public:
+    std::string_view data;
+    size_t pos = 0;
+
+    BufferReader(std::string_view data) : data(data) {}
+
+    size_t remaining() const { return data.size() - pos; }
+
+    uint8_t readU8() { return static_cast<uint8_t>(take(1)[0]); }
+    uint32_t readU32() { return readScalar<uint32_t>(); }
+    uint64_t readU64() { return readScalar<uint64_t>(); }
+
+    std::string_view readString() {
+        uint32_t len = readU32();
+        return take(len);
+    }
+
+    void readInts(int* values, size_t count) {
+        std::string_view bytes = take(count * sizeof(int32_t));
+        if constexpr (std::endian::native == std::endian::little) {
+            std::memcpy(values, bytes.data(), bytes.size());
+        } else {
+            BufferReader reader(bytes);
+            for (size_t i = 0; i < count; i++) {
+                values[i] = static_cast<int>(reader.readU32());
+            }
+        }
+    }
+
+    void readWords(uint64_t* values, size_t count) {
+        std::string_view bytes = take(count * sizeof(uint64_t));
+        if constexpr (std::endian::native == std::endian::little) {
+            std::memcpy(values, bytes.data(), bytes.size());
+        } else {
+            BufferReader reader(bytes);
+            for (size_t i = 0; i < count; i++) {
+                values[i] = reader.readU64();
+            }
+        }
+    }
+
+private:
+    std::string_view take(size_t len) {
+        if (len > remaining()) {
+            throw std::runtime_error("Runtime Error in BufferReader: Unexpected end of buffer");
+        }
+        std::string_view bytes = data.substr(pos, len);
+        pos += len;
+        return bytes;
+    }
+
+    template <typename T>
+    T readScalar() {
+        std::string_view bytes = take(sizeof(T));
+        T value = 0;
+        for (size_t i = 0; i < sizeof(T); i++) {
+            value |= static_cast<T>(static_cast<uint8_t>(bytes[i])) << (8 * i);
+        }
+        return value;
+    }
+};
@@ -4,39 +4,82 @@
 #include <map>
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <sstream>
+#include <stdexcept>
+#include "Buffer.h"
+
+// 消息帧 = 定长二进制帧头 + 负载
+// 帧头按小端序依次为 from(u32) / to(u32) / command(u32) / request_id(u64) / payload_len(u64)，共28字节
+// 接收方只解析帧头，负载由各handler按命令类型以string_view的方式直接读取，不做额外拷贝
+class FrameHeader {
+public:
+    static const size_t SIZE = 28;
+
+    u_int from = 0;
+    u_int to = 0;
+    u_int command = 0;
+    uint64_t request_id = 0;
+    uint64_t payload_len = 0;
+
+    // 写入到out开始的SIZE个字节
+    void encode(char* out) const {
+        std::string buffer;
+        buffer.reserve(SIZE);
+        BufferWriter writer(buffer);
+        writer.writeU32(from);
+        writer.writeU32(to);
+        writer.writeU32(command);
+        writer.writeU64(request_id);
+        writer.writeU64(payload_len);
+        std::memcpy(out, buffer.data(), SIZE);
+    }
+
+    static FrameHeader decode(std::string_view data) {
+        BufferReader reader(data);
+        FrameHeader header;
+        header.from = reader.readU32();
+        header.to = reader.readU32();
+        header.command = reader.readU32();
+        header.request_id = reader.readU64();
+        header.payload_len = reader.readU64();
+        return header;
+    }
+};
 
 class Message {
 public:
-    u_int from;
-    u_int to;
-    u_int command;
+    u_int from = 0;
+    u_int to = 0;
+    u_int command = 0;
+    uint64_t request_id = 0;
 
     // 构造函数
     Message() = default;
     Message(u_int from, u_int to, u_int command) : from(from), to(to), command(command) {}
-    Message(const std::string& data) {
-        std::istringstream iss(data);
-        std::string line;
-        
-        while(std::getline(iss, line)) {
-            auto pos = line.find(':');
-            auto key = line.substr(0, pos);
-            auto value = line.substr(pos + 1);
-
-            if (key == "from") from = std::stoul(value);
-            else if (key == "to") to = std::stoul(value);
-            else if (key == "command") command = std::stoul(value);
-        }
-    }
-    
-    // 虚函数
-    virtual std::string toString() const {
-        std::ostringstream oss;
-        oss << "from:" << std::to_string(from) << "\n"
-            << "to:" << std::to_string(to) << "\n"
-            << "command:" << std::to_string(command) << "\n";
-        return oss.str();
+    Message(const FrameHeader& header)
+        : from(header.from), to(header.to), command(header.command), request_id(header.request_id) {}
+    virtual ~Message() = default;
+
+    // 虚函数，各类消息写入自己的负载
+    virtual void writePayload(BufferWriter&) const {}
+
+    // 编码为完整的消息帧
+    std::string toFrame() const { return toFrame(request_id); }
+    // 编码为完整的消息帧，并在帧头中使用指定的请求编号
+    std::string toFrame(uint64_t request_id) const {
+        std::string frame(FrameHeader::SIZE, '\0');
+        BufferWriter writer(frame);
+        writePayload(writer);       // 多态，自动调用各类message的writePayload()
+
+        FrameHeader header;
+        header.from = from;
+        header.to = to;
+        header.command = command;
+        header.request_id = request_id;
+        header.payload_len = frame.size() - FrameHeader::SIZE;
+        header.encode(frame.data());
+        return frame;
     }
 };
 
@@ -44,29 +87,6 @@ public:
 class BscMessage : public Message {
 public:
     BscMessage(u_int from, u_int to, u_int command) : Message(from, to, command) {}
-
-    BscMessage(const std::string& data) {
-        std::istringstream iss(data);
-        std::string line;
-        
-        while(std::getline(iss, line)) {
-            auto pos = line.find(':');
-            auto key = line.substr(0, pos);
-            auto value = line.substr(pos + 1);
-
-            if (key == "from") from = std::stoul(value);
-            else if (key == "to") to = std::stoul(value);
-            else if (key == "command") command = std::stoul(value);
-        }
-    }
-
-    std::string toString() const {
-        std::ostringstream oss;
-        oss << "from:" << std::to_string(from) << "\n"
-            << "to:" << std::to_string(to) << "\n"
-            << "command:" << std::to_string(command) << "\n";
-        return oss.str();
-    }
 };
 
 // 操作指令信息，携带输入变量和输出变量的信息
@@ -78,50 +98,26 @@ public:
     OprMessage(u_int from, u_int to, u_int command, std::vector<std::string>& input_names, const std::string& output_name)
         : Message(from, to, command), input_names(input_names), output_name(output_name) {}
 
-    OprMessage(const std::string& data) {
-        std::istringstream iss(data);
-        std::string line;
-        
-        while(std::getline(iss, line)) {
-            auto pos = line.find(':');
-            auto key = line.substr(0, pos);
-            auto value = line.substr(pos + 1);
-
-            if (key == "from") from = std::stoul(value);
-            else if (key == "to") to = std::stoul(value);
-            else if (key == "command") command = std::stoul(value);
-            else if (key == "input_names") {
-                std::string names_str = value;
-                std::istringstream names_stream(names_str);
-                std::string name;
-                while (names_stream >> name) {
-                    input_names.push_back(name);
-                }
-            } 
-            else if (key == "output_name") output_name = value;
+    OprMessage(const Message& header, std::string_view payload) : Message(header) {
+        BufferReader reader(payload);
+        uint32_t count = reader.readU32();
+        for (uint32_t i = 0; i < count; i++) {
+            input_names.emplace_back(reader.readString());
         }
+        output_name = reader.readString();
     }
 
-    std::string toString() const {
-        std::ostringstream oss;
-        oss << "from:" << std::to_string(from) << "\n"
-            << "to:" << std::to_string(to) << "\n"
-            << "command:" << std::to_string(command) << "\n";
-        oss << "input_names:";
-        for (int i = 0; i < input_names.size(); i++) {
-            oss << input_names[i];
-            if (i != input_names.size() - 1) {
-                oss << " ";
-            } else {
-                oss << "\n";
-            }
-        } 
-        oss << "output_name:" << output_name << "\n";
-        return oss.str();
+    void writePayload(BufferWriter& writer) const override {
+        writer.writeU32(input_names.size());
+        for (const auto& name : input_names) {
+            writer.writeString(name);
+        }
+        writer.writeString(output_name);
     }
 };
 
 // 传值指令信息：携带被传递的值的信息
+// 负载：var_name / var_str / result_name，均为u32长度前缀的字节串
 class VarMessage : public Message {
 public:
     std::string var_name;
@@ -134,43 +130,33 @@ public:
     VarMessage(u_int from, u_int to, u_int command, const std::string& var_name, const std::string& var_str, const std::string& result_name) 
         : Message(from, to, command), var_name(var_name), var_str(var_str), result_name(result_name) {}
 
-    VarMessage(const std::string& data) {
-        std::istringstream iss(data);
-        std::string line;
-        
-        while(std::getline(iss, line)) {
-            auto pos = line.find(':');
-            auto key = line.substr(0, pos);
-            auto value = line.substr(pos + 1);
-
-            if (key == "from") from = std::stoul(value);
-            else if (key == "to") to = std::stoul(value);
-            else if (key == "command") command = std::stoul(value);
-            else if (key == "var_name") var_name = value;
-            else if (key == "var_str") var_str = value;
-            else if (key == "result_name") result_name = value;
-            else var_str += "\n" + line;
-        }
+    void writePayload(BufferWriter& writer) const override {
+        writer.writeString(var_name);
+        writer.writeString(var_str);
+        writer.writeString(result_name);
+    }
+};
+
+// VarMessage的接收端视图，各字段直接指向接收缓冲区，仅在handleMessage期间有效
+class VarMessageView : public Message {
+public:
+    std::string_view var_name;
+    std::string_view var_str;
+    std::string_view result_name;
 
+    VarMessageView(const Message& header, std::string_view payload) : Message(header) {
+        BufferReader reader(payload);
+        var_name = reader.readString();
+        var_str = reader.readString();
+        result_name = reader.readString();
         if (result_name.empty()) {
             result_name = var_name;
         }
     }
-
-    std::string toString() const {
-        std::ostringstream oss;
-        oss << "from:" << std::to_string(from) << "\n"
-            << "to:" << std::to_string(to) << "\n"
-            << "command:" << std::to_string(command) << "\n"
-            << "var_name:" << var_name << "\n"
-            << "var_str:" << var_str << "\n"
-            << "result_name:" << result_name << "\n";
-
-        return oss.str();
-    }
 };
 
 // 多值传递指令信息：携带被传递的值的信息
+// 负载：var_count(u32)，var_count组 name / str，最后为result_name
 class VarsMessage : public Message {
 public:
     std::vector<std::pair<std::string, std::string>> vars;
@@ -183,85 +169,131 @@ public:
     VarsMessage(u_int from, u_int to, u_int command, const std::vector<std::pair<std::string, std::string>> &vars, const std::string& result_name)
         : Message(from, to, command), vars(vars), result_name(result_name) {}
 
-    // 反序列化构造函数
-    VarsMessage(const std::string &data) {
-        std::istringstream iss(data);
-        std::string line;
-        size_t var_count = 0;
-        std::map<size_t, std::pair<std::string, std::string>> var_map;
-
-        while (std::getline(iss, line)) {
-            auto pos = line.find(':');
-            if (pos == std::string::npos)
-                continue;
-            std::string key = line.substr(0, pos);
-            std::string value = line.substr(pos + 1);
-
-            if (key == "from") {
-                from = std::stoul(value);
-            } else if (key == "to") {
-                to = std::stoul(value);
-            } else if (key == "command") {
-                command = std::stoul(value);
-            } else if (key == "var_count") {
-                var_count = std::stoul(value);
-            } else if (key.substr(0, 3) == "var") {
-                size_t num_end = key.find('_', 3);
-                if (num_end != std::string::npos) {
-                    std::string num_str = key.substr(3, num_end - 3);
-                    try {
-                        size_t index = std::stoul(num_str);
-                        std::string suffix = key.substr(num_end + 1);
-                        if (suffix == "name") {
-                            var_map[index].first = value;
-                        } else if (suffix == "str") {
-                            var_map[index].second = value;
-                        }
-                    } catch (...) {
-                        // 忽略无效的索引格式
-                    }
-                }
-            } else if (key == "result_name") {
-                result_name = value;
-            }
+    void writePayload(BufferWriter& writer) const override {
+        writer.writeU32(vars.size());
+        for (const auto& var : vars) {
+            writer.writeString(var.first);
+            writer.writeString(var.second);
         }
+        writer.writeString(result_name);
+    }
+};
 
-        if (var_count == 0 && !var_map.empty()) {
-            var_count = var_map.rbegin()->first + 1;
-        }
+// VarsMessage的接收端视图，各字段直接指向接收缓冲区，仅在handleMessage期间有效
+class VarsMessageView : public Message {
+public:
+    std::vector<std::pair<std::string_view, std::string_view>> vars;
+    std::string_view result_name;
 
+    VarsMessageView(const Message& header, std::string_view payload) : Message(header) {
+        BufferReader reader(payload);
+        uint32_t var_count = reader.readU32();
         vars.reserve(var_count);
-        for (size_t i = 0; i < var_count; ++i) {
-            auto it = var_map.find(i);
-            if (it != var_map.end() && !it->second.first.empty() && !it->second.second.empty()) {
-                vars.emplace_back(it->second.first, it->second.second);
-            } else {
-                vars.emplace_back("", "");
-            }
+        for (uint32_t i = 0; i < var_count; i++) {
+            std::string_view name = reader.readString();
+            std::string_view str = reader.readString();
+            vars.emplace_back(name, str);
         }
+        result_name = reader.readString();
     }
+};
 
-    // 序列化方法
-    /*
-        from:1
-        to:2
-        command:3
-        var_count:2
-        var0_name:temperature
-        var0_str:23.5
-        var1_name:humidity
-        var1_str:60%\
-        result_name:result
-    */
-    std::string toString() const override {
-        std::ostringstream oss;
-        oss << Message::toString();
-        oss << "var_count:" << vars.size() << "\n";
-        for (size_t i = 0; i < vars.size(); ++i) {
-            oss << "var" << i << "_name:" << vars[i].first << "\n"
-                << "var" << i << "_str:" << vars[i].second << "\n";
-        }
-        oss << "result_name:" << result_name << "\n";
-        return oss.str();
+// 表传递指令信息：携带二进制编码的表
+// 负载：var_name（u32长度前缀），其后直到负载末尾均为Table::toBinary()的结果
+class TableMessage : public Message {
+public:
+    std::string var_name;
+    std::string table_bin;
+
+    TableMessage(u_int from, u_int to, u_int command, const std::string& var_name, std::string table_bin)
+        : Message(from, to, command), var_name(var_name), table_bin(std::move(table_bin)) {}
+
+    void writePayload(BufferWriter& writer) const override {
+        writer.writeString(var_name);
+        writer.buffer.append(table_bin);
+    }
+};
+
+// TableMessage的接收端视图，table_bin直接指向接收缓冲区，仅在handleMessage期间有效
+class TableMessageView : public Message {
+public:
+    std::string_view var_name;
+    std::string_view table_bin;
+
+    TableMessageView(const Message& header, std::string_view payload) : Message(header) {
+        BufferReader reader(payload);
+        var_name = reader.readString();
+        table_bin = payload.substr(payload.size() - reader.remaining());
     }
-};
\ No newline at end of file
+};
+
+// PRG种子分发信息：分发者把生成第component个分量所用的种子发给持有该分量的Server
+class SeedMessage : public Message {
+public:
+    u_int component;
+    std::string seed;
+
+    SeedMessage(u_int from, u_int to, u_int command, u_int component, const std::string& seed)
+        : Message(from, to, command), component(component), seed(seed) {}
+
+    void writePayload(BufferWriter& writer) const override {
+        writer.writeU32(component);
+        writer.writeString(seed);
+    }
+};
+
+// SeedMessage的接收端视图
+class SeedMessageView : public Message {
+public:
+    u_int component;
+    std::string_view seed;
+
+    SeedMessageView(const Message& header, std::string_view payload) : Message(header) {
+        BufferReader reader(payload);
+        component = reader.readU32();
+        seed = reader.readString();
+    }
+};
+
+// 基于PRG种子的份额传递信息：分量x_0、x_1由双方各自用种子在prg_offset处展开，只传递修正分量x_2
+// 负载：var_name / share_idx(u32，接收方持有分量{x_i, x_{i+1}}中的i) / prg_offset(u64) / rows(u64)，其后为修正分量的数据
+class SeededShareMessage : public Message {
+public:
+    std::string var_name;
+    u_int share_idx;
+    uint64_t prg_offset;
+    uint64_t rows;
+    std::string data;
+
+    SeededShareMessage(u_int from, u_int to, u_int command, const std::string& var_name, u_int share_idx,
+                       uint64_t prg_offset, uint64_t rows, std::string data)
+        : Message(from, to, command), var_name(var_name), share_idx(share_idx), prg_offset(prg_offset), rows(rows),
+          data(std::move(data)) {}
+
+    void writePayload(BufferWriter& writer) const override {
+        writer.writeString(var_name);
+        writer.writeU32(share_idx);
+        writer.writeU64(prg_offset);
+        writer.writeU64(rows);
+        writer.buffer.append(data);
+    }
+};
+
+// SeededShareMessage的接收端视图，data直接指向接收缓冲区，仅在handleMessage期间有效
+class SeededShareMessageView : public Message {
+public:
+    std::string_view var_name;
+    u_int share_idx;
+    uint64_t prg_offset;
+    uint64_t rows;
+    std::string_view data;
+
+    SeededShareMessageView(const Message& header, std::string_view payload) : Message(header) {
+        BufferReader reader(payload);
+        var_name = reader.readString();
+        share_idx = reader.readU32();
+        prg_offset = reader.readU64();
+        rows = reader.readU64();
+        data = payload.substr(payload.size() - reader.remaining());
+    }
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+// 无锁多生产者单消费者队列（Vyukov），队首始终保留一个哨兵结点
+// push可在任意线程并发调用；pop只能由单一消费者调用，生产者尚未完成链接时可能暂时返回false
+template <typename T>
+class MpscQueue {
+public:
+    MpscQueue() {
+        Item* dummy = new Item();
+        head.store(dummy, std::memory_order_relaxed);
+        tail = dummy;
+    }
+
+    ~MpscQueue() {
+        T value;
+        while (pop(value)) {}
+        delete tail;
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    void push(T value) {
+        Item* item = new Item();
+        item->value = std::move(value);
+        Item* prev = head.exchange(item, std::memory_order_acq_rel);
+        prev->next.store(item, std::memory_order_release);
+    }
+
+    bool pop(T& value) {
+        Item* next = tail->next.load(std::memory_order_acquire);
+        if (next == nullptr) {
+            return false;
+        }
+        value = std::move(next->value);
+        delete tail;
+        tail = next;
+        return true;
+    }
+
+private:
+    struct Item {
+        std::atomic<Item*> next{nullptr};
+        T value;
+    };
+
+    std::atomic<Item*> head;    // 生产者端
+    Item* tail;                 // 消费者端（哨兵）
+};
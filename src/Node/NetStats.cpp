@@ -0,0 +1,174 @@
+#include "NetStats.h"
+#include "Node.h"
+#include <sstream>
+#include <iomanip>
+
+CommandStats& CommandStats::operator+=(const CommandStats& other) {
+    sent_msgs += other.sent_msgs;
+    sent_bytes += other.sent_bytes;
+    recv_msgs += other.recv_msgs;
+    recv_bytes += other.recv_bytes;
+    serialize_ns += other.serialize_ns;
+    handle_ns += other.handle_ns;
+    wait_ns += other.wait_ns;
+    return *this;
+}
+
+CommandStats& CommandStats::operator-=(const CommandStats& other) {
+    sent_msgs -= other.sent_msgs;
+    sent_bytes -= other.sent_bytes;
+    recv_msgs -= other.recv_msgs;
+    recv_bytes -= other.recv_bytes;
+    serialize_ns -= other.serialize_ns;
+    handle_ns -= other.handle_ns;
+    wait_ns -= other.wait_ns;
+    return *this;
+}
+
+NetSnapshot& NetSnapshot::operator+=(const NetSnapshot& other) {
+    for (u_int c = 0; c < MAX_COMMANDS; c++) {
+        commands[c] += other.commands[c];
+    }
+    return *this;
+}
+
+NetSnapshot& NetSnapshot::operator-=(const NetSnapshot& other) {
+    for (u_int c = 0; c < MAX_COMMANDS; c++) {
+        commands[c] -= other.commands[c];
+    }
+    return *this;
+}
+
+CommandStats NetSnapshot::total() const {
+    CommandStats sum;
+    for (const auto& stats : commands) {
+        sum += stats;
+    }
+    return sum;
+}
+
+void NetStats::recordSend(u_int command, uint64_t bytes, uint64_t serialize_ns) {
+    Counters& c = at(command);
+    c.sent_msgs.fetch_add(1, std::memory_order_relaxed);
+    c.sent_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    c.serialize_ns.fetch_add(serialize_ns, std::memory_order_relaxed);
+}
+
+void NetStats::recordRecv(u_int command, uint64_t bytes) {
+    Counters& c = at(command);
+    c.recv_msgs.fetch_add(1, std::memory_order_relaxed);
+    c.recv_bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void NetStats::recordHandle(u_int command, uint64_t handle_ns) {
+    at(command).handle_ns.fetch_add(handle_ns, std::memory_order_relaxed);
+}
+
+void NetStats::recordSerialize(u_int command, uint64_t serialize_ns) {
+    at(command).serialize_ns.fetch_add(serialize_ns, std::memory_order_relaxed);
+}
+
+void NetStats::recordWait(u_int command, uint64_t wait_ns) {
+    at(command).wait_ns.fetch_add(wait_ns, std::memory_order_relaxed);
+}
+
+NetSnapshot NetStats::snapshot() const {
+    NetSnapshot snapshot;
+    for (u_int i = 0; i < NetSnapshot::MAX_COMMANDS; i++) {
+        const Counters& c = counters[i];
+        CommandStats& s = snapshot.commands[i];
+        s.sent_msgs = c.sent_msgs.load(std::memory_order_relaxed);
+        s.sent_bytes = c.sent_bytes.load(std::memory_order_relaxed);
+        s.recv_msgs = c.recv_msgs.load(std::memory_order_relaxed);
+        s.recv_bytes = c.recv_bytes.load(std::memory_order_relaxed);
+        s.serialize_ns = c.serialize_ns.load(std::memory_order_relaxed);
+        s.handle_ns = c.handle_ns.load(std::memory_order_relaxed);
+        s.wait_ns = c.wait_ns.load(std::memory_order_relaxed);
+    }
+    return snapshot;
+}
+
+void NetStats::reset() {
+    for (Counters& c : counters) {
+        c.sent_msgs = 0;
+        c.sent_bytes = 0;
+        c.recv_msgs = 0;
+        c.recv_bytes = 0;
+        c.serialize_ns = 0;
+        c.handle_ns = 0;
+        c.wait_ns = 0;
+    }
+}
+
+NetMetrics& NetMetrics::global() {
+    static NetMetrics metrics;
+    return metrics;
+}
+
+void NetMetrics::add(const std::string& phase, const NetSnapshot& snapshot) {
+    std::lock_guard<std::mutex> lock(mtx);
+    for (auto& [name, stats] : phases) {
+        if (name == phase) {
+            stats += snapshot;
+            return;
+        }
+    }
+    phases.emplace_back(phase, snapshot);
+}
+
+void NetMetrics::clear() {
+    std::lock_guard<std::mutex> lock(mtx);
+    phases.clear();
+}
+
+bool NetMetrics::empty() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return phases.empty();
+}
+
+// 输出一行统计，时间换算为毫秒
+static void printStatsRow(std::ostringstream& oss, const std::string& name, const CommandStats& s) {
+    oss << "  " << std::left << std::setw(28) << name << std::right
+        << std::setw(10) << s.sent_msgs << std::setw(14) << s.sent_bytes
+        << std::setw(10) << s.recv_msgs << std::setw(14) << s.recv_bytes
+        << std::fixed << std::setprecision(2)
+        << std::setw(12) << s.serialize_ns / 1e6 << std::setw(12) << s.handle_ns / 1e6 << std::setw(12) << s.wait_ns / 1e6
+        << "\n";
+}
+
+std::string NetMetrics::report() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    std::ostringstream oss;
+    oss << "Network metrics by phase (time in ms):\n";
+    oss << "  " << std::left << std::setw(28) << "command" << std::right
+        << std::setw(10) << "sent" << std::setw(14) << "sent_bytes"
+        << std::setw(10) << "recv" << std::setw(14) << "recv_bytes"
+        << std::setw(12) << "serialize" << std::setw(12) << "handle" << std::setw(12) << "wait" << "\n";
+    for (const auto& [phase, stats] : phases) {
+        oss << "[" << phase << "]\n";
+        for (u_int c = 0; c < NetSnapshot::MAX_COMMANDS; c++) {
+            if (!stats.commands[c].empty()) {
+                printStatsRow(oss, Command::name(c), stats.commands[c]);
+            }
+        }
+        printStatsRow(oss, "TOTAL", stats.total());
+    }
+    return oss.str();
+}
+
+std::string NetMetrics::toCSV() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    std::ostringstream oss;
+    oss << "phase,command,sent_msgs,sent_bytes,recv_msgs,recv_bytes,serialize_ns,handle_ns,wait_ns\n";
+    for (const auto& [phase, stats] : phases) {
+        for (u_int c = 0; c < NetSnapshot::MAX_COMMANDS; c++) {
+            const CommandStats& s = stats.commands[c];
+            if (s.empty()) {
+                continue;
+            }
+            oss << phase << "," << Command::name(c) << "," << s.sent_msgs << "," << s.sent_bytes << ","
+                << s.recv_msgs << "," << s.recv_bytes << "," << s.serialize_ns << "," << s.handle_ns << "," << s.wait_ns << "\n";
+        }
+    }
+    return oss.str();
+}
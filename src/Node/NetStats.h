@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include <sys/types.h>
+
+// 单个命令的网络统计，时间单位均为纳秒
+struct CommandStats {
+    uint64_t sent_msgs = 0;         // 发送的消息数
+    uint64_t sent_bytes = 0;        // 发送的字节数（含帧头）
+    uint64_t recv_msgs = 0;         // 收到的消息数
+    uint64_t recv_bytes = 0;        // 收到的字节数（含帧头）
+    uint64_t serialize_ns = 0;      // 发送时编码负载（toBinary）和消息帧的时间
+    uint64_t handle_ns = 0;         // 接收方handleMessage的时间
+    uint64_t wait_ns = 0;           // waitResponses中等待对方回复的时间
+
+    CommandStats& operator+=(const CommandStats& other);
+    CommandStats& operator-=(const CommandStats& other);
+    bool empty() const { return sent_msgs == 0 && recv_msgs == 0 && serialize_ns == 0 && wait_ns == 0; }
+};
+
+// 按命令分类的网络统计快照，可相加、相减，用于汇总多个节点或计算某一阶段的增量
+class NetSnapshot {
+public:
+    static const u_int MAX_COMMANDS = 32;   // 命令编号上限，超出的编号计入最后一项
+
+    std::array<CommandStats, MAX_COMMANDS> commands;
+
+    NetSnapshot& operator+=(const NetSnapshot& other);
+    NetSnapshot& operator-=(const NetSnapshot& other);
+    // 所有命令的合计
+    CommandStats total() const;
+};
+
+// 节点的网络计数器，发送线程和Reactor的处理线程可并发更新
+class NetStats {
+public:
+    void recordSend(u_int command, uint64_t bytes, uint64_t serialize_ns);
+    void recordRecv(u_int command, uint64_t bytes);
+    void recordHandle(u_int command, uint64_t handle_ns);
+    void recordSerialize(u_int command, uint64_t serialize_ns);
+    void recordWait(u_int command, uint64_t wait_ns);
+
+    NetSnapshot snapshot() const;
+    void reset();
+
+    // 单调时钟的当前时间，单位为纳秒
+    static uint64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+private:
+    struct Counters {
+        std::atomic<uint64_t> sent_msgs{0};
+        std::atomic<uint64_t> sent_bytes{0};
+        std::atomic<uint64_t> recv_msgs{0};
+        std::atomic<uint64_t> recv_bytes{0};
+        std::atomic<uint64_t> serialize_ns{0};
+        std::atomic<uint64_t> handle_ns{0};
+        std::atomic<uint64_t> wait_ns{0};
+    };
+
+    std::array<Counters, NetSnapshot::MAX_COMMANDS> counters;
+
+    Counters& at(u_int command) { return counters[command < NetSnapshot::MAX_COMMANDS ? command : NetSnapshot::MAX_COMMANDS - 1]; }
+};
+
+// 进程内按协议阶段汇总的网络统计，由Protocol在各阶段结束时登记，Test负责输出
+class NetMetrics {
+public:
+    static NetMetrics& global();
+
+    // 登记一个阶段的统计增量，同名阶段累加，阶段按首次登记的顺序输出
+    void add(const std::string& phase, const NetSnapshot& snapshot);
+    void clear();
+    bool empty() const;
+
+    // 按阶段、按命令输出的文本表格
+    std::string report() const;
+    // CSV格式：phase,command,sent_msgs,sent_bytes,recv_msgs,recv_bytes,serialize_ns,handle_ns,wait_ns
+    std::string toCSV() const;
+
+private:
+    mutable std::mutex mtx;
+    std::vector<std::pair<std::string, NetSnapshot>> phases;
+};
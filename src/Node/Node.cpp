@@ -3,13 +3,15 @@
 #include <netinet/tcp.h>
 
 std::mutex socks_mutex;       // 保护socks的互斥锁
-std::mutex var_mutex;
-std::condition_variable var_cv;
 std::mutex handle_mutex;
-std::mutex wait_mutex;
-std::condition_variable wait_cv;
 std::mutex print_mutex;
 
+// 以prg在offset处展开的密钥流填充bits的第k个分量，每个压缩字占两个密钥流字
+static void fillBits(const PRG& prg, uint64_t offset, BitColumn& bits, u_int k) {
+    auto& words = bits.words(k);
+    prg.fill(offset, reinterpret_cast<uint32_t*>(words.data()), words.size() * 2);
+    bits.clearTail(k);
+}
 
 const std::string Node::DEFAULT_ADDR[NODE_MAXIMUM_NUM] = {
     "127.0.0.1:5000",   // Server0
@@ -29,6 +31,22 @@ Node::Node(u_int id, const std::string& name) {
     this->name = name;
     this->clearFile();
 
+    // 每个节点作为分发者时使用的两个PRG种子，在会话内保持不变
+    for (auto& prg : dealer_prgs) {
+        prg = PRG(PRG::randomSeed());
+    }
+    zero_prg = PRG(PRG::randomSeed());
+
+    // 收到完整的帧后由reactor的处理线程调用handleMessage
+    reactor = std::make_unique<Reactor>([this](const FrameHeader& header, std::string_view payload) {
+        Message message(header);
+        // 先计入收到的消息，处理函数中回复RESPONSE_OK后发送方即可继续，保证统计落在发送方所处的阶段内
+        net_stats.recordRecv(header.command, FrameHeader::SIZE + payload.size());
+        uint64_t start = NetStats::now();
+        handleMessage(message, payload);
+        net_stats.recordHandle(header.command, NetStats::now() - start);
+    });
+
     listen_sock = socket(AF_INET, SOCK_STREAM, 0);
     if (listen_sock < 0) {
         error("Error creating listening socket");
@@ -58,8 +76,6 @@ Node::Node(u_int id, const std::string& name) {
             exit(EXIT_FAILURE);
         }
 
-        // 预留用于连接的sock位置
-        socks.resize(NODE_MAXIMUM_NUM, -1);
         log("starting to listen on address " + DEFAULT_ADDR[id]);
     } catch (const std::exception &e) {
         std::cerr << e.what() << std::endl;
@@ -71,28 +87,34 @@ Node::~Node() {
 }
 
 void Node::startlistening() {
-    while (true) {
-        struct sockaddr_in addr;
-        socklen_t addrlen = sizeof(addr);
-        int new_sock = accept(listen_sock, (struct sockaddr*)&addr, &addrlen);
-        if (new_sock < 0) {
-            if (errno == EBADF || errno == EINVAL) {
-                // 如果是主动关闭
-                break;
-            } else {
-                error("Error accepting connection");
-                continue;
-            }
+    // 阻塞运行事件循环，直到stop()
+    reactor->run(listen_sock);
+}
+
+void Node::connectToPeers(std::vector<Node*> nodes, u_int transport_type, const NetworkProfile& profile) {
+    if (transport_type == IN_PROCESS_TRANSPORT) {
+        // 同进程内的节点直接投递到对端的Reactor
+        std::vector<Reactor*> peers(NODE_MAXIMUM_NUM, nullptr);
+        for (auto node : nodes) {
+            peers[node->id] = node->reactor.get();
+        }
+        for (auto node : nodes) {
+            node->transport = std::make_unique<InProcessTransport>(node->id, peers);
         }
+    } else {
+        connectTcpPeers(nodes);
+    }
 
-        socks.push_back(new_sock);
-        recv_threads.emplace_back(&Node::recvMessage, this, new_sock);
+    if (!profile.isIdeal()) {
+        for (auto node : nodes) {
+            node->transport = std::make_unique<ShapedTransport>(node->id, std::move(node->transport), profile);
+        }
     }
 }
 
-void Node::connectToPeers(std::vector<Node*> nodes) {
-    // nodes之间相互建立TCP连接
+void Node::connectTcpPeers(std::vector<Node*> nodes) {
     for (auto si = nodes.begin(); si != nodes.end(); si++) {
+        std::vector<int> socks(NODE_MAXIMUM_NUM, -1);
         for (auto sj = nodes.begin(); sj != nodes.end(); sj++) {
             if ((*si)->id == (*sj)->id) continue;
             int sock = socket(AF_INET, SOCK_STREAM, 0);
@@ -111,17 +133,21 @@ void Node::connectToPeers(std::vector<Node*> nodes) {
                     sleep(1);
                 }
 
-                (*si)->socks[(*sj)->id] = sock;
+                socks[(*sj)->id] = sock;
                 // std::cout << DEFAULT_ADDR[(*si)->id] + " has connected to " + DEFAULT_ADDR[(*sj)->id] << std::endl;
             } catch (std::exception& e) {
                 std::cerr << e.what() << std::endl;
             }
         }
+        (*si)->transport = std::make_unique<TcpTransport>(std::move(socks));
     }
 }
 
 void Node::stop() {
     // std::lock_guard<std::mutex> lock(socks_mutex);
+    // 通知事件循环退出，由其关闭所有接入的连接
+    reactor->stop();
+
     // 关闭监听套接字
     if (listen_sock != -1) {
         shutdown(listen_sock, SHUT_RDWR);
@@ -129,308 +155,335 @@ void Node::stop() {
         listen_sock = -1;
     }
 
-    // 关闭所有连接套接字
-    for (int sock : socks) {
-        if (sock != -1) {
-            shutdown(sock, SHUT_RDWR);
-            close(sock);
-            sock = -1;
-        }
-    }
-
-    // 等待所有接受线程结束
-    for (auto& th : recv_threads) {
-        if (th.joinable()) {
-            th.join();
-        }
+    // 关闭所有主动建立的连接
+    if (transport) {
+        transport->close();
     }
-
-    recv_threads.clear();
 }
 
 void Node::sendMessage(Node* node, const Message& message) {
     sendMessage(node->id, message);
 }
 
-void Node::sendMessage(u_int to_id, const Message &message) {
-    std::string message_str = message.toString();       // 多态，自动调用各类message的toString()
-    uint64_t message_len = htobe64(message_str.size());
-
-    // 发送消息长度
-    if (send(socks[to_id], &message_len, sizeof(message_len), 0) < 0) {
-        error("Error sending message length to Server" + std::to_string(to_id));
+void Node::sendMessage(u_int to_id, const Message &message, uint64_t request_id) {
+    // 帧头与负载一次性编码，整个缓冲区交给传输层
+    uint64_t start = NetStats::now();
+    std::string frame = message.toFrame(request_id);
+    net_stats.recordSend(message.command, frame.size(), NetStats::now() - start);
+    if (!transport || !transport->send(to_id, std::move(frame))) {
+        error("Error sending message to Server" + std::to_string(to_id));
     }
+    // log("send command " + std::to_string(message.command) + " to Server_ID: " + std::to_string(to_id));
+}
 
-    // 发送消息内容
-    if (send(socks[to_id], message_str.c_str(), message_str.size(), 0) < 0) {
-        error("Error sending message content to Server" + std::to_string(to_id));
+std::future<void> Node::sendRequest(u_int to_id, const Message &message) {
+    // 先登记请求，避免回复先于登记到达
+    uint64_t request_id = next_request_id++;
+    std::future<void> future;
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        future = pending_requests[request_id].get_future();
     }
-    // log("send \"" + message_str + "\" to Server_ID: " + std::to_string(to_id));
+    sendMessage(to_id, message, request_id);
+    return future;
 }
 
-// void Node::sendMessageAndWait(u_int to_id, const Message &message) {
-//     sendMessage(to_id, message);
-//     // 等待接收方回复
-//     wait(to_id);
-//     while (isWaiting()) {}
-// }
-
 void Node::sendMessageAndWait(u_int to_id, const Message &message) {
-    wait(to_id);
-    sendMessage(to_id, message);
-
-    // 持续等待 OK 回复
-    std::unique_lock<std::mutex> lock(wait_mutex);
-    wait_cv.wait(lock, [this] { return !this->isWaiting(); });
+    // 等待对方处理完该条消息
+    waitResponses(message.command, sendRequest(to_id, message));
 }
 
-void Node::recvMessage(int sock) {
-    while (true) {
-        uint64_t message_len;
-        ssize_t total_head_received = 0;
-        char* buffer = reinterpret_cast<char*>(&message_len);
-
-        // 循环接收，保证完整读取8字节消息头
-        while (total_head_received < sizeof(message_len)) {
-            ssize_t len_recv = recv(sock, 
-                                    buffer + total_head_received,                // 使用偏移地址
-                                    sizeof(message_len) - total_head_received,   // 剩余待接收量
-                                    0);
-            if (len_recv == 0) {    // 对端正常关闭连接
-                // log("Connection closed by peer");
-                close(sock);
-                return;
-            } else if (len_recv < 0) {  // 发生系统错误
-                error("Error receiving message length");
-                close(sock);
-                return;
-            }
-            total_head_received += len_recv;
-        }
+void Node::waitResponses(u_int command, std::vector<std::future<void>>& responses) {
+    uint64_t start = NetStats::now();
+    for (auto& response : responses) {
+        response.wait();
+    }
+    net_stats.recordWait(command, NetStats::now() - start);
+}
 
-        message_len = be64toh(message_len);     // 大端字节序转换为主机字节序
+void Node::waitResponses(u_int command, std::future<void> response) {
+    uint64_t start = NetStats::now();
+    response.wait();
+    net_stats.recordWait(command, NetStats::now() - start);
+}
 
-        // 为防止恶意的超大长度值，可以添加合理性检查
-        const uint64_t MAX_MESSAGE_SIZE = 1ULL << 50;  // 4GB上限，可根据需求调整
-        if (message_len > MAX_MESSAGE_SIZE) {
-            error("Message length too large: " + std::to_string(message_len));
-            break;
-        } else {
-            // log("MAX_MESSAGE_SIZE is " + std::to_string(MAX_MESSAGE_SIZE) + ", and current message size is " + std::to_string(message_len));
-        }
+std::string Node::serializeTable(u_int command, const Table& table) {
+    uint64_t start = NetStats::now();
+    std::string bin = table.toBinary();
+    net_stats.recordSerialize(command, NetStats::now() - start);
+    return bin;
+}
 
-        // 分块接收消息
-        const size_t CHUNK_SIZE = 1024 * 1024;
-        std::string message_str;
-        message_str.reserve(std::min(message_len, CHUNK_SIZE));
-        uint64_t total_received = 0;
-        std::vector<char> chunk_buffer(CHUNK_SIZE);
-        while(total_received < message_len) {
-            size_t remaining = message_len - total_received;
-            size_t current_chunk_size = std::min(remaining, CHUNK_SIZE);
-            ssize_t bytes_recv = recv(sock, chunk_buffer.data(), current_chunk_size, 0);
-            if (bytes_recv > 0) {
-                message_str.append(chunk_buffer.data(), bytes_recv);
-                total_received += bytes_recv;
-            } else if (bytes_recv == 0) {
-                log("Connection closed by peer");
-                return;
-            } else {
-                error("Error receiving message");
-                return;
-            }
-        }
-        
-        if (total_received == message_len) {
-            Message message(message_str);
-            handleMessage(message, message_str);
-        }
+void Node::sendOK(u_int to_id, uint64_t request_id) {
+    if (request_id == 0) {
+        return;
     }
+    BscMessage response(this->id, to_id, Command::RESPONSE_OK);
+    sendMessage(to_id, response, request_id);
 }
 
-void Node::sendOK(u_int to_id) {
-    BscMessage response(this->id, to_id, Command::RESPONSE_OK);
-    sendMessage(to_id, response);
+// 已就绪的future，用于没有发出请求的情况
+static std::future<void> readyFuture() {
+    std::promise<void> promise;
+    promise.set_value();
+    return promise.get_future();
 }
 
+void Node::completeRequest(uint64_t request_id) {
+    std::lock_guard<std::mutex> lock(pending_mutex);
+    auto it = pending_requests.find(request_id);
+    if (it == pending_requests.end()) {
+        warning("Unknown request id in completeRequest(): " + std::to_string(request_id));
+        return;
+    }
+    it->second.set_value();
+    pending_requests.erase(it);
+}
+
+void Node::handleMessage(const Message& message, std::string_view payload) {
+    // 回复只需唤醒对应的请求，不必与其他消息的处理互斥
+    if (message.command == Command::RESPONSE_OK) {
+        completeRequest(message.request_id);
+        return;
+    }
 
-void Node::handleMessage(const Message& message, const std::string& message_str) {
     std::lock_guard<std::mutex> guard(handle_msg_mtx);
 
     if (message.command == Command::RECEIVE_INT_SHARE) {
-        VarMessage vmsg(message_str);
+        VarMessageView vmsg(message, payload);
+        std::string var_name(vmsg.var_name);     // 变量名很短，只拷贝变量名，数据部分直接在负载上解析
         SharePair sp(vmsg.var_str);
-        this->setVar(vmsg.var_name, sp);
-        this->sendOK(message.from);
+        this->setVar(var_name, sp);
+        this->sendOK(message.from, message.request_id);
     } 
 
-    else if (message.command == Command::RESPONSE_OK) {
-        waitOK(message.from);
-        // log("receive OK from Server " + std::to_string(message.from));
+    else if (message.command == Command::RECEIVE_PRG_SEED) {
+        SeedMessageView smsg(message, payload);
+        peer_prgs[{message.from, smsg.component}] = PRG(smsg.seed);
+        this->sendOK(message.from, message.request_id);
+    }
+
+    else if (message.command == Command::RECEIVE_SEEDED_INT_SHARE) {
+        SeededShareMessageView smsg(message, payload);
+        std::string var_name(smsg.var_name);
+        BufferReader reader(smsg.data);
+        u_int share_type = reader.readU32();
+        // 持有分量{x_i, x_{i+1}}，x_0、x_1由分发者的种子展开，x_2为消息中的修正分量
+        int x[2];
+        for (u_int k = 0; k < 2; k++) {
+            u_int c = (smsg.share_idx + k) % SHARE_PARTY_NUM;
+            if (c < 2) {
+                getPeerPRG(message.from, c).fillShares(smsg.prg_offset, &x[k], 1);
+            } else {
+                x[k] = static_cast<int>(reader.readU32());
+            }
+        }
+        this->setVar(var_name, SharePair({x[0], x[1]}, share_type));
+        this->sendOK(message.from, message.request_id);
+    }
+
+    else if (message.command == Command::RECEIVE_SEEDED_TABLE_SHARE) {
+        SeededShareMessageView smsg(message, payload);
+        std::string var_name(smsg.var_name);
+        // 表按行分块到达，块数据前是块的起始行和总行数；修正分量以INT_MODE表的形式传递，S_0不持有x_2，只收到表头
+        BufferReader reader(smsg.data);
+        size_t start = reader.readU64();
+        size_t total = reader.readU64();
+        Table correction(Table::INT_MODE);
+        correction.readFromBinary(smsg.data.substr(smsg.data.size() - reader.remaining()));
+        size_t rows = smsg.rows;
+        auto it = partial_tables.find(var_name);
+        if (it == partial_tables.end()) {
+            PartialTable partial;
+            partial.table.headers = correction.headers;
+            partial.table.share_types = correction.share_types;
+            partial.table.max_freqs = correction.max_freqs;
+            partial.table.initColumns(total);
+            it = partial_tables.emplace(var_name, std::move(partial)).first;
+        }
+        Table& sst = it->second.table;
+        // 块的位置和修正分量的形状来自网络，与已有的部分表不符时丢弃该块，避免越界写入
+        bool holds_x2 = smsg.share_idx != 0;
+        if (total != sst.size() || rows > total || start > total - rows || correction.columns.size() != sst.columns.size() ||
+            (holds_x2 && (correction.size() != rows || correction.is_null.size() != rows))) {
+            warning("Invalid block in handleMessage(), command is RECEIVE_SEEDED_TABLE_SHARE: rows [" + std::to_string(start) + ", " +
+                    std::to_string(start + rows) + ") of " + std::to_string(total) + " for " + var_name + " with " +
+                    std::to_string(sst.size()) + " rows");
+            return;
+        }
+        // 块内第j列的分量x_c位于密钥流的prg_offset + j * rows处，is_null的压缩字紧随其后
+        for (size_t j = 0; j < sst.columns.size(); j++) {
+            for (u_int k = 0; k < 2; k++) {
+                u_int c = (smsg.share_idx + k) % SHARE_PARTY_NUM;
+                int* dst = sst.columns[j].part(k).data() + start;
+                if (c < 2) {
+                    getPeerPRG(message.from, c).fillShares(smsg.prg_offset + j * rows, dst, rows);
+                } else {
+                    std::copy(correction.columns[j].cpart(0).begin(), correction.columns[j].cpart(0).end(), dst);
+                }
+            }
+        }
+        BitColumn null_block(2, rows);
+        for (u_int k = 0; k < 2; k++) {
+            u_int c = (smsg.share_idx + k) % SHARE_PARTY_NUM;
+            if (c < 2) {
+                fillBits(getPeerPRG(message.from, c), smsg.prg_offset + sst.columns.size() * rows, null_block, k);
+            } else {
+                null_block.sharePart(k, correction.is_null, 0);
+            }
+        }
+        sst.is_null.assign(start, null_block);
+        // 收齐所有行后存为变量
+        it->second.received += rows;
+        if (it->second.received == total) {
+            this->setVar(var_name, std::move(sst));
+            partial_tables.erase(it);
+        }
+        sendOK(message.from, message.request_id);
     }
 
     else if (message.command == Command::REVEAL_INT) {
-        VarMessage vmsg(message_str);
-        std::string reveal_name = vmsg.var_name.substr(1, vmsg.var_name.length() - 2);
+        VarMessageView vmsg(message, payload);
+        std::string var_name(vmsg.var_name);
+        std::string reveal_name = var_name.substr(1, var_name.length() - 2);
         try {
             int reveal;
-            if (var_store.count(vmsg.var_name) > 0) {   
+            if (hasVar(var_name)) {   
                 // 如果本身有要重构的变量的一份SharePair，那么Reveal协议只会让S_{i-1}把他的SharePair发过来，使用x_{i-1}即可
-                SharePair sp = std::any_cast<SharePair>(this->getVar(vmsg.var_name));   // 拿自己那份sp
+                SharePair sp = std::any_cast<SharePair>(this->getVar(var_name));   // 拿自己那份sp
                 SharePair sp_received(vmsg.var_str);    // 提取vmsg中接受的sp
                 // 按共享类型重构秘密值
-                if (sp.type == ARITHMETIC_SHARING) {
-                    int res = (sp[0] + sp[1] + sp_received[0]) % MOD;
-                    reveal = res < 0 ? res + MOD : res; //  确保落在[0,MOD)
-                } else if (sp.type == BINARY_SHARING) {
-                    reveal = sp[0] ^ sp[1] ^ sp_received[0];
-                }
+                reveal = reconstructValue(sp[0], sp[1], sp_received[0], sp.type);
                 // 将重构后的值存入
                 this->setVar(reveal_name, reveal);
             } else {
                 // 如果本身没有要重构变量的SharePair，则使用reveal_buffer接受多份数据
                 std::unique_lock<std::mutex> lock(handle_mutex);
                 SharePair sp(vmsg.var_str);
-                if (reveal_buffer.count(vmsg.var_name) <= 0) {    // 如果buffer中没有则初始化一个
-                    reveal_buffer[vmsg.var_name] = ShareTuple(sp.type);
+                if (reveal_buffer.count(var_name) <= 0) {    // 如果buffer中没有则初始化一个
+                    reveal_buffer[var_name] = ShareTuple(sp.type);
                 }
-                auto& st = std::any_cast<ShareTuple&>(reveal_buffer[vmsg.var_name]);
+                auto& st = std::any_cast<ShareTuple&>(reveal_buffer[var_name]);
                 st[vmsg.from] = sp[0];
 
                 if (st.isFull()) {  // 如果填满了则reveal
                     reveal = st.compute();
                     // 删除buffer中的数据
-                    reveal_buffer.erase(vmsg.var_name);
+                    reveal_buffer.erase(var_name);
                     // 将重构后的值存入
                     this->setVar(reveal_name, reveal);
                 }
             }
-            this->sendOK(message.from);
+            this->sendOK(message.from, message.request_id);
         } catch (const std::bad_any_cast& e) {
             warning("Bad any cast in handleMessage(), command is REVEAL_INT: " + std::string(e.what()));
         }
     }
 
     else if (message.command == Command::RECEIVE_TABLE_SHARE) {
-        VarMessage vmsg(message_str);
+        TableMessageView tmsg(message, payload);
+        std::string var_name(tmsg.var_name);
         Table sst(Table::SHARE_PAIR_MODE);
-        sst.readFromString(vmsg.var_str);
-        this->setVar(vmsg.var_name, sst);
-        sendOK(message.from);
+        sst.readFromBinary(tmsg.table_bin);
+        this->setVar(var_name, std::move(sst));
+        sendOK(message.from, message.request_id);
     }
 
     else if (message.command == Command::REVEAL_TABLE) {
-        VarMessage vmsg(message_str);
-        std::string reveal_name = vmsg.var_name.substr(1, vmsg.var_name.length() - 2);
+        TableMessageView vmsg(message, payload);
+        std::string var_name(vmsg.var_name);
+        std::string reveal_name = var_name.substr(1, var_name.length() - 2);
         try {
-            Table t_received(Table::SHARE_PAIR_MODE);
-            t_received.readFromString(vmsg.var_str);
-            Table reveal_table(Table::INT_MODE);
-            reveal_table.headers = t_received.headers;
-            reveal_table.max_freqs = t_received.max_freqs;
-            for (int i = 0; i < reveal_table.headers.size(); i++) {
-                reveal_table.share_types.push_back(NO_SHARING);
-            }
-
-            if (var_store.count(vmsg.var_name) > 0) {
-                // 如果本身有一个mode为SharePair的Table
-                Table t = std::any_cast<Table>(this->getVar(vmsg.var_name));
-                for (int i = 0; i < t.data.size(); i++) {
-                    // 计算Data
-                    std::vector<std::any> reveal_row;
-                    for (int j = 0; j < t.headers.size(); j++) {
-                        SharePair sp = std::any_cast<SharePair>(t.data[i][j]);
-                        SharePair sp_received = std::any_cast<SharePair>(t_received.data[i][j]);
-                        ShareTuple st({sp[0], sp[1], sp_received[0]}, t.share_types[j]);
-                        reveal_row.push_back(st.compute());
-                    }
-                    reveal_table.data.push_back(reveal_row);
-
-                    // 计算isNull
-                    SharePair sp = std::any_cast<SharePair>(t.is_null[i]);
-                    SharePair sp_received = std::any_cast<SharePair>(t_received.is_null[i]);
-                    ShareTuple st({sp[0], sp[1], sp_received[0]}, BINARY_SHARING);
-                    reveal_table.is_null.push_back(st.compute());
+            // 发送方只发送其第一个分量x_i，以INT_MODE表的形式传递
+            Table received(Table::INT_MODE);
+            received.readFromBinary(vmsg.table_bin);
+
+            if (hasVar(var_name)) {
+                // 如果本身有一个mode为SharePair的Table，按列重构 x_i + x_{i+1} + x_{i-1}
+                // 只读访问本地份额，不触发写时复制，与其他变量共享的列缓冲区保持共享
+                const Table& t = std::any_cast<const Table&>(this->getVar(var_name));
+                if (received.columns.size() != t.columns.size() || received.size() != t.size() || received.is_null.size() != t.is_null.size()) {
+                    warning("Shape mismatch in handleMessage(), command is REVEAL_TABLE: received component of " + var_name +
+                            " does not match the local share");
+                    return;
                 }
+                Table reveal_table(Table::INT_MODE);
+                reveal_table.headers = t.headers;
+                reveal_table.max_freqs = t.max_freqs;
+                reveal_table.share_types.assign(t.headers.size(), NO_SHARING);
+                reveal_table.initColumns(t.size());
+                for (int j = 0; j < t.headers.size(); j++) {
+                    reconstructColumn(t.columns[j].cpart(0), t.columns[j].cpart(1), received.columns[j].cpart(0),
+                                      t.share_types[j], reveal_table.columns[j].part(0));
+                }
+                reveal_table.is_null = t.is_null.component(0);
+                reveal_table.is_null ^= t.is_null.component(1);
+                reveal_table.is_null ^= received.is_null;
                 // 将重构后的值存入
-                this->setVar(reveal_name, reveal_table);
+                this->setVar(reveal_name, std::move(reveal_table));
             } else {
-                // 如果本身没有要重构变量的SharePair，则使用reveal_buffer接受多份数据
-                std::unique_lock<std::mutex> lock(handle_mutex);
-                if (reveal_buffer.count(reveal_name) <= 0) {    // 如果buffer中没有则初始化一个
-                    reveal_buffer[reveal_name] = std::vector<Table>();
-                }
-                auto& ts = std::any_cast<std::vector<Table>&>(reveal_buffer[reveal_name]);
-                ts.push_back(t_received);
-                // 如果都以赋值
-                if (ts.size() == SHARE_PARTY_NUM) {
-                    for (int i = 0; i < t_received.data.size(); i++) {
-                        // 计算Data
-                        std::vector<std::any> reveal_row;
-                        for (int j = 0; j < t_received.headers.size(); j++) {
-                            SharePair sp0 = std::any_cast<SharePair>(ts[0].data[i][j]);
-                            SharePair sp1 = std::any_cast<SharePair>(ts[1].data[i][j]);
-                            SharePair sp2 = std::any_cast<SharePair>(ts[2].data[i][j]);
-                            ShareTuple st({sp0[0], sp1[0], sp2[0]}, t_received.share_types[j]);
-                            reveal_row.push_back(st.compute());
-                            //这里有问题
-                        }
-                        reveal_table.data.push_back(reveal_row);
-
-                        // 计算isNull
-                        SharePair sp0 = std::any_cast<SharePair>(ts[0].is_null[i]);
-                        SharePair sp1 = std::any_cast<SharePair>(ts[1].is_null[i]);
-                        SharePair sp2 = std::any_cast<SharePair>(ts[2].is_null[i]);
-                        ShareTuple st({sp0[0], sp1[0], sp2[0]}, BINARY_SHARING);
-                        reveal_table.is_null.push_back(st.compute());
+                // 如果本身没有要重构变量的SharePair，各方的分量到达后逐列合并，收齐三份后存为变量
+                auto it = partial_reveals.find(reveal_name);
+                if (it == partial_reveals.end()) {
+                    PartialTable partial{std::move(received), 1};
+                    it = partial_reveals.emplace(reveal_name, std::move(partial)).first;
+                } else {
+                    Table& acc = it->second.table;
+                    if (received.columns.size() != acc.columns.size() || received.size() != acc.size() || received.is_null.size() != acc.is_null.size()) {
+                        warning("Shape mismatch in handleMessage(), command is REVEAL_TABLE: components of " + reveal_name +
+                                " have different shapes");
+                        return;
+                    }
+                    for (size_t j = 0; j < acc.columns.size(); j++) {
+                        accumulateColumn(acc.columns[j].part(0), received.columns[j].cpart(0), acc.share_types[j]);
                     }
+                    acc.is_null ^= received.is_null;
+                    it->second.received++;
+                }
+                if (it->second.received == SHARE_PARTY_NUM) {
+                    Table& reveal_table = it->second.table;
+                    reveal_table.share_types.assign(reveal_table.headers.size(), NO_SHARING);
                     // 将重构后的值存入
-                    this->setVar(reveal_name, reveal_table);
-                    // 删除缓存中对应的内容
-                    this->reveal_buffer.erase(reveal_name);
+                    this->setVar(reveal_name, std::move(reveal_table));
+                    partial_reveals.erase(it);
                 }
             }
-            this->sendOK(message.from);
+            this->sendOK(message.from, message.request_id);
         } catch (const std::bad_any_cast& e) {
             warning("Bad any cast in handleMessage(), command is REVEAL_TABLE: " + std::string(e.what()));
         }
     } 
     
     else if (message.command == Command::RECEIVE_VEC_SHARE) {
-        VarMessage vmsg(message_str);
+        VarMessageView vmsg(message, payload);
+        std::string var_name(vmsg.var_name);
         std::vector<SharePair> sps = String2SPs(vmsg.var_str);
-        this->setVar(vmsg.var_name, sps);
-        this->sendOK(message.from);
+        this->setVar(var_name, sps);
+        this->sendOK(message.from, message.request_id);
     } 
     
     else if (message.command == Command::RECEIVE_VECS_SHARE) {
-        VarsMessage vsmsg(message_str);
+        VarsMessageView vsmsg(message, payload);
         for (const auto& var : vsmsg.vars) {
             std::vector<SharePair> sps = String2SPs(var.second);
-            this->setVar(var.first, sps);
+            this->setVar(std::string(var.first), sps);
         }
-        this->sendOK(vsmsg.from);
+        this->sendOK(vsmsg.from, message.request_id);
     }
 
     else if (message.command == Command::REVEAL_VEC) {
-        VarMessage vmsg(message_str);
-        std::string reveal_name = extractVarName(vmsg.var_name);
+        VarMessageView vmsg(message, payload);
+        std::string var_name(vmsg.var_name);
+        std::string reveal_name = extractVarName(var_name);
         try {
             std::vector<int> reveal;
-            if (var_store.count(vmsg.var_name) > 0) {
+            if (hasVar(var_name)) {
                 // 如果本身有要重构的变量的一份SharePair，那么Reveal协议只会让S_{i-1}把他的SharePair发过来，使用x_{i-1}即可
-                std::vector<SharePair> sps = std::any_cast<std::vector<SharePair>>(this->getVar(vmsg.var_name));
+                std::vector<SharePair> sps = std::any_cast<std::vector<SharePair>>(this->getVar(var_name));
                 auto sps_received = String2SPs(vmsg.var_str);
                 // 按共享类型重构
-                if (sps[0].type == ARITHMETIC_SHARING) {
-                    for (int i = 0; i < sps.size(); i++) {
-                        int res = (sps[i][0] + sps[i][1] + sps_received[i][0]) % MOD;
-                        reveal.push_back(res < 0 ? res + MOD : res);    //  确保落在[0,MOD)
-                    }
-                } else if (sps[0].type == BINARY_SHARING) {
-                    for (int i = 0; i < sps.size(); i++) {
-                        reveal.push_back(sps[i][0] ^ sps[i][1] ^ sps_received[i][0]);
-                    }
+                for (int i = 0; i < sps.size(); i++) {
+                    reveal.push_back(reconstructValue(sps[i][0], sps[i][1], sps_received[i][0], sps[0].type));
                 }
                 // 将重构后的值存入
                 this->setVar(reveal_name, reveal);
@@ -438,10 +491,10 @@ void Node::handleMessage(const Message& message, const std::string& message_str)
                 // 如果本身没有要重构变量的SharePair，则使用reveal_buffer接受多份数据
                 std::unique_lock<std::mutex> lock(handle_mutex);
                 auto sps = String2SPs(vmsg.var_str);
-                if (reveal_buffer.count(vmsg.var_name) <= 0) {
-                    reveal_buffer[vmsg.var_name] = std::vector<ShareTuple>(sps.size(), ShareTuple(sps[0].type));
+                if (reveal_buffer.count(var_name) <= 0) {
+                    reveal_buffer[var_name] = std::vector<ShareTuple>(sps.size(), ShareTuple(sps[0].type));
                 }
-                auto& sts = std::any_cast<std::vector<ShareTuple>&>(reveal_buffer[vmsg.var_name]);
+                auto& sts = std::any_cast<std::vector<ShareTuple>&>(reveal_buffer[var_name]);
                 for (int i = 0; i < sts.size(); i++) {
                     sts[i][vmsg.from] = sps[i][0];
                 }
@@ -450,11 +503,11 @@ void Node::handleMessage(const Message& message, const std::string& message_str)
                     for (int i = 0; i < sts.size(); i++) {
                         reveal.push_back(sts[i].compute());
                     }
-                    reveal_buffer.erase(vmsg.var_name);
+                    reveal_buffer.erase(var_name);
                     this->setVar(reveal_name, reveal);
                 }
             }
-            this->sendOK(message.from);
+            this->sendOK(message.from, message.request_id);
         } catch (const std::bad_any_cast& e) {
             warning("Bad any cast in handleMessage(), command is REVEAL_VEC: " + std::string(e.what()));
         }
@@ -462,108 +515,113 @@ void Node::handleMessage(const Message& message, const std::string& message_str)
 
     else if (message.command == Command::RECEIVE_AND_SHARE) {
         log("Do Command::RECEIVE_AND_SHARE");
-        VarMessage vmsg(message_str);
-        auto zi = std::any_cast<int>(this->getVar(vmsg.var_name + "_i"));
-        auto zip1 = std::stoi(vmsg.var_str);
-        this->setVar(vmsg.var_name, SharePair({zi, zip1}, BINARY_SHARING));
-        this->deleteVar(vmsg.var_name + "_i");
+        VarMessageView vmsg(message, payload);
+        std::string var_name(vmsg.var_name);
+        auto zi = std::any_cast<int>(this->getVar(var_name + "_i"));
+        auto zip1 = std::stoi(std::string(vmsg.var_str));
+        this->setVar(var_name, SharePair({zi, zip1}, BINARY_SHARING));
+        this->deleteVar(var_name + "_i");
         log("Finish Command::RECEIVE_AND_SHARE");
-        sendOK(message.from);
+        sendOK(message.from, message.request_id);
+    }
+
+    else if (message.command == Command::RECEIVE_AND_TABLE_SHARE) {
+        // 收到S_{i+1}的z_{i+1}，与本地的z_i组成{z_i, z_{i+1}}
+        TableMessageView tmsg(message, payload);
+        std::string var_name(tmsg.var_name);
+        Table zip1(Table::INT_MODE);
+        zip1.readFromBinary(tmsg.table_bin);
+        auto& zi = this->getVar<Table>(var_name + "_i");
+        if (zi.columns.size() != zip1.columns.size() || zi.size() != zip1.size()) {
+            warning("Shape mismatch in handleMessage(), command is RECEIVE_AND_TABLE_SHARE: z_{i+1} of " + var_name +
+                    " does not match the local z_i");
+            return;
+        }
+        Table z(Table::SHARE_PAIR_MODE);
+        z.headers = zi.headers;
+        z.share_types.assign(zi.columns.size(), BINARY_SHARING);
+        z.is_null.clear();
+        z.columns.resize(zi.columns.size());
+        for (size_t j = 0; j < zi.columns.size(); j++) {
+            z.columns[j].sharePart(0, zi.columns[j], 0);
+            z.columns[j].sharePart(1, zip1.columns[j], 0);
+        }
+        this->deleteVar(var_name + "_i");
+        this->setVar(var_name, std::move(z));
+        sendOK(message.from, message.request_id);
     }
-}
 
-// std::any& Node::getVar(std::string var_name) {
-//     // 确保该变量已经在var_store中保存
-//     while (var_store.find(var_name) == var_store.end()) {}
-//     return var_store[var_name];
-// }
+    else if (message.command == Command::RECEIVE_AND_VEC_SHARE) {
+        // 向量版本：var_str为z_{i+1}的int32数组
+        VarMessageView vmsg(message, payload);
+        std::string var_name(vmsg.var_name);
+        auto& zi = this->getVar<std::vector<int>>(var_name + "_i");
+        if (vmsg.var_str.size() != zi.size() * sizeof(int32_t)) {
+            warning("Size mismatch in handleMessage(), command is RECEIVE_AND_VEC_SHARE: z_{i+1} of " + var_name +
+                    " does not match the local z_i");
+            return;
+        }
+        std::vector<int> zip1(zi.size());
+        BufferReader reader(vmsg.var_str);
+        reader.readInts(zip1.data(), zip1.size());
+        std::vector<SharePair> z(zi.size());
+        for (size_t k = 0; k < zi.size(); k++) {
+            z[k] = SharePair({zi[k], zip1[k]}, BINARY_SHARING);
+        }
+        this->deleteVar(var_name + "_i");
+        this->setVar(var_name, std::move(z));
+        sendOK(message.from, message.request_id);
+    }
+}
 
 std::any& Node::getVar(std::string var_name) {
-    std::unique_lock<std::mutex> lock(var_mutex);
-    // 等待直到 var_store 中存在 var_name
-    var_cv.wait(lock, [&](){ return var_store.find(var_name) != var_store.end(); });
-
-    return var_store[var_name];
+    return getVar(SymbolTable::intern(var_name));
 }
 
-// void Node::setVar(std::string var_name, std::any value) {
-//     log("Saving " + var_name);
-//     if (value.type() == typeid(int) || value.type() == typeid(SharePair) || value.type() == typeid(Table) ||
-//         value.type() == typeid(std::vector<Index>) || value.type() == typeid(std::vector<SharePair>) ||
-//         value.type() == typeid(std::vector<int>)) {
-//         var_store[var_name] = value;
-//         // 如果是存入一个Table类型的变量，则自动创建该Table的索引容器
-//         if (value.type() == typeid(Table)) {
-//             // 用不带括号的变量名+“-idx”表示索引变量
-//             std::string table_idx_name = extractVarName(var_name) + "-idx";
-//             // 如果本没有该Table的索引变量
-//             if (var_store.find(table_idx_name) == var_store.end()) {
-//                 // 存储索引变量
-//                 var_store[table_idx_name] = std::vector<Index>();
-//             }
-//         }
-//     } else {
-//         error("Invalid argument in setVar(): wrong type");
-//         exit(EXIT_FAILURE);
-//     }
-// }
+std::any& Node::getVar(VarId var_id) {
+    // 变量尚未设置时只等待该变量
+    return var_store.get(var_id);
+}
 
 void Node::setVar(std::string var_name, std::any value) {
+    VarType type = varTypeOf(value);
+    storeVar(var_name, std::move(value), type);
+}
+
+void Node::storeVar(const std::string& var_name, std::any value, VarType type) {
     log("Saving " + var_name);
-    if (value.type() == typeid(int) || value.type() == typeid(SharePair) || value.type() == typeid(Table) ||
-        value.type() == typeid(std::vector<Index>) || value.type() == typeid(std::vector<SharePair>) ||
-        value.type() == typeid(std::vector<int>)) {
-        // 对var_store进行加锁，确保线程安全地修改变量
-        std::lock_guard<std::mutex> lock(var_mutex);
-        var_store[var_name] = value;
-        // 如果是存入一个Table类型的变量，则自动创建该Table的索引容器
-        if (value.type() == typeid(Table)) {
-            // 用不带括号的变量名+“-idx”表示索引变量
-            std::string table_idx_name = extractVarName(var_name) + "-idx";
-            // 如果本没有该Table的索引变量
-            if (var_store.find(table_idx_name) == var_store.end()) {
-                // 存储索引变量
-                var_store[table_idx_name] = std::vector<Index>();
-            }
-        }
-        // 通知所有可能在等待该变量的线程
-        var_cv.notify_all();
-        log("Finished setting variable: " + var_name);
-    } else {
+    if (type == VarType::NONE) {
         error("Invalid argument in setVar(): wrong type");
         exit(EXIT_FAILURE);
     }
+    var_store.set(SymbolTable::intern(var_name), std::move(value), type);
+    // 如果是存入一个Table类型的变量，则自动创建该Table的索引容器
+    if (type == VarType::TABLE) {
+        // 用不带括号的变量名+“-idx”表示索引变量，如果本没有该Table的索引变量则创建
+        var_store.setIfAbsent(SymbolTable::intern(extractVarName(var_name) + "-idx"), std::vector<Index>(), VarType::INDEX_VEC);
+    }
+    log("Finished setting variable: " + var_name);
 }
 
-// void Node::deleteVar(std::string var_name) {
-//     log("Deleting " + var_name);
-//     auto& value = getVar(var_name);
-//     // 如果是Table类型变量，则需要级联删除他的索引变量
-//     if (value.type() == typeid(Table)) {
-//         var_store.erase(extractVarName(var_name) + "-idx");
-//     }
-//     var_store.erase(var_name);
-//     log("Finish Delete " + var_name);
-// }
-
 void Node::deleteVar(std::string var_name) {
     log("Deleting " + var_name);
-    {
-        std::lock_guard<std::mutex> lock(var_mutex);
-        if (var_store.find(var_name) == var_store.end()) {
-            error("Variable " + var_name + " not found; skipping delete.");
-            return;
-        }
-        // 如果是Table类型变量，则需要级联删除他的索引变量
-        auto& value = var_store[var_name];
-        if (value.type() == typeid(Table)) {
-            var_store.erase(extractVarName(var_name) + "-idx");
-        }
-        var_store.erase(var_name);
+    VarId var_id = SymbolTable::intern(var_name);
+    // 如果是Table类型变量，则需要级联删除他的索引变量
+    bool is_table = var_store.type(var_id) == VarType::TABLE;
+    if (!var_store.erase(var_id)) {
+        error("Variable " + var_name + " not found; skipping delete.");
+        return;
+    }
+    if (is_table) {
+        var_store.erase(SymbolTable::intern(extractVarName(var_name) + "-idx"));
     }
     log("Finish Delete " + var_name);
 }
 
+void Node::renameTable(const std::string& src_name, const std::string& dst_name, const std::vector<std::string>& new_headers) {
+    this->setVar(dst_name, this->getVar<Table>(src_name).renamed(new_headers));
+}
+
 Index& Node::getTableIndex(std::string table_name, std::vector<std::string> attrs) {
     std::string table_idx_name = extractVarName(table_name) + "-idx";
     auto& index_arr = std::any_cast<std::vector<Index>&>(this->getVar(table_idx_name));
@@ -633,7 +691,7 @@ bool Node::checkTableIndex(std::string table_name, std::vector<std::string> attr
 
 void Node::printVars() {
     std::string var_list = "\nname\ttype\tvalue\n";
-    for (const auto& [key, value] : var_store) {
+    var_store.forEach([&](const std::string& key, const std::any& value) {
         var_list += key + "\t";
         try {
             if (value.type() == typeid(int)) {    // 如果是明文(int)
@@ -666,14 +724,14 @@ void Node::printVars() {
         } catch (const std::bad_any_cast& e) {
             warning("Bad any cast in printVars: " + std::string(e.what()));
         }
-    }
+    });
     log(var_list);
 }
 
 void Node::printVarsInFile() {
     log("Printing vars to file");
     std::string var_list = "\nname\ttype\tvalue\n";
-    for (const auto& [key, value] : var_store) {
+    var_store.forEach([&](const std::string& key, const std::any& value) {
         var_list += key + "\t";
         try {
             if (value.type() == typeid(int)) {    // 如果是明文(int)
@@ -706,7 +764,7 @@ void Node::printVarsInFile() {
         } catch (const std::bad_any_cast& e) {
             warning("Bad any cast in printVars: " + std::string(e.what()));
         }
-    }
+    });
     logInFile(var_list);
     log("Print vars to file successfully");
 }
@@ -738,40 +796,15 @@ void Node::shareInt(std::string var_name, u_int share_type, std::vector<Node*> o
     log("Sharing int " + var_name + " to " + std::accumulate(std::next(owners.begin()), owners.end(), owners[0]->name, [](const std::string &acc, Node* ptr) {
         return acc + ", " + ptr->name;
     }));
-    if (var_store[var_name].type() != typeid(int)) {
+    VarId var_id = SymbolTable::intern(var_name);
+    if (var_store.type(var_id) != VarType::INT) {
         error("Error sharing type in shareInt()");
         exit(EXIT_FAILURE);
     }
 
     try {
-        int secret = std::any_cast<int>(var_store[var_name]);
-
-        int s[3];
-        if (share_type == ARITHMETIC_SHARING) {
-            s[0] = std::rand() % MOD;
-            s[1] = std::rand() % MOD;
-            s[2] = (secret - s[0] - s[1]) % MOD;
-        }
-
-        else {
-            s[0] = std::rand() % MOD;
-            s[1] = std::rand() % MOD;
-            s[2] = (secret ^ s[0] ^ s[1]) % MOD;
-        }
-
-        for (u_int i = 0; i < SHARE_PARTY_NUM; i++) {
-            SharePair sp({s[i], s[(i + 1) % SHARE_PARTY_NUM]}, share_type);
-            if (owners[i]->id != id) { // 发送份额(s_i,s_{i+1})给S_i，此处的i为Server在owners中的索引
-                VarMessage message(id, owners[i]->id, Command::RECEIVE_INT_SHARE, "[" + var_name + "]", sp.toString());
-                sendMessage(owners[i], message);
-                wait(owners[i]->id);    // 等待回复标志
-            } else { // 保存自己的份额
-                var_store["[" + var_name + "]"] = sp;
-            }
-        }
-
-        // 等待所有Server收到并处理完消息
-        while (isWaiting()) {}  
+        int secret = std::any_cast<int>(var_store.get(var_id));
+        sendIntShares(var_name, secret, share_type, owners);
     } catch (const std::bad_any_cast& e) {
         warning("Bad any cast in shareInt(): " + std::string(e.what()));
     }
@@ -784,41 +817,126 @@ void Node::shareInt(std::string var_name, int secret, u_int share_type, std::vec
     log("Sharing int" + var_name + " to " + std::accumulate(std::next(owners.begin()), owners.end(), owners[0]->name, [](const std::string &acc, Node* ptr) {
         return acc + ", " + ptr->name;
     }));
+    sendIntShares(var_name, secret, share_type, owners);
+}
+
+void Node::sendIntShares(const std::string& var_name, int secret, u_int share_type, const std::vector<Node*>& owners) {
+    distributeSeeds(owners);
+
+    // x_0、x_1由种子展开，x_2为修正分量
+    uint64_t offset = reservePRG(1);
     int s[3];
+    dealer_prgs[0].fillShares(offset, &s[0], 1);
+    dealer_prgs[1].fillShares(offset, &s[1], 1);
     if (share_type == ARITHMETIC_SHARING) {
-        s[0] = std::rand() % MOD;
-        s[1] = std::rand() % MOD;
-        s[2] = (secret - s[0] - s[1]) % MOD;
+        s[2] = ringSub(ringSub(secret, s[0]), s[1]);
     } else {
-        s[0] = std::rand() % MOD;
-        s[1] = std::rand() % MOD;
-        s[2] = (secret ^ s[0] ^ s[1]) % MOD;
+        s[2] = secret ^ s[0] ^ s[1];
     }
 
+    std::vector<std::future<void>> responses;     // 各Server对份额消息的回复，发送完后统一等待
     for (u_int i = 0; i < SHARE_PARTY_NUM; i++) {
-        SharePair sp({s[i], s[(i + 1) % SHARE_PARTY_NUM]}, share_type);
-        if (owners[i]->id != id) {      // 发送份额(s_i,s_{i+1})给S_i，此处的i为Server在owners中的索引
-            VarMessage message(id, owners[i]->id, Command::RECEIVE_INT_SHARE, "[" + var_name + "]", sp.toString());
-            sendMessage(owners[i], message);
-            wait(owners[i]->id);    // 等待回复标志
+        if (owners[i]->id != id) {      // S_i持有(s_i,s_{i+1})，只有S_1、S_2需要收到s_2，此处的i为Server在owners中的索引
+            std::string data;
+            BufferWriter writer(data);
+            writer.writeU32(share_type);
+            if (i != 0) {
+                writer.writeU32(s[2]);
+            }
+            SeededShareMessage message(id, owners[i]->id, Command::RECEIVE_SEEDED_INT_SHARE, "[" + var_name + "]", i,
+                                       offset, 1, std::move(data));
+            responses.push_back(sendRequest(owners[i]->id, message));
         } else {  // 保存自己的份额
-            var_store["[" + var_name + "]"] = sp;
+            var_store.set(SymbolTable::intern("[" + var_name + "]"), SharePair({s[i], s[(i + 1) % SHARE_PARTY_NUM]}, share_type), VarType::SHARE_PAIR);
         }
     }
 
     // 等待所有Server收到并处理完消息
-    while (isWaiting()) {}  
+    waitResponses(Command::RECEIVE_SEEDED_INT_SHARE, responses);
+}
+
+void Node::distributeSeeds(const std::vector<Node*>& owners) {
+    // 种子按接收方缓存，只有owners[i]固定为S_i时，每个Server才只拿到它应持有的分量的种子；
+    // 否则同一个Server可能先后以不同的位置收到x_0和x_1的种子，再加上修正分量x_2即可重构秘密
+    if (owners.size() < SHARE_PARTY_NUM) {
+        throw std::runtime_error("Runtime Error in distributeSeeds(): Need " + std::to_string(SHARE_PARTY_NUM) + " owners");
+    }
+    for (u_int i = 0; i < SHARE_PARTY_NUM; i++) {
+        if (owners[i]->id != i) {
+            throw std::runtime_error("Runtime Error in distributeSeeds(): Owners must be S_0, S_1, S_2 in order, got node " +
+                                     std::to_string(owners[i]->id) + " at position " + std::to_string(i));
+        }
+    }
+    // 分量x_c由owners中的S_c和S_{c-1}持有
+    std::lock_guard<std::mutex> lock(seed_mutex);
+    std::vector<std::future<void>> responses;
+    for (u_int c = 0; c < 2; c++) {
+        for (u_int i : {c, (c + SHARE_PARTY_NUM - 1) % SHARE_PARTY_NUM}) {
+            u_int to_id = owners[i]->id;
+            if (to_id == id || seed_sent[to_id][c]) {
+                continue;
+            }
+            SeedMessage message(id, to_id, Command::RECEIVE_PRG_SEED, c, dealer_prgs[c].seed());
+            responses.push_back(sendRequest(to_id, message));
+            seed_sent[to_id][c] = true;
+        }
+    }
+    waitResponses(Command::RECEIVE_PRG_SEED, responses);
+}
+
+uint64_t Node::reservePRG(uint64_t words) {
+    // 按整块预留，使每次共享都从块边界开始展开
+    uint64_t blocks = (words + PRG::BLOCK_WORDS - 1) / PRG::BLOCK_WORDS;
+    return dealer_prg_offset.fetch_add(blocks * PRG::BLOCK_WORDS);
+}
+
+void Node::sendZeroSeed(u_int prev_id) {
+    std::lock_guard<std::mutex> lock(seed_mutex);
+    if (zero_seed_sent) {
+        return;
+    }
+    SeedMessage message(id, prev_id, Command::RECEIVE_PRG_SEED, ZERO_SEED_COMPONENT, zero_prg.seed());
+    sendMessageAndWait(prev_id, message);
+    zero_seed_sent = true;
+}
+
+void Node::fillZeroShares(u_int next_id, std::vector<int>& out) {
+    static_assert(sizeof(int) == sizeof(uint32_t), "int must be 32 bits");
+    // 两个PRG在相同位置展开，按整块预留
+    size_t n = out.size();
+    uint64_t blocks = (n + PRG::BLOCK_WORDS - 1) / PRG::BLOCK_WORDS;
+    uint64_t offset = zero_prg_offset.fetch_add(blocks * PRG::BLOCK_WORDS);
+    std::vector<uint32_t> next(n);
+    zero_prg.fill(offset, reinterpret_cast<uint32_t*>(out.data()), n);
+    getPeerPRG(next_id, ZERO_SEED_COMPONENT).fill(offset, next.data(), n);
+    for (size_t r = 0; r < n; r++) {
+        out[r] ^= static_cast<int>(next[r]);
+    }
+}
+
+const PRG& Node::getPeerPRG(u_int dealer_id, u_int component) {
+    auto it = peer_prgs.find({dealer_id, component});
+    if (it == peer_prgs.end()) {
+        throw std::runtime_error("Runtime Error in getPeerPRG(): No PRG seed from node " + std::to_string(dealer_id) +
+                                 " for component " + std::to_string(component));
+    }
+    return it->second;
 }
 
 void Node::revealIntTo(std::string var_name, Node *to) {
+    waitResponses(Command::REVEAL_INT, revealIntToAsync(var_name, to));
+}
+
+std::future<void> Node::revealIntToAsync(std::string var_name, Node *to) {
     log("Revealing int " + var_name + " to " + to->name);
     try {
         SharePair sp = std::any_cast<SharePair>(this->getVar(var_name));
         VarMessage vmsg(this->id, to->id, Command::REVEAL_INT, var_name, sp.toString());
-        this->sendMessageAndWait(to->id, vmsg);
+        return this->sendRequest(to->id, vmsg);
     } catch (const std::bad_any_cast& e) {
         warning("Bad any cast in revealIntTo(): " + std::string(e.what()));
     }
+    return readyFuture();
 }
 
 void Node::shareTable(std::string table_name, Table& t, std::vector<u_int> share_types, std::vector<Node*> owners) {
@@ -836,57 +954,122 @@ void Node::shareTable(std::string table_name, Table& t, std::vector<u_int> share
             exit(EXIT_FAILURE);
         }
         
-        // 为表t生成ShareTuple版本
-        Table st(Table::SHARE_TUPLE_MODE);
-        st.headers = t.headers;
-        st.share_types = share_types;
-        st.max_freqs = t.max_freqs;
-        for (int i = 0; i < t.data.size(); i++) {
-            // 生成Data的ShareTuple
-            std::vector<std::any> share_row;
-            for (int j = 0; j < t.data[i].size(); j++) {
-                int value = std::any_cast<int>(t.data[i][j]); 
-                share_row.push_back(ShareTuple(value, share_types[j]));
+        distributeSeeds(owners);
+
+        // 按行分块流水线共享：每块各自预留密钥流，算出修正分量后立即发给各方，再处理下一块，最多SHARE_INFLIGHT_BLOCKS块尚未被确认
+        // 分量x_0、x_1由种子展开，只需计算修正分量x_2 = v - x_0 - x_1（或v ^ x_0 ^ x_1），块内第j列使用密钥流的offset + j * block_rows处，
+        // is_null按位压缩，使用其后的2 * wordCount(block_rows)个字
+        size_t rows = t.size();
+        size_t column_num = t.headers.size();
+        Table header(Table::INT_MODE);
+        header.headers = t.headers;
+        header.share_types = share_types;
+        header.max_freqs = t.max_freqs;
+        header.initColumns(0);
+        std::string header_bin = serializeTable(Command::RECEIVE_SEEDED_TABLE_SHARE, header);
+        // 分发者本身也是owner时，按块拼出自己的SharePair表
+        int local_idx = -1;
+        for (u_int i = 0; i < SHARE_PARTY_NUM; i++) {
+            if (owners[i]->id == id) {
+                local_idx = i;
             }
-            st.data.push_back(share_row);
-            // 生成isNull的ShareTuple
-            int value = std::any_cast<int>(t.is_null[i]);
-            st.is_null.push_back(ShareTuple(value, BINARY_SHARING));
         }
-
-        // 从ShareTuple的表st中提取发给各方的SharePair版本
-        for (u_int i = 0; i < 3; i++) {
-            Table sst(Table::SHARE_PAIR_MODE);
+        Table sst(Table::SHARE_PAIR_MODE);
+        if (local_idx >= 0) {
             sst.headers = t.headers;
             sst.share_types = share_types;
             sst.max_freqs = t.max_freqs;
-            for (int j = 0; j < st.data.size(); j++) {
-                // 共享Data
-                std::vector<std::any> ss_row;
-                for (int k = 0; k < st.data[j].size(); k++) {
-                    auto share_value = std::any_cast<ShareTuple>(st.data[j][k]);
-                    SharePair ss({share_value[i], share_value[(i + 1) % 3]}, share_types[k]);
-                    ss_row.push_back(ss);
-                }
-                sst.data.push_back(ss_row);
+            sst.initColumns(rows);
+        }
 
-                // 共享isNull
-                auto share_value = std::any_cast<ShareTuple>(st.is_null[j]);
-                SharePair ss({share_value[i], share_value[(i + 1) % 3]}, BINARY_SHARING);
-                sst.is_null.push_back(ss);
+        std::deque<std::vector<std::future<void>>> inflight;
+        size_t start = 0;
+        do {
+            size_t block_rows = std::min(SHARE_BLOCK_ROWS, rows - start);
+            uint64_t offset = reservePRG(column_num * block_rows + 2 * BitColumn::wordCount(block_rows));
+            Table correction(Table::INT_MODE);
+            correction.headers = t.headers;
+            correction.share_types = share_types;
+            correction.max_freqs = t.max_freqs;
+            correction.initColumns(block_rows);
+            // 各列互不相关，并行展开密钥流
+            #pragma omp parallel for schedule(static)
+            for (size_t j = 0; j < column_num; j++) {
+                const int* values = t.columns[j].cpart(0).data() + start;
+                auto& x2 = correction.columns[j].part(0);
+                std::vector<int> x0(block_rows), x1(block_rows);
+                dealer_prgs[0].fillShares(offset + j * block_rows, x0);
+                dealer_prgs[1].fillShares(offset + j * block_rows, x1);
+                if (share_types[j] == ARITHMETIC_SHARING) {
+                    for (size_t r = 0; r < block_rows; r++) {
+                        x2[r] = ringSub(ringSub(values[r], x0[r]), x1[r]);
+                    }
+                } else {
+                    for (size_t r = 0; r < block_rows; r++) {
+                        x2[r] = values[r] ^ x0[r] ^ x1[r];
+                    }
+                }
+                if (local_idx >= 0) {
+                    const std::vector<int>* x[SHARE_PARTY_NUM] = {&x0, &x1, &x2};
+                    for (u_int k = 0; k < 2; k++) {
+                        const auto& src = *x[(local_idx + k) % SHARE_PARTY_NUM];
+                        std::copy(src.begin(), src.end(), sst.columns[j].part(k).begin() + start);
+                    }
+                }
+            }
+            // is_null按字计算x_2 = v ^ x_0 ^ x_1，块的起点是整字，直接复制对应的压缩字
+            BitColumn null_shares(SHARE_PARTY_NUM, block_rows);
+            fillBits(dealer_prgs[0], offset + column_num * block_rows, null_shares, 0);
+            fillBits(dealer_prgs[1], offset + column_num * block_rows, null_shares, 1);
+            auto& n2 = null_shares.words(2);
+            if (t.is_null.size() == rows) {
+                auto first = t.is_null.cwords(0).begin() + start / BitColumn::WORD_BITS;
+                std::copy(first, first + n2.size(), n2.begin());
+            }
+            const auto& n0 = null_shares.cwords(0);
+            const auto& n1 = null_shares.cwords(1);
+            for (size_t w = 0; w < n2.size(); w++) {
+                n2[w] ^= n0[w] ^ n1[w];
+            }
+            correction.is_null.sharePart(0, null_shares, 2);
+            if (local_idx >= 0) {
+                BitColumn local(2, block_rows);
+                local.sharePart(0, null_shares, local_idx);
+                local.sharePart(1, null_shares, (local_idx + 1) % SHARE_PARTY_NUM);
+                sst.is_null.assign(start, local);
             }
 
-            if (owners[i]->id != this->id) {
-                VarMessage message(this->id, owners[i]->id, Command::RECEIVE_TABLE_SHARE, "[" + table_name + "]", sst.toString());
-                sendMessage(owners[i]->id, message);
-                wait(owners[i]->id);
-            } else {
-                var_store["[" + table_name + "]"] = sst;
+            // 块数据前是块的起始行和总行数；S_i 持有分量 {x_i, x_{i+1}}，S_0不持有x_2，只需收到表头
+            std::string prefix;
+            BufferWriter writer(prefix);
+            writer.writeU64(start);
+            writer.writeU64(rows);
+            std::string correction_bin = prefix + serializeTable(Command::RECEIVE_SEEDED_TABLE_SHARE, correction);
+            std::vector<std::future<void>> responses;
+            for (u_int i = 0; i < SHARE_PARTY_NUM; i++) {
+                if (owners[i]->id != this->id) {
+                    SeededShareMessage message(this->id, owners[i]->id, Command::RECEIVE_SEEDED_TABLE_SHARE, "[" + table_name + "]", i,
+                                               offset, block_rows, i == 0 ? prefix + header_bin : correction_bin);
+                    responses.push_back(sendRequest(owners[i]->id, message));
+                }
             }
+            inflight.push_back(std::move(responses));
+            // 限制未确认的块数，发送端内存有界
+            if (inflight.size() > SHARE_INFLIGHT_BLOCKS) {
+                waitResponses(Command::RECEIVE_SEEDED_TABLE_SHARE, inflight.front());
+                inflight.pop_front();
+            }
+            start += block_rows;
+        } while (start < rows);
+
+        if (local_idx >= 0) {
+            var_store.set(SymbolTable::intern("[" + table_name + "]"), std::move(sst), VarType::TABLE);
         }
 
         // 等待所有Server收到并处理完消息
-        while (isWaiting()) {}
+        for (auto& responses : inflight) {
+            waitResponses(Command::RECEIVE_SEEDED_TABLE_SHARE, responses);
+        }
     } catch (const std::bad_any_cast& e) {
         warning("Bad any cast in shareTable(): " + std::string(e.what()));
     }
@@ -894,8 +1077,12 @@ void Node::shareTable(std::string table_name, Table& t, std::vector<u_int> share
 
 void Node::shareTable(std::string table_name, std::vector<u_int> share_types, std::vector<Node*> owners) {
     try {
-        Table& t = std::any_cast<Table&>(var_store[table_name]);
-        shareTable(table_name, t, share_types, owners);
+        // 不等待，表不存在或类型不符时与any_cast失败同样处理
+        Table* t = std::any_cast<Table>(var_store.find(SymbolTable::intern(table_name)));
+        if (t == nullptr) {
+            throw std::bad_any_cast();
+        }
+        shareTable(table_name, *t, share_types, owners);
     } catch (const std::bad_any_cast& e) {
         warning("Bad any cast in shareTable(): " + std::string(e.what()));
     }
@@ -903,34 +1090,56 @@ void Node::shareTable(std::string table_name, std::vector<u_int> share_types, st
 
 void Node::shareTable(std::string table_name, u_int share_type, std::vector<Node*> owners) {
     try {
-        Table& t = std::any_cast<Table&>(var_store[table_name]);
-        shareTable(table_name, t, std::vector<u_int>(t.headers.size(), share_type), owners);
+        Table* t = std::any_cast<Table>(var_store.find(SymbolTable::intern(table_name)));
+        if (t == nullptr) {
+            throw std::bad_any_cast();
+        }
+        shareTable(table_name, *t, std::vector<u_int>(t->headers.size(), share_type), owners);
     } catch (const std::bad_any_cast& e) {
         warning("Bad any cast in shareTable(): " + std::string(e.what()));
     }
 }
 
 void Node::revealTableTo(std::string table_name, Node *to) {
+    waitResponses(Command::REVEAL_TABLE, revealTableToAsync(table_name, to));
+}
+
+std::future<void> Node::revealTableToAsync(std::string table_name, Node *to) {
     log("Revealing table " + table_name + " to " + to->name);
     try{
-        // 发送表
-        Table t = std::any_cast<Table>(this->getVar(table_name));
-        VarMessage vmsg_table(this->id, to->id, Command::REVEAL_TABLE, table_name, t.toString());
-        this->sendMessageAndWait(to->id, vmsg_table);
+        // 接收方只用到本方的第一个分量x_i，只发送这一个分量，与原表共享列缓冲区
+        const Table& t = std::any_cast<Table&>(this->getVar(table_name));
+        Table component(Table::INT_MODE);
+        component.headers = t.headers;
+        component.share_types = t.share_types;
+        component.max_freqs = t.max_freqs;
+        component.columns.resize(t.columns.size());
+        for (size_t j = 0; j < t.columns.size(); j++) {
+            component.columns[j].sharePart(0, t.columns[j], 0);
+        }
+        component.is_null = t.is_null.component(0);
+        TableMessage vmsg_table(this->id, to->id, Command::REVEAL_TABLE, table_name, serializeTable(Command::REVEAL_TABLE, component));
+        return this->sendRequest(to->id, vmsg_table);
     } catch (const std::bad_any_cast& e) {
         warning("Bad any cast in revealTableTo(): " + std::string(e.what()));
     }
+    return readyFuture();
 }
 
 void Node::revealVecTo(std::string vec_name, Node* to) {
+    waitResponses(Command::REVEAL_VEC, revealVecToAsync(vec_name, to));
+}
+
+std::future<void> Node::revealVecToAsync(std::string vec_name, Node* to) {
     log("Revealing vector " + vec_name + " to " + to->name);
     try {
         std::vector<SharePair> sps = std::any_cast<std::vector<SharePair>>(this->getVar(vec_name));
         VarMessage vmsg(this->id, to->id, Command::REVEAL_VEC, vec_name, SPs2String(sps));
-        this->sendMessageAndWait(to->id, vmsg);
+        return this->sendRequest(to->id, vmsg);
     } catch (const std::bad_any_cast& e) {
         warning("Bad any cast in revealVecTo(): " + std::string(e.what()));
     }
+    return readyFuture();
 }
 
 void Node::log(const std::string& log) const {
@@ -1007,25 +1216,32 @@ int Node::extractPort(const std::string &address) {
     return std::stoi(address.substr(pos + 1));
 }
 
-void Node::wait(u_int id) {
-    {
-        std::lock_guard<std::mutex> lock(wait_mutex);
-        wait_response[id] = true;
+std::string Command::name(u_int command) {
+    switch (command) {
+        case RESPONSE_OK: return "RESPONSE_OK";
+        case RECEIVE_INT_SHARE: return "RECEIVE_INT_SHARE";
+        case REVEAL_INT: return "REVEAL_INT";
+        case RECEIVE_TABLE_SHARE: return "RECEIVE_TABLE_SHARE";
+        case REVEAL_TABLE: return "REVEAL_TABLE";
+        case SORT_VECTOR: return "SORT_VECTOR";
+        case RECEIVE_VEC_SHARE: return "RECEIVE_VEC_SHARE";
+        case PERM_VECTOR: return "PERM_VECTOR";
+        case RECEIVE_VECS_SHARE: return "RECEIVE_VECS_SHARE";
+        case COMPARE_NEIGHBOR_EQ: return "COMPARE_NEIGHBOR_EQ";
+        case OR_VECTOR: return "OR_VECTOR";
+        case COMPARE_NEIGHBOR_GT: return "COMPARE_NEIGHBOR_GT";
+        case REVEAL_VEC: return "REVEAL_VEC";
+        case RECEIVE_AND_SHARE: return "RECEIVE_AND_SHARE";
+        case RECEIVE_PRG_SEED: return "RECEIVE_PRG_SEED";
+        case RECEIVE_SEEDED_INT_SHARE: return "RECEIVE_SEEDED_INT_SHARE";
+        case RECEIVE_SEEDED_TABLE_SHARE: return "RECEIVE_SEEDED_TABLE_SHARE";
+        case SORT_ROWS: return "SORT_ROWS";
+        case PERM_ROWS: return "PERM_ROWS";
+        case COMPARE_NEIGHBOR_EQ_ROWS: return "COMPARE_NEIGHBOR_EQ_ROWS";
+        case COMPARE_NEIGHBOR_GT_ROWS: return "COMPARE_NEIGHBOR_GT_ROWS";
+        case OR_ROWS: return "OR_ROWS";
+        case RECEIVE_AND_TABLE_SHARE: return "RECEIVE_AND_TABLE_SHARE";
+        case RECEIVE_AND_VEC_SHARE: return "RECEIVE_AND_VEC_SHARE";
+        default: return "COMMAND_" + std::to_string(command);
     }
 }
-
-void Node::waitOK(u_int id) {
-    {
-        std::lock_guard<std::mutex> lock(wait_mutex);
-        wait_response[id] = false;
-    }
-    wait_cv.notify_all();
-}
-
-bool Node::isWaiting() {
-    // 检查是不是所有项都是false，即都没有在等待回应
-    for (bool f : wait_response) {
-        if (f) return true;
-    }
-    return false;
-}
@@ -12,12 +12,21 @@
 #include <memory>
 #include <mutex>
 #include <condition_variable>
+#include <future>
+#include <atomic>
 #include <numeric>
+#include <map>
+#include <deque>
 
 #include "../Share/Share.h"
+#include "../Share/PRG.h"
 #include "../Table/Table.h"
 #include "../Message/Message.h"
 #include "../Statistic/Statistic.h"
+#include "Reactor.h"
+#include "Transport.h"
+#include "NetStats.h"
+#include "VarStore.h"
 
 class Node {
 public:
@@ -31,20 +40,50 @@ public:
 
     // tcp相关函数
     void startlistening();
-    static void connectToPeers(std::vector<Node*> nodes);
+    // 节点间两两建立连接，transport_type为TCP_TRANSPORT或IN_PROCESS_TRANSPORT
+    // profile不是理想网络时，在传输层之上模拟对应的时延、带宽和抖动
+    static void connectToPeers(std::vector<Node*> nodes, u_int transport_type = TCP_TRANSPORT,
+                               const NetworkProfile& profile = NetworkProfile());
     void stop();
     void sendMessage(Node* node, const Message &message);
-    void sendMessage(u_int to_id, const Message &message);
+    void sendMessage(u_int to_id, const Message &message, uint64_t request_id = 0);
+    // 以新的请求编号发送消息，返回的future在收到对方对该请求的RESPONSE_OK后就绪
+    std::future<void> sendRequest(u_int to_id, const Message &message);
     void sendMessageAndWait(u_int to_id, const Message &message);
-    void sendOK(u_int to_id);
-    void recvMessage(int sock);
-    virtual void handleMessage(const Message& message, const std::string& message_str);
+    // 等待一组请求的回复，等待时间计入command
+    void waitResponses(u_int command, std::vector<std::future<void>>& responses);
+    void waitResponses(u_int command, std::future<void> response);
+    // 将表编码为消息负载，编码时间计入command
+    std::string serializeTable(u_int command, const Table& table);
+    // 按命令统计的收发消息数、字节数、编码/处理/等待时间
+    NetStats net_stats;
+    // 回复request_id对应的请求，request_id为0表示单向消息，无需回复
+    void sendOK(u_int to_id, uint64_t request_id);
+    virtual void handleMessage(const Message& message, std::string_view payload);
     static int extractPort(const std::string &address);     // 辅助函数，提取地址中的port
 
     // 变量存取/检查/打印操作
     std::any& getVar(std::string var_name);
+    std::any& getVar(VarId var_id);
+    // 按类型取变量，类型不符时抛出异常
+    template <typename T>
+    T& getVar(const std::string& var_name) { return var_store.get<T>(SymbolTable::intern(var_name)); }
     void setVar(std::string var_name, std::any value);
+    // 已知类型的变量直接存入对应类型的槽，无需逐个比较typeid
+    template <StorableVar T>
+    void setVar(const std::string& var_name, T&& value) {
+        storeVar(var_name, std::any(std::forward<T>(value)), VarTypeOf<std::decay_t<T>>::value);
+    }
+    bool hasVar(const std::string& var_name) const { return var_store.contains(SymbolTable::intern(var_name)); }
     void deleteVar(std::string var_name);
+    // 将已存储的表src_name以new_headers为表头存为dst_name，两者共享列数据
+    void renameTable(const std::string& src_name, const std::string& dst_name, const std::vector<std::string>& new_headers);
+    // 变量存储的内存预算，超出后冷变量溢出到spill_dir下的文件，详见VarStore
+    void setMemoryBudget(uint64_t bytes, const std::string& spill_dir = "") { var_store.setMemoryBudget(bytes, spill_dir); }
+    void nextRound() { var_store.nextRound(); }
+    SpillStats spillStats() const { return var_store.spillStats(); }
+    // 接收消息时单帧负载长度的上限，超过时关闭对应连接，详见Reactor
+    void setMaxPayloadSize(uint64_t bytes) { reactor->setMaxPayloadSize(bytes); }
     Index& getTableIndex(std::string table_name, std::vector<std::string> attrs);
     void setTableIndex(std::string table_name, Index value);    // 设置表的索引变量
     void deleteTableIndex(std::string table_name, std::vector<std::string> attrs);    // 删除表对应attrs的索引
@@ -61,6 +100,7 @@ public:
     void shareInt(std::string var_name, int secret, u_int share_type, std::vector<Node*> owners);
     // 将int类型var的秘密共享对发送给to
     void revealIntTo(std::string var_name, Node *to);
+    std::future<void> revealIntToAsync(std::string var_name, Node *to);
     // 将未存储的Table以share_types共享给owners
     void shareTable(std::string table_name, Table& table, std::vector<u_int> share_types, std::vector<Node*> owners);
     // 将已存储的Table以share_types共享给owners
@@ -69,10 +109,16 @@ public:
     void shareTable(std::string table_name, u_int share_type, std::vector<Node*> owners);
     // 将Table的秘密共享对发送给to
     void revealTableTo(std::string table_name, Node *to);
+    std::future<void> revealTableToAsync(std::string table_name, Node *to);
     // 将已存储的Vector以share_type共享给owners
     void shareVec(std::string vec_name, u_int share_type, std::vector<Node*> owners);
     // 将Vector的秘密共享对发送给to
     void revealVecTo(std::string vec_name, Node* to);
+    std::future<void> revealVecToAsync(std::string vec_name, Node* to);
+    // 将零共享的种子发给S_{i-1}，会话内只发送一次
+    void sendZeroSeed(u_int prev_id);
+    // 生成out.size()个布尔零共享份额α_i，next_id为S_{i+1}
+    void fillZeroShares(u_int next_id, std::vector<int>& out);
 
     // 日志打印相关函数
     void log(const std::string& log) const;
@@ -94,22 +140,61 @@ protected:
     // tcp相关的变量
     int listen_sock;
     struct sockaddr_in listen_addr;
-    std::vector<int> socks;
-    
-    std::vector<std::thread> recv_threads;
+    // 发送消息帧的传输层，由connectToPeers设置
+    std::unique_ptr<Transport> transport;
+    // nodes之间相互建立TCP连接
+    static void connectTcpPeers(std::vector<Node*> nodes);
+
+    // 事件循环：复用所有接入的连接，完整的消息帧交由其处理线程池调用handleMessage
+    std::unique_ptr<Reactor> reactor;
     std::mutex handle_msg_mtx;      // 确保一次只处理一条消息，防止资源占用
 
     // 存储持有的变量
-    std::unordered_map<std::string, std::any> var_store;
+    VarStore var_store;
+    void storeVar(const std::string& var_name, std::any value, VarType type);
 
     // 临时存储需要reveal的变量ShareTuple
     std::unordered_map<std::string, std::any> reveal_buffer;
 
-    // 等待回应标识，确保Share出内容已被接受
-    bool wait_response[NODE_MAXIMUM_NUM] = {false};
-    void wait(u_int id);
-    void waitOK(u_int id);
-    bool isWaiting();
+    // 未完成的请求，按请求编号等待对方的RESPONSE_OK，确保Share出内容已被接受
+    std::atomic<uint64_t> next_request_id{1};
+    std::unordered_map<uint64_t, std::promise<void>> pending_requests;
+    std::mutex pending_mutex;
+    void completeRequest(uint64_t request_id);
+
+    // 基于PRG种子的秘密共享：分发者用dealer_prgs[c]展开分量x_c（c=0,1），只发送修正分量x_2
+    // 持有分量x_c的Server（owners中的S_c和S_{c-1}）在会话中首次收到共享前获得对应的种子
+    std::array<PRG, 2> dealer_prgs;
+    std::atomic<uint64_t> dealer_prg_offset{0};                 // 已用掉的密钥流位置，每次共享向后预留
+    bool seed_sent[NODE_MAXIMUM_NUM][2] = {};
+    std::mutex seed_mutex;
+    std::map<std::pair<u_int, u_int>, PRG> peer_prgs;           // (分发者id, 分量c) -> 分发者的PRG
+    // 确保owners中的各方都已持有所需的种子
+    void distributeSeeds(const std::vector<Node*>& owners);
+    // 为一次共享预留words个字的密钥流，返回起始位置
+    uint64_t reservePRG(uint64_t words);
+    const PRG& getPeerPRG(u_int dealer_id, u_int component);
+
+    // 三方零共享：S_i持有自己的zero_prg和S_{i+1}的zero_prg种子，α_i = F_{k_i} ⊕ F_{k_{i+1}}，三方的α_i异或为0
+    // 用于重随机化与门的结果；各Server按相同的次序生成，zero_prg_offset在各方保持一致
+    static const u_int ZERO_SEED_COMPONENT = 2;                 // RECEIVE_PRG_SEED中零共享种子的分量编号
+    PRG zero_prg;
+    std::atomic<uint64_t> zero_prg_offset{0};
+    bool zero_seed_sent = false;
+    // 分块共享表：每块的行数为64的倍数，使is_null的块按整字拼接；发送端最多SHARE_INFLIGHT_BLOCKS块尚未被确认
+    static constexpr size_t SHARE_BLOCK_ROWS = 1 << 16;
+    static constexpr size_t SHARE_INFLIGHT_BLOCKS = 4;
+    // 接收中的表，由handle_msg_mtx保护
+    struct PartialTable {
+        Table table{Table::SHARE_PAIR_MODE};
+        size_t received = 0;
+    };
+    // 分块共享的表：按块的起始行写入预先分配好的表，received为已收到的行数，收齐后存为变量
+    std::unordered_map<std::string, PartialTable> partial_tables;
+    // 各方分别发来一个分量的重构：分量到达后逐列合并到table，received为已收到的份数，收齐SHARE_PARTY_NUM份后存为变量
+    std::unordered_map<std::string, PartialTable> partial_reveals;
+    // 生成并发送int类型秘密的份额
+    void sendIntShares(const std::string& var_name, int secret, u_int share_type, const std::vector<Node*>& owners);
 
     // 打印控制位
     bool enable_log = false;
@@ -131,4 +216,18 @@ public:
     static const u_int COMPARE_NEIGHBOR_GT = 12;
     static const u_int REVEAL_VEC = 13;
     static const u_int RECEIVE_AND_SHARE = 14;
+    static const u_int RECEIVE_PRG_SEED = 15;
+    static const u_int RECEIVE_SEEDED_INT_SHARE = 16;
+    static const u_int RECEIVE_SEEDED_TABLE_SHARE = 17;
+    // 按行批量执行的指令：参数为表，每一行是一个待处理的向量，结果以表的形式共享回各方
+    static const u_int SORT_ROWS = 18;
+    static const u_int PERM_ROWS = 19;
+    static const u_int COMPARE_NEIGHBOR_EQ_ROWS = 20;
+    static const u_int COMPARE_NEIGHBOR_GT_ROWS = 21;
+    static const u_int OR_ROWS = 22;
+    static const u_int RECEIVE_AND_TABLE_SHARE = 23;
+    static const u_int RECEIVE_AND_VEC_SHARE = 24;
+
+    // 命令名，用于统计输出
+    static std::string name(u_int command);
 };
\ No newline at end of file
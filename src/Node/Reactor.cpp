@@ -0,0 +1,378 @@
+#include "Reactor.h"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+static void setNonBlocking(int sock) {
+    int flags = fcntl(sock, F_GETFL, 0);
+    if (flags >= 0) {
+        fcntl(sock, F_SETFL, flags | O_NONBLOCK);
+    }
+}
+
+std::string BufferPool::acquire(size_t size) {
+    std::string buffer;
+    if (size < MIN_POOLED_SIZE) {
+        buffer.resize(size);
+        return buffer;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!buffers.empty()) {
+            // 容量足够的最小缓冲区；都不够时取出最大的一个，让它扩容后代替原来的位置
+            size_t best = buffers.size();
+            size_t largest = 0;
+            for (size_t i = 0; i < buffers.size(); i++) {
+                size_t capacity = buffers[i].capacity();
+                if (capacity >= size && (best == buffers.size() || capacity < buffers[best].capacity())) {
+                    best = i;
+                }
+                if (capacity > buffers[largest].capacity()) {
+                    largest = i;
+                }
+            }
+            size_t pick = best < buffers.size() ? best : largest;
+            buffer = std::move(buffers[pick]);
+            buffers[pick] = std::move(buffers.back());
+            buffers.pop_back();
+            pooled_bytes -= buffer.capacity();
+        }
+    }
+
+    if (buffer.capacity() < size) {
+        // 旧内容无需保留，先清空再扩容，避免拷贝
+        buffer.clear();
+        buffer.reserve(size);
+    }
+    buffer.resize(size);
+    return buffer;
+}
+
+void BufferPool::release(std::string buffer) {
+    size_t capacity = buffer.capacity();
+    if (capacity < MIN_POOLED_SIZE) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mtx);
+    if (buffers.size() >= MAX_BUFFERS || pooled_bytes + capacity > MAX_POOLED_BYTES) {
+        return;
+    }
+    pooled_bytes += capacity;
+    buffers.push_back(std::move(buffer));
+}
+
+Reactor::Reactor(FrameHandler handler, size_t pool_size) : handler(std::move(handler)), pool_size(pool_size) {
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd < 0 || wakeup_fd < 0) {
+        throw std::runtime_error("Runtime Error in Reactor(): Error creating epoll/eventfd");
+    }
+
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = wakeup_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wakeup_fd, &ev);
+}
+
+Reactor::~Reactor() {
+    stop();
+    for (auto& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    close(epoll_fd);
+    close(wakeup_fd);
+}
+
+void Reactor::stop() {
+    stop_requested = true;
+    uint64_t one = 1;
+    ssize_t ret = write(wakeup_fd, &one, sizeof(one));
+    (void)ret;
+}
+
+void Reactor::run(int listen_sock) {
+    // 启动处理线程池
+    {
+        std::lock_guard<std::mutex> lock(ready_mtx);
+        stopping = false;
+    }
+    for (size_t i = 0; i < pool_size; i++) {
+        workers.emplace_back(&Reactor::workerLoop, this);
+    }
+
+    setNonBlocking(listen_sock);
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = listen_sock;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_sock, &ev);
+
+    const int MAX_EVENTS = 16;
+    struct epoll_event events[MAX_EVENTS];
+    bool running = true;
+    while (running) {
+        int n = epoll_wait(epoll_fd, events, MAX_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Error in Reactor::run(): epoll_wait failed" << std::endl;
+            break;
+        }
+
+        for (int i = 0; i < n; i++) {
+            int fd = events[i].data.fd;
+            if (fd == wakeup_fd) {
+                uint64_t value;
+                ssize_t ret = read(wakeup_fd, &value, sizeof(value));
+                (void)ret;
+                drainInbox();
+                running = !stop_requested;
+            } else if (fd == listen_sock) {
+                acceptConnections(listen_sock);
+            } else {
+                auto it = connections.find(fd);
+                if (it == connections.end()) {
+                    continue;
+                }
+                std::shared_ptr<Connection> conn = it->second;
+                if (!readConnection(conn)) {
+                    closeConnection(fd);
+                }
+            }
+        }
+    }
+
+    // 关闭所有连接，等待处理线程处理完已收到的帧后退出
+    while (!connections.empty()) {
+        closeConnection(connections.begin()->first);
+    }
+    local_connections.clear();
+    {
+        std::lock_guard<std::mutex> lock(ready_mtx);
+        stopping = true;
+    }
+    ready_cv.notify_all();
+    for (auto& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workers.clear();
+}
+
+void Reactor::acceptConnections(int listen_sock) {
+    while (true) {
+        int sock = accept(listen_sock, nullptr, nullptr);
+        if (sock < 0) {
+            // EAGAIN：暂无新连接；EBADF/EINVAL：监听套接字已被主动关闭
+            return;
+        }
+
+        setNonBlocking(sock);
+        int opt = 1;
+        setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+
+        auto conn = std::make_shared<Connection>();
+        conn->sock = sock;
+        conn->in_buffer.resize(READ_BUFFER_SIZE);
+        connections[sock] = conn;
+
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.fd = sock;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, sock, &ev);
+    }
+}
+
+bool Reactor::readConnection(const std::shared_ptr<Connection>& conn) {
+    while (true) {
+        ssize_t n;
+        if (conn->has_header && conn->payload_received < conn->header.payload_len) {
+            // 大负载的剩余部分直接读入负载缓冲区，避免再经过in_buffer拷贝
+            n = recv(conn->sock, conn->payload.data() + conn->payload_received,
+                     conn->header.payload_len - conn->payload_received, 0);
+            if (n > 0) {
+                conn->payload_received += n;
+                if (conn->payload_received == conn->header.payload_len) {
+                    completeFrame(conn);
+                }
+                continue;
+            }
+        } else {
+            // 整理in_buffer，为新数据腾出空间
+            if (conn->in_begin == conn->in_end) {
+                conn->in_begin = conn->in_end = 0;
+            } else if (conn->in_end == conn->in_buffer.size()) {
+                std::memmove(conn->in_buffer.data(), conn->in_buffer.data() + conn->in_begin, conn->in_end - conn->in_begin);
+                conn->in_end -= conn->in_begin;
+                conn->in_begin = 0;
+            }
+            n = recv(conn->sock, conn->in_buffer.data() + conn->in_end, conn->in_buffer.size() - conn->in_end, 0);
+            if (n > 0) {
+                conn->in_end += n;
+                if (!parseFrames(conn)) {
+                    return false;
+                }
+                continue;
+            }
+        }
+
+        if (n == 0) {
+            // 对端正常关闭连接
+            return false;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return true;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        return false;
+    }
+}
+
+bool Reactor::parseFrames(const std::shared_ptr<Connection>& conn) {
+    while (true) {
+        if (!conn->has_header) {
+            if (conn->in_end - conn->in_begin < FrameHeader::SIZE) {
+                return true;
+            }
+            conn->header = FrameHeader::decode(std::string_view(conn->in_buffer.data() + conn->in_begin, FrameHeader::SIZE));
+            conn->in_begin += FrameHeader::SIZE;
+            // 超过上限的帧不分配缓冲区，直接关闭连接
+            uint64_t limit = max_payload_size.load(std::memory_order_relaxed);
+            if (conn->header.payload_len > limit) {
+                std::cerr << "Error in Reactor::parseFrames(): Payload of " << conn->header.payload_len
+                          << " bytes exceeds the limit of " << limit << " bytes, closing connection" << std::endl;
+                return false;
+            }
+            conn->has_header = true;
+            conn->payload = conn->buffer_pool.acquire(conn->header.payload_len);
+            conn->payload_received = 0;
+        }
+
+        // 先取in_buffer中已有的负载部分
+        size_t n = std::min<size_t>(conn->header.payload_len - conn->payload_received, conn->in_end - conn->in_begin);
+        std::memcpy(conn->payload.data() + conn->payload_received, conn->in_buffer.data() + conn->in_begin, n);
+        conn->in_begin += n;
+        conn->payload_received += n;
+        if (conn->payload_received < conn->header.payload_len) {
+            return true;
+        }
+        completeFrame(conn);
+    }
+}
+
+void Reactor::completeFrame(const std::shared_ptr<Connection>& conn) {
+    conn->has_header = false;
+    Frame frame;
+    frame.header = conn->header;
+    frame.data = std::move(conn->payload);
+    conn->payload = std::string();
+    enqueueFrame(conn, std::move(frame));
+}
+
+void Reactor::enqueueFrame(const std::shared_ptr<Connection>& conn, Frame frame) {
+    bool schedule = false;
+    {
+        std::lock_guard<std::mutex> lock(conn->mtx);
+        conn->frames.push_back(std::move(frame));
+        if (!conn->scheduled) {
+            conn->scheduled = true;
+            schedule = true;
+        }
+    }
+
+    if (schedule) {
+        {
+            std::lock_guard<std::mutex> lock(ready_mtx);
+            ready_queue.push_back(conn);
+        }
+        ready_cv.notify_one();
+    }
+}
+
+void Reactor::post(u_int channel, std::string frame) {
+    inbox.push({channel, std::move(frame)});
+    // 只有队列由空变为非空时才需要唤醒事件线程，其余情况事件线程会在drainInbox中一并取走
+    if (inbox_size.fetch_add(1, std::memory_order_acq_rel) == 0) {
+        uint64_t one = 1;
+        ssize_t ret = write(wakeup_fd, &one, sizeof(one));
+        (void)ret;
+    }
+}
+
+void Reactor::drainInbox() {
+    size_t count = inbox_size.load(std::memory_order_acquire);
+    while (count > 0) {
+        for (size_t i = 0; i < count; i++) {
+            std::pair<u_int, std::string> item;
+            // 计数已增加说明结点已入队，生产者可能还未完成链接，短暂自旋等待
+            while (!inbox.pop(item)) {
+                std::this_thread::yield();
+            }
+
+            auto& conn = local_connections[item.first];
+            if (!conn) {
+                conn = std::make_shared<Connection>();
+                conn->sock = -1;
+            }
+            Frame frame;
+            frame.header = FrameHeader::decode(std::string_view(item.second.data(), FrameHeader::SIZE));
+            frame.data = std::move(item.second);
+            frame.payload_offset = FrameHeader::SIZE;
+            enqueueFrame(conn, std::move(frame));
+        }
+        // 减去已取出的帧数，若期间又有新的投递则继续取
+        count = inbox_size.fetch_sub(count, std::memory_order_acq_rel) - count;
+    }
+}
+
+void Reactor::closeConnection(int sock) {
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, sock, nullptr);
+    close(sock);
+    connections.erase(sock);
+}
+
+void Reactor::workerLoop() {
+    while (true) {
+        std::shared_ptr<Connection> conn;
+        {
+            std::unique_lock<std::mutex> lock(ready_mtx);
+            ready_cv.wait(lock, [this] { return stopping || !ready_queue.empty(); });
+            if (ready_queue.empty()) {
+                return;
+            }
+            conn = std::move(ready_queue.front());
+            ready_queue.pop_front();
+        }
+
+        // 同一连接同一时刻只会被一个处理线程持有，按到达顺序逐帧处理
+        while (true) {
+            Frame frame;
+            {
+                std::lock_guard<std::mutex> lock(conn->mtx);
+                if (conn->frames.empty()) {
+                    conn->scheduled = false;
+                    break;
+                }
+                frame = std::move(conn->frames.front());
+                conn->frames.pop_front();
+            }
+            handler(frame.header, std::string_view(frame.data).substr(frame.payload_offset));
+            // TCP连接上收到的负载缓冲区留给该连接后续的帧；进程内投递的帧缓冲区来自发送方，直接释放
+            if (conn->sock >= 0) {
+                conn->buffer_pool.release(std::move(frame.data));
+            }
+        }
+    }
+}
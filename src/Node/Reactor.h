@@ -0,0 +1,123 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+#include "../Message/Message.h"
+#include "MpscQueue.h"
+
+// 接收缓冲区池，按连接复用负载缓冲区
+// 缓冲区归还时保留原有内容和长度，再次取出时resize到更小的长度不会触碰数据，避免大负载反复分配、缺页和清零
+class BufferPool {
+public:
+    static const size_t MIN_POOLED_SIZE = 64 * 1024;        // 小于此长度的缓冲区直接分配，不经过池
+    static const size_t MAX_BUFFERS = 4;                    // 最多缓存的缓冲区个数
+    static const size_t MAX_POOLED_BYTES = 1ULL << 31;      // 缓存的缓冲区容量之和的上限
+
+    // 取出一个长度为size的缓冲区，优先使用容量足够的最小缓冲区，内容未定义
+    std::string acquire(size_t size);
+    // 归还缓冲区，超出上限时直接释放
+    void release(std::string buffer);
+
+private:
+    std::mutex mtx;
+    std::vector<std::string> buffers;
+    size_t pooled_bytes = 0;
+};
+
+// 基于epoll的事件循环，每个Node一个
+// 由一个事件线程复用监听套接字和所有接入的连接，以非阻塞方式把数据读入各连接自己的缓冲区，
+// 拼出完整的消息帧后交给一个小的处理线程池；同一连接上的帧按到达顺序、串行地交给处理函数
+// 同进程内的节点可通过post()直接投递完整的帧，按来源channel区分，与TCP连接一样保证顺序
+class Reactor {
+public:
+    using FrameHandler = std::function<void(const FrameHeader& header, std::string_view payload)>;
+
+    static const size_t DEFAULT_POOL_SIZE = 2;
+    // 单帧负载长度的默认上限，应不小于可能传输的最大的表的编码长度
+    static const uint64_t DEFAULT_MAX_PAYLOAD_SIZE = 1ULL << 32;
+
+    Reactor(FrameHandler handler, size_t pool_size = DEFAULT_POOL_SIZE);
+    ~Reactor();
+
+    // 事件循环，接受listen_sock上的新连接并读取已有连接，直到stop()被调用后返回
+    void run(int listen_sock);
+    // 通知事件循环退出，可在任意线程调用，可重复调用
+    void stop();
+    // 进程内投递一条完整的帧（帧头+负载），frame的所有权转移给Reactor，可在任意线程调用
+    // 只有在事件线程可能空闲时才会写eventfd唤醒它
+    void post(u_int channel, std::string frame);
+    // 设置TCP连接上单帧负载长度的上限，帧头声明的长度超过上限时关闭该连接，可在任意线程调用
+    void setMaxPayloadSize(uint64_t bytes) { max_payload_size.store(bytes, std::memory_order_relaxed); }
+
+private:
+    // 一条待处理的帧，负载为data[payload_offset:]
+    struct Frame {
+        FrameHeader header;
+        std::string data;
+        size_t payload_offset = 0;
+    };
+
+    // 一条接入的连接（或一个进程内的投递来源）
+    struct Connection {
+        int sock;
+        std::string in_buffer;          // 非阻塞读入的原始字节
+        size_t in_begin = 0;            // in_buffer中尚未解析的起始位置
+        size_t in_end = 0;              // in_buffer中已读入数据的结束位置
+        bool has_header = false;        // 当前帧的帧头是否已解析
+        FrameHeader header;
+        std::string payload;            // 当前帧的负载，按帧头中的长度从buffer_pool取出，较大的负载直接recv到这里
+        size_t payload_received = 0;
+        BufferPool buffer_pool;         // 处理完的帧的负载缓冲区归还到这里，供后续的帧复用
+
+        std::mutex mtx;                 // 保护以下两个成员
+        std::deque<Frame> frames;       // 已完整接收、等待处理的帧
+        bool scheduled = false;         // 是否已在处理队列中（或正在被某个处理线程处理）
+    };
+
+    static const size_t READ_BUFFER_SIZE = 64 * 1024;
+
+    FrameHandler handler;
+    size_t pool_size;
+    int epoll_fd = -1;
+    int wakeup_fd = -1;                 // eventfd，用于唤醒阻塞中的epoll_wait
+
+    std::unordered_map<int, std::shared_ptr<Connection>> connections;
+    std::atomic<bool> stop_requested{false};
+    std::atomic<uint64_t> max_payload_size{DEFAULT_MAX_PAYLOAD_SIZE};
+
+    // 进程内投递的帧，inbox_size为已投递但尚未被事件线程取出的帧数
+    MpscQueue<std::pair<u_int, std::string>> inbox;
+    std::atomic<size_t> inbox_size{0};
+    std::unordered_map<u_int, std::shared_ptr<Connection>> local_connections;
+
+    // 处理线程池
+    std::vector<std::thread> workers;
+    std::deque<std::shared_ptr<Connection>> ready_queue;
+    std::mutex ready_mtx;
+    std::condition_variable ready_cv;
+    bool stopping = false;
+
+    void acceptConnections(int listen_sock);
+    // 读取连接上所有可读的数据，返回false表示连接应被关闭
+    bool readConnection(const std::shared_ptr<Connection>& conn);
+    // 从in_buffer中解析出完整的帧，未读完的大负载留待readConnection直接读取
+    bool parseFrames(const std::shared_ptr<Connection>& conn);
+    // 当前帧接收完毕，放入连接的帧队列
+    void completeFrame(const std::shared_ptr<Connection>& conn);
+    // 把帧放入连接的帧队列，并在需要时把连接交给处理线程池
+    void enqueueFrame(const std::shared_ptr<Connection>& conn, Frame frame);
+    // 取出所有进程内投递的帧
+    void drainInbox();
+    void closeConnection(int sock);
+    void workerLoop();
+};
@@ -1,12 +1,12 @@
 #include "Server.h"
 
-void Server::handleMessage(const Message& message, const std::string& message_str) {
+void Server::handleMessage(const Message& message, std::string_view payload) {
     if (message.command == 100) { 
         
     } 
 
     else {  // 自动调用Node的handleMessage函数
-        Node::handleMessage(message, message_str);
+        Node::handleMessage(message, payload);
     }
 }
 
@@ -26,10 +26,8 @@ void Server::join(std::string table1_name, std::string table2_name, std::string
     Table& table1 = std::any_cast<Table&>(this->getVar(table1_name));
     Table& table2 = std::any_cast<Table&>(this->getVar(table2_name));
     std::vector<std::string> join_key = getJoinKey(table1, table2);
-    auto key_columns = table1.select(join_key);
-    auto kc2 = table2.select(join_key);
-    key_columns.reserve(key_columns.size() + kc2.size());
-    key_columns.insert(key_columns.end(), kc2.begin(), kc2.end());
+    Table key_columns = table1.select(join_key);
+    key_columns.concate(table2.select(join_key));
 
     // [N] := isNull([X]) // isNull([Y])
     
@@ -39,6 +37,6 @@ void Server::concateTable(std::string table1_name, std::string table2_name, std:
     auto& table1 = std::any_cast<Table&>(this->getVar(table1_name));
     auto& table2 = std::any_cast<Table&>(this->getVar(table2_name));
     Table result(table1);
-    result.data.insert(result.data.end(), table2.data.begin(), table2.data.end());
+    result.concate(table2);
     setVar(result_name, result);
 }
\ No newline at end of file
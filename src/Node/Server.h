@@ -8,7 +8,7 @@ public:
     Server(u_int id, const std::string& name) : Node(id, name) {}
 
     // 复写handleMessage函数
-    void handleMessage(const Message& message, const std::string& message_str);
+    void handleMessage(const Message& message, std::string_view payload);
 
     // 复写，增加Server*对象的传参，将已存储的Table，所有列都以share_type共享给owners
     void shareTable(std::string table_name, u_int share_type, std::vector<Server*> servers);
@@ -2,15 +2,51 @@
 #include <unordered_set> 
 #include <algorithm>
 
-void ThirdParty::handleMessage(const Message& message, const std::string& message_str) {
+// 由三方的SharePair向量按列重构明文，S_i持有{x_i, x_{i+1}}，取各方的第0个分量即得{x_0, x_1, x_2}
+static std::vector<int> revealSharePairs(const std::vector<SharePair>& s0, const std::vector<SharePair>& s1,
+                                         const std::vector<SharePair>& s2) {
+    size_t n = s0.size();
+    if (s1.size() != n || s2.size() != n) {
+        throw std::runtime_error("Runtime Error in revealSharePairs(): Inconsistent vector sizes among servers");
+    }
+    std::vector<int> x0(n), x1(n), x2(n), values;
+    for (size_t i = 0; i < n; i++) {
+        x0[i] = s0[i][0];
+        x1[i] = s1[i][0];
+        x2[i] = s2[i][0];
+    }
+    reconstructColumn(x0, x1, x2, n == 0 ? BINARY_SHARING : s0[0].type, values);
+    return values;
+}
+
+// 将明文向量整列拆分为ShareTuple数组
+static std::vector<ShareTuple> splitTuples(const std::vector<int>& values, u_int share_type) {
+    std::vector<int> x0, x1, x2;
+    splitColumn(values, share_type, x0, x1, x2);
+    std::vector<ShareTuple> sts;
+    sts.reserve(values.size());
+    for (size_t i = 0; i < values.size(); i++) {
+        sts.emplace_back(std::array<int, 3>{x0[i], x1[i], x2[i]}, share_type);
+    }
+    return sts;
+}
+
+void ThirdParty::handleMessage(const Message& message, std::string_view payload) {
+    // 回复只需唤醒对应的请求，不能排在持锁处理的指令之后
+    if (message.command == Command::RESPONSE_OK) {
+        completeRequest(message.request_id);
+        return;
+    }
+
     std::lock_guard<std::mutex> guard(thirdparty_handle_msg_mutx);
     if (message.command == Command::SORT_VECTOR) {
         // (SORT, [v])
-        VarMessage vmsg(message_str);
+        VarMessageView vmsg(message, payload);
         // 设置vmsg.from在缓存区中对应的变量和指令
         auto arg = String2SPs(vmsg.var_str);
         args_buffer[vmsg.from].push_back(arg);
         cmd_buffer[message.from] = Command::SORT_VECTOR;
+        request_buffer[message.from] = message.request_id;
 
         // 检查是否收集其各方的变量和指令
         if (checkCmd()) {
@@ -24,16 +60,16 @@ void ThirdParty::handleMessage(const Message& message, const std::string& messag
                 for (int j = 0; j < perm_sts.size(); j++) {
                     sps.push_back(SharePair({perm_sts[j][i], perm_sts[j][(i + 1) % servers.size()]}, perm_sts[j].type));
                 }
-                VarMessage back_vmsg(this->id, servers[i]->id, Command::RECEIVE_VEC_SHARE, vmsg.result_name, SPs2String(sps));
+                VarMessage back_vmsg(this->id, servers[i]->id, Command::RECEIVE_VEC_SHARE, std::string(vmsg.result_name), SPs2String(sps));
                 sendMessage(servers[i]->id, back_vmsg);
-                sendOK(servers[i]->id);
+                sendOK(servers[i]->id, request_buffer[i]);
             }
             clearBuffer();
             // log("Complete SORT_VECTOR");
         }
     } else if (message.command == Command::PERM_VECTOR) {
         // (PERM, [pi], {[v1], [v2], ...})
-        VarsMessage vsmsg(message_str);
+        VarsMessageView vsmsg(message, payload);
         // 设置vmsg.from在缓存区中对应的变量和指令
         // 提取perm
         auto perm = String2SPs(vsmsg.vars[0].second);
@@ -45,6 +81,7 @@ void ThirdParty::handleMessage(const Message& message, const std::string& messag
         }
         args_buffer[vsmsg.from].push_back(vecs);
         cmd_buffer[message.from] = Command::PERM_VECTOR;
+        request_buffer[message.from] = message.request_id;
 
         // 检查是否收集各方的变量和指令
         if (checkCmd()) {
@@ -60,23 +97,24 @@ void ThirdParty::handleMessage(const Message& message, const std::string& messag
                     for (const auto& st : permed_vecs_st[j]) {
                         sps.push_back(SharePair({st[i], st[(i + 1) % servers.size()]}, st.type));
                     }
-                    std::string var_name = "[" + extractVarName(vsmsg.vars[j + 1].first) + "']";
+                    std::string var_name = "[" + extractVarName(std::string(vsmsg.vars[j + 1].first)) + "']";
                     vars.push_back({var_name, SPs2String(sps)}); // vsmsg.vars[j]是perm，索引需要+1才是vecs的起始
                 }
-                VarsMessage back_vsmsg(this->id, servers[i]->id, Command::RECEIVE_VECS_SHARE, vars, vsmsg.result_name);
+                VarsMessage back_vsmsg(this->id, servers[i]->id, Command::RECEIVE_VECS_SHARE, vars, std::string(vsmsg.result_name));
                 sendMessage(servers[i]->id, back_vsmsg);
-                sendOK(servers[i]->id);
+                sendOK(servers[i]->id, request_buffer[i]);
             }
             clearBuffer();
             // log("Complete PERM_VECTOR");
         }
     } else if (message.command == Command::COMPARE_NEIGHBOR_EQ) {
         // (CPN_EQU, [v])
-        VarMessage vmsg(message_str);
+        VarMessageView vmsg(message, payload);
         // 设置vmsg.from在缓存区中对应的变量和指令
         auto arg = String2SPs(vmsg.var_str);
         args_buffer[vmsg.from].push_back(arg);
         cmd_buffer[vmsg.from] = Command::COMPARE_NEIGHBOR_EQ;
+        request_buffer[message.from] = message.request_id;
 
         // 检查是否收集齐各方的变量和指令
         if (checkCmd()) {
@@ -90,20 +128,21 @@ void ThirdParty::handleMessage(const Message& message, const std::string& messag
                 for (int j = 0; j < flags_st.size(); j++) {
                     sps.push_back(SharePair({flags_st[j][i], flags_st[j][(i + 1) % SHARE_PARTY_NUM]}, flags_st[j].type));
                 }
-                VarMessage back_vmsg(this->id, servers[i]->id, Command::RECEIVE_VEC_SHARE, vmsg.result_name, SPs2String(sps));
+                VarMessage back_vmsg(this->id, servers[i]->id, Command::RECEIVE_VEC_SHARE, std::string(vmsg.result_name), SPs2String(sps));
                 sendMessage(servers[i]->id, back_vmsg);
-                sendOK(servers[i]->id);
+                sendOK(servers[i]->id, request_buffer[i]);
             }
             clearBuffer();
             // log("Complete COMPARE_NEIGHBOR_EQ");
         }
     } else if (message.command == Command::COMPARE_NEIGHBOR_GT) {
         // (CPN_ASC, [v])
-        VarMessage vmsg(message_str);
+        VarMessageView vmsg(message, payload);
         // 设置vmsg.from在缓存区中对应的变量和指令
         auto arg = String2SPs(vmsg.var_str);
         args_buffer[vmsg.from].push_back(arg);
         cmd_buffer[vmsg.from] = Command::COMPARE_NEIGHBOR_GT;
+        request_buffer[message.from] = message.request_id;
 
         // 检查是否收集齐各方的变量和指令
         if (checkCmd()) {
@@ -117,20 +156,21 @@ void ThirdParty::handleMessage(const Message& message, const std::string& messag
                 for (int j = 0; j < flags_st.size(); j++) {
                     sps.push_back(SharePair({flags_st[j][i], flags_st[j][(i + 1) % SHARE_PARTY_NUM]}, flags_st[j].type));
                 }
-                VarMessage back_vmsg(this->id, servers[i]->id, Command::RECEIVE_VEC_SHARE, vmsg.result_name, SPs2String(sps));
+                VarMessage back_vmsg(this->id, servers[i]->id, Command::RECEIVE_VEC_SHARE, std::string(vmsg.result_name), SPs2String(sps));
                 sendMessage(servers[i]->id, back_vmsg);
-                sendOK(servers[i]->id);
+                sendOK(servers[i]->id, request_buffer[i]);
             }
             clearBuffer();
             // log("Complete COMPARE_NEIGHBOR_GT");
         }
     } else if (message.command == Command::OR_VECTOR) {
         // (ORV, [v])
-        VarMessage vmsg(message_str);
+        VarMessageView vmsg(message, payload);
         // 设置vmsg.from在缓存区中对应的变量和指令
         auto arg = String2SPs(vmsg.var_str);
         args_buffer[vmsg.from].push_back(arg);
         cmd_buffer[vmsg.from] = Command::OR_VECTOR;
+        request_buffer[message.from] = message.request_id;
 
         // 检查是否收集齐各方的变量和指令
         if (checkCmd()) {
@@ -141,16 +181,55 @@ void ThirdParty::handleMessage(const Message& message, const std::string& messag
             // 将结果共享给各方
             for (int i = 0; i < SHARE_PARTY_NUM; i++) {
                 SharePair sp({d_st[i], d_st[(i + 1) % SHARE_PARTY_NUM]}, d_st.type);
-                VarMessage back_vmsg(this->id, servers[i]->id, Command::RECEIVE_INT_SHARE, vmsg.result_name, sp.toString());
+                VarMessage back_vmsg(this->id, servers[i]->id, Command::RECEIVE_INT_SHARE, std::string(vmsg.result_name), sp.toString());
                 sendMessage(servers[i]->id, back_vmsg);
-                sendOK(servers[i]->id);
+                sendOK(servers[i]->id, request_buffer[i]);
             }
             clearBuffer();
             // log("Complete OR_VECTOR");
         }
     }
+    else if (message.command == Command::SORT_ROWS || message.command == Command::PERM_ROWS ||
+             message.command == Command::COMPARE_NEIGHBOR_EQ_ROWS || message.command == Command::COMPARE_NEIGHBOR_GT_ROWS ||
+             message.command == Command::OR_ROWS) {
+        // (CMD_ROWS, [M]) 或 (PERM_ROWS, [Pi], [M])，每个参数都是一张表，表的每一行是一个待处理的向量
+        std::string result_name;
+        if (message.command == Command::PERM_ROWS) {
+            VarsMessageView vsmsg(message, payload);
+            for (const auto& var : vsmsg.vars) {
+                Table arg(Table::SHARE_PAIR_MODE);
+                arg.readFromBinary(var.second);
+                args_buffer[message.from].push_back(std::move(arg));
+            }
+            result_name = vsmsg.result_name;
+        } else {
+            VarMessageView vmsg(message, payload);
+            Table arg(Table::SHARE_PAIR_MODE);
+            arg.readFromBinary(vmsg.var_str);
+            args_buffer[message.from].push_back(std::move(arg));
+            result_name = vmsg.result_name;
+        }
+        cmd_buffer[message.from] = message.command;
+        request_buffer[message.from] = message.request_id;
+
+        // 检查是否收集齐各方的变量和指令
+        if (checkCmd()) {
+            // 执行指令，结果为明文表，按列拆分后共享给各方
+            Table result = std::any_cast<Table>(executeCmd());
+            std::vector<std::vector<int>> values;
+            values.reserve(result.columns.size());
+            for (const auto& column : result.columns) {
+                values.push_back(column.cpart(0));
+            }
+            // 比较与析取的结果都是标志位
+            bool flags = message.command == Command::COMPARE_NEIGHBOR_EQ_ROWS || message.command == Command::COMPARE_NEIGHBOR_GT_ROWS ||
+                         message.command == Command::OR_ROWS;
+            shareRows(result_name, result.headers, result.share_types, values, flags);
+            clearBuffer();
+        }
+    }
     else {  // 自动调用Node的handleMessage函数
-        Node::handleMessage(message, message_str);
+        Node::handleMessage(message, payload);
     }
 }
 
@@ -190,31 +269,16 @@ std::any ThirdParty::executeCmd() {
         for (int i = 0; i < args_buffer.size(); i++) {
             multi_server_sps.push_back(std::any_cast<std::vector<SharePair>&>(args_buffer[i][0]));
         }
-        // 用各方SharePair的首个份额，构造ShareTuple向量
-        std::vector<ShareTuple> sts;
+        // 用各方SharePair的首个份额，按列重构明文下的vec
         u_int share_type = multi_server_sps[0][0].type;
-        sts.reserve(multi_server_sps[0].size());
-        for (int i = 0; i < multi_server_sps[0].size(); i++) {
-            sts.push_back(ShareTuple({multi_server_sps[0][i][0], multi_server_sps[1][i][0], multi_server_sps[2][i][0]}, share_type));
-        }
-        // 计算明文下的vec
-        std::vector<int> vec(sts.size());
-        for (int i = 0; i < sts.size(); i++) {
-            vec[i] = sts[i].compute();
-        }
+        std::vector<int> vec = revealSharePairs(multi_server_sps[0], multi_server_sps[1], multi_server_sps[2]);
         // 计算perm
         auto perm = Utils::getSortingPermutation(vec);
         // log("perm:");
         // printVec(perm);
 
-        // 将结果转为ShareTuple数组
-        std::vector<ShareTuple> perm_sts;
-        perm_sts.reserve(perm.size());
-        for (int i = 0; i < perm.size(); i++) {
-            perm_sts.push_back(ShareTuple(perm[i], share_type));
-        }
-
-        return perm_sts;
+        // 将结果整列拆分为ShareTuple数组
+        return splitTuples(perm, share_type);
     } else if (cmd == Command::PERM_VECTOR) {
         // 重构perm和vecs
         std::vector<std::vector<SharePair>> multi_server_perm;
@@ -223,44 +287,12 @@ std::any ThirdParty::executeCmd() {
             multi_server_perm.push_back(std::any_cast<std::vector<SharePair>&>(args_buffer[i][0]));
             multi_server_vecs.push_back(std::any_cast<std::vector<std::vector<SharePair>>&>(args_buffer[i][1]));
         }
-        size_t vec_size = multi_server_perm[0].size();  // perm和vecs中的向量长度都是相等的，用vec_size表示
-        std::vector<ShareTuple> perm_st;
-        std::vector<std::vector<ShareTuple>> vecs_st;
-
-        // 将各方的perm转化为ShareTuple数组
-        perm_st.reserve(vec_size);
-        for (int i = 0; i < vec_size; i++) {
-            perm_st.push_back(ShareTuple({multi_server_perm[0][i][0], multi_server_perm[1][i][0], multi_server_perm[2][i][0]},
-                                            multi_server_perm[0][i].type));
-        }
-        // 将各方的vecs转化为ShareTuple数组
-        vecs_st.reserve(multi_server_vecs[0].size());
-        for (int i = 0; i < multi_server_vecs[0].size(); i++) {
-            std::vector<ShareTuple> vec_st;
-            vec_st.reserve(vec_size);
-            for (int j = 0; j < vec_size; j++) {
-                vec_st.push_back(ShareTuple({multi_server_vecs[0][i][j][0], multi_server_vecs[1][i][j][0], multi_server_vecs[2][i][j][0]},
-                                            multi_server_vecs[0][i][j].type));
-            }
-            vecs_st.push_back(vec_st);
-        }
-
-        // 计算明文下的perm和vecs
-        std::vector<int> perm;
-        perm.reserve(vec_size);
-        for (int i = 0; i < vec_size; i++) {
-            perm.push_back(perm_st[i].compute());
-        }
-
+        // 按列重构明文下的perm和vecs
+        std::vector<int> perm = revealSharePairs(multi_server_perm[0], multi_server_perm[1], multi_server_perm[2]);
         std::vector<std::vector<int>> vecs;
-        vecs.reserve(vecs_st.size());
-        for (int i = 0; i < vecs_st.size(); i++) {
-            std::vector<int> vec;
-            vec.reserve(vec_size);
-            for (int j = 0; j < vec_size; j++) {
-                vec.push_back(vecs_st[i][j].compute());
-            }
-            vecs.push_back(vec);
+        vecs.reserve(multi_server_vecs[0].size());
+        for (int i = 0; i < multi_server_vecs[0].size(); i++) {
+            vecs.push_back(revealSharePairs(multi_server_vecs[0][i], multi_server_vecs[1][i], multi_server_vecs[2][i]));
         }
 
         // 计算按照perm排序后的vecs
@@ -271,17 +303,11 @@ std::any ThirdParty::executeCmd() {
             // printVec(permed_vecs.back());
         }
 
-        // 将结果转变为ShareTuple数组
+        // 将结果逐列拆分为ShareTuple数组
         std::vector<std::vector<ShareTuple>> permed_vecs_st;
         permed_vecs_st.reserve(permed_vecs.size());
         for (int i = 0; i < permed_vecs.size(); i++) {
-            std::vector<ShareTuple> permed_vec_st;
-            permed_vec_st.reserve(vec_size);
-            u_int share_type = multi_server_vecs[0][i][0].type;
-            for (int j = 0; j < vec_size; j++) {
-                permed_vec_st.push_back(ShareTuple(permed_vecs[i][j], share_type));
-            }
-            permed_vecs_st.push_back(permed_vec_st);
+            permed_vecs_st.push_back(splitTuples(permed_vecs[i], multi_server_vecs[0][i][0].type));
         }
 
         return permed_vecs_st;
@@ -294,18 +320,9 @@ std::any ThirdParty::executeCmd() {
         for (int i = 0; i < args_buffer.size(); i++) {
             multi_server_sps.push_back(std::any_cast<std::vector<SharePair>&>(args_buffer[i][0]));
         }
-        // 用各方SharePair的首个份额，构造ShareTuple向量
-        std::vector<ShareTuple> sts;
+        // 用各方SharePair的首个份额，按列重构明文下的vec
         u_int share_type = multi_server_sps[0][0].type;
-        sts.reserve(multi_server_sps[0].size());
-        for (int i = 0; i < multi_server_sps[0].size(); i++) {
-            sts.push_back(ShareTuple({multi_server_sps[0][i][0], multi_server_sps[1][i][0], multi_server_sps[2][i][0]}, share_type));
-        }
-        // 计算明文下的vec
-        std::vector<int> vec(sts.size());
-        for (int i = 0; i < sts.size(); i++) {
-            vec[i] = sts[i].compute();
-        }
+        std::vector<int> vec = revealSharePairs(multi_server_sps[0], multi_server_sps[1], multi_server_sps[2]);
 
         // 相邻比较，生成标志位数组
         std::vector<int> flags(vec.size(), 0);
@@ -317,14 +334,8 @@ std::any ThirdParty::executeCmd() {
         // log("flags:");
         // printVec(flags);
 
-        // 将结果转为ShareTuple数组
-        std::vector<ShareTuple> flags_st;
-        flags_st.reserve(flags.size());
-        for (int i = 0; i < flags.size(); i++) {
-            flags_st.push_back(ShareTuple(flags[i], share_type));
-        }
-
-        return flags_st;
+        // 将结果整列拆分为ShareTuple数组
+        return splitTuples(flags, share_type);
     } else if (cmd == Command::COMPARE_NEIGHBOR_GT) {
         // 输入一组数据，输出邻居间比较的标志位数组
         // 重构向量
@@ -334,18 +345,9 @@ std::any ThirdParty::executeCmd() {
         for (int i = 0; i < args_buffer.size(); i++) {
             multi_server_sps.push_back(std::any_cast<std::vector<SharePair>&>(args_buffer[i][0]));
         }
-        // 用各方SharePair的首个份额，构造ShareTuple向量
-        std::vector<ShareTuple> sts;
+        // 用各方SharePair的首个份额，按列重构明文下的vec
         u_int share_type = multi_server_sps[0][0].type;
-        sts.reserve(multi_server_sps[0].size());
-        for (int i = 0; i < multi_server_sps[0].size(); i++) {
-            sts.push_back(ShareTuple({multi_server_sps[0][i][0], multi_server_sps[1][i][0], multi_server_sps[2][i][0]}, share_type));
-        }
-        // 计算明文下的vec
-        std::vector<int> vec(sts.size());
-        for (int i = 0; i < sts.size(); i++) {
-            vec[i] = sts[i].compute();
-        }
+        std::vector<int> vec = revealSharePairs(multi_server_sps[0], multi_server_sps[1], multi_server_sps[2]);
 
         // 相邻比较，生成标志位数组
         std::vector<int> flags(vec.size(), 0);
@@ -357,14 +359,8 @@ std::any ThirdParty::executeCmd() {
         // log("flags:");
         // printVec(flags);
 
-        // 将结果转为ShareTuple数组
-        std::vector<ShareTuple> flags_st;
-        flags_st.reserve(flags.size());
-        for (int i = 0; i < flags.size(); i++) {
-            flags_st.push_back(ShareTuple(flags[i], share_type));
-        }
-
-        return flags_st;
+        // 将结果整列拆分为ShareTuple数组
+        return splitTuples(flags, share_type);
     } else if (cmd == Command::OR_VECTOR) {
         // 输入一组数据，输出累积或
         // 重构向量
@@ -374,18 +370,9 @@ std::any ThirdParty::executeCmd() {
         for (int i = 0; i < args_buffer.size(); i++) {
             multi_server_sps.push_back(std::any_cast<std::vector<SharePair>&>(args_buffer[i][0]));
         }
-        // 用各方SharePair的首个份额，构造ShareTuple向量
-        std::vector<ShareTuple> sts;
+        // 用各方SharePair的首个份额，按列重构明文下的vec
         u_int share_type = multi_server_sps[0][0].type;
-        sts.reserve(multi_server_sps[0].size());
-        for (int i = 0; i < multi_server_sps[0].size(); i++) {
-            sts.push_back(ShareTuple({multi_server_sps[0][i][0], multi_server_sps[1][i][0], multi_server_sps[2][i][0]}, share_type));
-        }
-        // 计算明文下的vec
-        std::vector<int> vec(sts.size());
-        for (int i = 0; i < sts.size(); i++) {
-            vec[i] = sts[i].compute();
-        }
+        std::vector<int> vec = revealSharePairs(multi_server_sps[0], multi_server_sps[1], multi_server_sps[2]);
 
         // 计算累积或
         for (int num : vec) {
@@ -397,6 +384,83 @@ std::any ThirdParty::executeCmd() {
         // log("OR: 0");
         return ShareTuple(0, share_type);
 
+    } else if (cmd == Command::SORT_ROWS || cmd == Command::PERM_ROWS ||
+               cmd == Command::COMPARE_NEIGHBOR_EQ_ROWS || cmd == Command::COMPARE_NEIGHBOR_GT_ROWS ||
+               cmd == Command::OR_ROWS) {
+        // 按行批量执行：重构参数表后逐行计算，结果为明文表，其中share_types记录结果各列的共享类型
+        const auto& arg = std::any_cast<Table&>(args_buffer[0][0]);
+        std::vector<std::vector<int>> values = revealRows(0);
+        size_t rows = arg.size();
+        size_t cols = values.size();
+
+        Table result(Table::INT_MODE);
+        std::vector<std::vector<int>> out;
+        if (cmd == Command::SORT_ROWS) {
+            // 每行排序后的映射，与原来的SORT_VECTOR一致，沿用参数各列的共享类型
+            result.headers = arg.headers;
+            result.share_types = arg.share_types;
+            out.assign(cols, std::vector<int>(rows));
+            std::vector<int> row(cols);
+            for (size_t r = 0; r < rows; r++) {
+                for (size_t c = 0; c < cols; c++) {
+                    row[c] = values[c][r];
+                }
+                auto perm = Utils::getSortingPermutation(row);
+                for (size_t c = 0; c < cols; c++) {
+                    out[c][r] = perm[c];
+                }
+            }
+        } else if (cmd == Command::PERM_ROWS) {
+            // 第一个参数为各行的映射，第二个参数为待置换的表
+            const auto& vec_arg = std::any_cast<Table&>(args_buffer[0][1]);
+            std::vector<std::vector<int>> vecs = revealRows(1);
+            if (vecs.size() != cols || vec_arg.size() != rows) {
+                throw std::runtime_error("Runtime Error in ThirdParty::executeCmd(): PERM_ROWS permutation and table shapes do not match");
+            }
+            result.headers = vec_arg.headers;
+            result.share_types = vec_arg.share_types;
+            out.assign(cols, std::vector<int>(rows));
+            std::vector<int> perm(cols), row(cols);
+            for (size_t r = 0; r < rows; r++) {
+                for (size_t c = 0; c < cols; c++) {
+                    perm[c] = values[c][r];
+                    row[c] = vecs[c][r];
+                }
+                auto permed = Utils::applyPermutation(perm, row);
+                for (size_t c = 0; c < cols; c++) {
+                    out[c][r] = permed[c];
+                }
+            }
+        } else if (cmd == Command::COMPARE_NEIGHBOR_EQ_ROWS || cmd == Command::COMPARE_NEIGHBOR_GT_ROWS) {
+            // 每行相邻元素比较，第0列恒为0；EQ为v[c] == v[c-1]，GT为v[c-1] > v[c]
+            bool eq = cmd == Command::COMPARE_NEIGHBOR_EQ_ROWS;
+            result.headers = arg.headers;
+            result.share_types.assign(cols, BINARY_SHARING);
+            out.assign(cols, std::vector<int>(rows, 0));
+            for (size_t c = 1; c < cols; c++) {
+                const auto& prev = values[c - 1];
+                const auto& curr = values[c];
+                for (size_t r = 0; r < rows; r++) {
+                    out[c][r] = eq ? (curr[r] == prev[r]) : (prev[r] > curr[r]);
+                }
+            }
+        } else {
+            // 每行求析取，结果为单列的标志位
+            result.headers = {"or"};
+            result.share_types = {BINARY_SHARING};
+            out.assign(1, std::vector<int>(rows, 0));
+            for (const auto& column : values) {
+                for (size_t r = 0; r < rows; r++) {
+                    out[0][r] |= column[r] == 1;
+                }
+            }
+        }
+
+        result.initColumns();
+        for (size_t c = 0; c < out.size(); c++) {
+            result.columns[c].setParts({std::move(out[c])});
+        }
+        return result;
     } else {
         return std::any();
     }
@@ -406,6 +470,59 @@ void ThirdParty::clearBuffer() {
     for (int i = 0; i < servers.size(); i++) {
         args_buffer[i].clear();
         cmd_buffer[i] = 0;
+        request_buffer[i] = 0;
+    }
+}
+
+std::vector<std::vector<int>> ThirdParty::revealRows(size_t arg_idx) {
+    // S_i持有{x_i, x_{i+1}}，取各方的第0个分量即得{x_0, x_1, x_2}
+    std::vector<const Table*> shares;
+    for (size_t i = 0; i < SHARE_PARTY_NUM; i++) {
+        shares.push_back(&std::any_cast<Table&>(args_buffer[i][arg_idx]));
+    }
+    size_t cols = shares[0]->columns.size();
+    size_t rows = shares[0]->size();
+    for (const auto* t : shares) {
+        if (t->columns.size() != cols || t->size() != rows) {
+            throw std::runtime_error("Runtime Error in ThirdParty::revealRows(): Inconsistent table shapes among servers");
+        }
+    }
+
+    std::vector<std::vector<int>> values(cols);
+    for (size_t c = 0; c < cols; c++) {
+        reconstructColumn(shares[0]->columns[c].cpart(0), shares[1]->columns[c].cpart(0), shares[2]->columns[c].cpart(0),
+                          shares[0]->share_types[c], values[c]);
+    }
+    return values;
+}
+
+void ThirdParty::shareRows(const std::string& result_name, const std::vector<std::string>& headers,
+                           const std::vector<u_int>& share_types, const std::vector<std::vector<int>>& values, bool flags) {
+    // 先按列拆分出三个分量，再为各方组装{x_i, x_{i+1}}，各方的表共享同一份分量缓冲区
+    std::vector<Column> tuples(values.size());
+    for (size_t c = 0; c < values.size(); c++) {
+        std::vector<std::vector<int>> x(SHARE_PARTY_NUM);
+        if (flags) {
+            splitBits(values[c], x[0], x[1], x[2]);
+        } else {
+            splitColumn(values[c], share_types[c], x[0], x[1], x[2]);
+        }
+        tuples[c].setParts(std::move(x));
+    }
+
+    for (int i = 0; i < SHARE_PARTY_NUM; i++) {
+        Table sst(Table::SHARE_PAIR_MODE);
+        sst.headers = headers;
+        sst.share_types = share_types;
+        sst.is_null.clear();
+        sst.columns.resize(values.size());
+        for (size_t c = 0; c < values.size(); c++) {
+            sst.columns[c].sharePart(0, tuples[c], i);
+            sst.columns[c].sharePart(1, tuples[c], (i + 1) % SHARE_PARTY_NUM);
+        }
+        TableMessage back_tmsg(this->id, servers[i]->id, Command::RECEIVE_TABLE_SHARE, result_name, serializeTable(Command::RECEIVE_TABLE_SHARE, sst));
+        sendMessage(servers[i]->id, back_tmsg);
+        sendOK(servers[i]->id, request_buffer[i]);
     }
 }
 
@@ -433,25 +550,39 @@ void ThirdParty::shareTable(std::string table_name, u_int share_type, std::vecto
 
 
 void ThirdParty::revealInt(std::string var_name) {
-    auto it = std::find(std::begin(servers), std::end(servers), this);
-    // 要求servers提供秘密共享份额
+    // 要求servers提供秘密共享份额，三方的发送互相重叠
+    std::vector<std::future<void>> responses;
     for (int i = 0; i < SHARE_PARTY_NUM; i++) {
-        servers[i]->revealIntTo(var_name, this);
+        responses.push_back(servers[i]->revealIntToAsync(var_name, this));
     }
+    waitResponses(Command::REVEAL_INT, responses);
 }
 
 void ThirdParty::revealTable(std::string table_name) {
-    // 要求servers提供秘密共享份额
+    // 要求servers提供秘密共享份额，三方的发送互相重叠
+    std::vector<std::future<void>> responses;
     for (int i = 0; i < SHARE_PARTY_NUM; i++) {
-        servers[i]->revealTableTo(table_name, this);
+        responses.push_back(servers[i]->revealTableToAsync(table_name, this));
     }
+    waitResponses(Command::REVEAL_TABLE, responses);
+}
+
+void ThirdParty::revealRenamedTable(std::string src_name, std::string dst_name, const std::vector<std::string>& new_headers) {
+    // 重构后的变量名不带括号
+    std::string cache_name = extractVarName(src_name);
+    if (!this->hasVar(cache_name)) {
+        this->revealTable(src_name);
+    }
+    this->renameTable(cache_name, extractVarName(dst_name), new_headers);
 }
 
 void ThirdParty::revealVec(std::string vec_name) {
-    // 要求servers提供秘密共享份额
+    // 要求servers提供秘密共享份额，三方的发送互相重叠
+    std::vector<std::future<void>> responses;
     for (int i = 0; i < SHARE_PARTY_NUM; i++) {
-        servers[i]->revealVecTo(vec_name, this);
+        responses.push_back(servers[i]->revealVecToAsync(vec_name, this));
     }
+    waitResponses(Command::REVEAL_VEC, responses);
 }
 
 void ThirdParty::join(std::string r_name, std::string s_name, std::string t_name, const uint64_t& padding_to) {
@@ -473,7 +604,7 @@ void ThirdParty::join(std::string r_name, std::string s_name, std::string t_name
         // this->shareTable(extractVarName(t_name), t, std::vector<u_int>(t.headers.size(), BINARY_SHARING), servers);
 
         // 存储结果
-        this->setVar(extractVarName(t_name), t);
+        this->setVar(extractVarName(t_name), std::move(t));
     } catch (const std::bad_any_cast &e) {
         warning("Bad any cast in function ThirdParty::join(): " + std::string(e.what()) + " in " + r_name + " ⋈ " + s_name);
     }
@@ -521,7 +652,7 @@ void ThirdParty::bucketJoin(std::string r_name, std::string s_name, std::string
         // this->shareTable(extractVarName(t_name), t, std::vector<u_int>(t.headers.size(), BINARY_SHARING), servers);
 
         // 存储结果
-        this->setVar(extractVarName(t_name), t);
+        this->setVar(extractVarName(t_name), std::move(t));
     } else {
         log("BucketJoin: " + t_name + " = " + r_name + " ⋈ " + s_name);
 
@@ -538,7 +669,7 @@ void ThirdParty::bucketJoin(std::string r_name, std::string s_name, std::string
         log("Join finish!");
 
         // 存储结果
-        this->setVar(extractVarName(t_name), result.first);
+        this->setVar(extractVarName(t_name), std::move(result.first));
         this->setTableIndex(extractVarName(t_name), result.second);
     }
 
@@ -558,12 +689,12 @@ void ThirdParty::checkMatch(std::string table_name, std::vector<std::vector<int>
         log("CheckMatch: " + table_name);
         auto& t = std::any_cast<Table&>(this->getVar(extractVarName(table_name)));
 
-        for (int i = 0; i < t.data.size(); i++) {
+        for (int i = 0; i < t.size(); i++) {
             bool isValidRow = true;
-            const auto& row = t.data[i];
+            const auto row = t.getIntRow(i);
 
             // 先检查此行本身是否有效
-            auto value = std::any_cast<int>(t.is_null[i]);
+            auto value = t.getIsNullInt(i);
             if (value == 1) {
                 isValidRow = false;
             }
@@ -580,9 +711,9 @@ void ThirdParty::checkMatch(std::string table_name, std::vector<std::vector<int>
                         }
                     }
                     // 逐个比较相邻的元素是否成偏序（升序）关系
-                    for (int i = 0; i < indices.size() - 1; i++) {
-                        int val1 = std::any_cast<int>(row[indices[i]]);
-                        int val2 = std::any_cast<int>(row[indices[i + 1]]);
+                    for (int i = 0; i + 1 < indices.size(); i++) {
+                        int val1 = row[indices[i]];
+                        int val2 = row[indices[i + 1]];
                         if (val1 >= val2) {
                             isValidRow = false;
                             break;
@@ -599,10 +730,10 @@ void ThirdParty::checkMatch(std::string table_name, std::vector<std::vector<int>
                 std::vector<int> temp;
                 temp.reserve(row.size());
                 for (const auto& element : row) {
-                    temp.push_back(std::any_cast<int>(element));
+                    temp.push_back(element);
                 }
                 std::sort(temp.begin(), temp.end());
-                for (int i = 0; i < temp.size(); i++) {
+                for (int i = 0; i + 1 < temp.size(); i++) {
                     if (temp[i] == temp[i + 1]) {
                         isValidRow = false;
                         break;
@@ -612,10 +743,10 @@ void ThirdParty::checkMatch(std::string table_name, std::vector<std::vector<int>
 
             // 如果不满足则设置该行的isNull为1
             if (!isValidRow) {
-                t.is_null[i] = 1;
+                t.is_null.set(i, 1);
             }
 
-            log_process(i + 1, t.data.size());
+            log_process(i + 1, t.size());
         }
         log("CheckMatch finish!");
 
@@ -623,8 +754,7 @@ void ThirdParty::checkMatch(std::string table_name, std::vector<std::vector<int>
         // log("CheckMatch finish, sharing " + table_name + "...");
         // this->shareTable(table_name.substr(1, table_name.length() - 2), t, std::vector<u_int>(t.headers.size(), BINARY_SHARING), servers);
 
-        // 存储结果
-        this->setVar(extractVarName(table_name), t);
+        // t是变量存储中表的引用，已原地更新，无需再次存储
     } catch (const std::bad_any_cast &e) {
         warning("Bad any cast in function ThirdParty::checkMatch(): " + std::string(e.what()));
     }
@@ -639,12 +769,12 @@ void ThirdParty::checkInjectivity(std::string table_name) {
         log("Check Injectivity: " + table_name);
         auto& t = std::any_cast<Table&>(this->getVar(extractVarName(table_name)));
 
-        for (int i = 0; i < t.data.size(); i++) {
+        for (int i = 0; i < t.size(); i++) {
             bool isValidRow = true;
-            const auto& row = t.data[i];
+            const auto row = t.getIntRow(i);
 
             // 先检查此行本身是否有效
-            auto value = std::any_cast<int>(t.is_null[i]);
+            auto value = t.getIsNullInt(i);
             if (value == 1) {
                 isValidRow = false;
             }
@@ -654,10 +784,10 @@ void ThirdParty::checkInjectivity(std::string table_name) {
                 std::vector<int> temp;
                 temp.reserve(row.size());
                 for (const auto& element : row) {
-                    temp.push_back(std::any_cast<int>(element));
+                    temp.push_back(element);
                 }
                 std::sort(temp.begin(), temp.end());
-                for (int i = 0; i < temp.size(); i++) {
+                for (int i = 0; i + 1 < temp.size(); i++) {
                     if (temp[i] == temp[i + 1]) {
                         isValidRow = false;
                         break;
@@ -667,15 +797,14 @@ void ThirdParty::checkInjectivity(std::string table_name) {
 
             // 如果不满足则设置该行的isNull为1
             if (!isValidRow) {
-                t.is_null[i] = 1;
+                t.is_null.set(i, 1);
             }
 
-            log_process(i + 1, t.data.size());
+            log_process(i + 1, t.size());
         }
         log("Check Injectivity finish!");
 
-        // 存储结果
-        this->setVar(extractVarName(table_name), t);
+        // t是变量存储中表的引用，已原地更新，无需再次存储
     } catch (const std::bad_any_cast &e) {
         warning("Bad any cast in function ThirdParty::checkInjectivity(): " + std::string(e.what()));
     }
@@ -686,12 +815,12 @@ void ThirdParty::checkSymmetry(std::string table_name, std::vector<std::vector<i
         log("Check Symmetry: " + table_name);
         auto& t = std::any_cast<Table&>(this->getVar(extractVarName(table_name)));
 
-        for (int i = 0; i < t.data.size(); i++) {
+        for (int i = 0; i < t.size(); i++) {
             bool isValidRow = true;
-            const auto& row = t.data[i];
+            const auto row = t.getIntRow(i);
 
             // 先检查此行本身是否有效
-            auto value = std::any_cast<int>(t.is_null[i]);
+            auto value = t.getIsNullInt(i);
             if (value == 1) {
                 isValidRow = false;
             }
@@ -708,9 +837,9 @@ void ThirdParty::checkSymmetry(std::string table_name, std::vector<std::vector<i
                         }
                     }
                     // 逐个比较相邻的元素是否成偏序（升序）关系
-                    for (int i = 0; i < indices.size() - 1; i++) {
-                        int val1 = std::any_cast<int>(row[indices[i]]);
-                        int val2 = std::any_cast<int>(row[indices[i + 1]]);
+                    for (int i = 0; i + 1 < indices.size(); i++) {
+                        int val1 = row[indices[i]];
+                        int val2 = row[indices[i + 1]];
                         if (val1 >= val2) {
                             isValidRow = false;
                             break;
@@ -724,15 +853,14 @@ void ThirdParty::checkSymmetry(std::string table_name, std::vector<std::vector<i
             
             // 如果不满足则设置该行的isNull为1
             if (!isValidRow) {
-                t.is_null[i] = 1;
+                t.is_null.set(i, 1);
             }
 
-            log_process(i + 1, t.data.size());
+            log_process(i + 1, t.size());
         }
         log("Check Symmetry finish!");
 
-        // 存储结果
-        this->setVar(extractVarName(table_name), t);
+        // t是变量存储中表的引用，已原地更新，无需再次存储
     } catch (const std::bad_any_cast &e) {
         warning("Bad any cast in function ThirdParty::checkSymmetry(): " + std::string(e.what()));
     }
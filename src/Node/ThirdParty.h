@@ -14,19 +14,29 @@ private:
     // 指令预存区
     std::vector<u_int> cmd_buffer;
 
+    // 请求编号预存区，执行完指令后据此回复各方
+    std::vector<uint64_t> request_buffer;
+
     std::mutex thirdparty_handle_msg_mutx;
 
 public:
     // 构造函数
-    ThirdParty(u_int id, const std::string& name, std::vector<Node*> servers) : Node(id, name), servers(servers), args_buffer(servers.size()), cmd_buffer(servers.size(), 0) {}
+    ThirdParty(u_int id, const std::string& name, std::vector<Node*> servers) : Node(id, name), servers(servers), args_buffer(servers.size()), cmd_buffer(servers.size(), 0), request_buffer(servers.size(), 0) {}
 
     // 复写handleMessage函数
-    void handleMessage(const Message& message, const std::string& message_str);
+    void handleMessage(const Message& message, std::string_view payload);
 
     // 参数和指令缓存区的操作
     bool checkCmd();
     std::any executeCmd();
     void clearBuffer();
+    // 按行批量指令的辅助函数
+    // 由三方缓存的第arg_idx个参数表，按列重构出明文，values[c][r]为第r行第c个元素
+    std::vector<std::vector<int>> revealRows(size_t arg_idx);
+    // 将按列给出的明文结果拆分为秘密共享表，以result_name发送给各方并回复其请求
+    // flags为true表示各列都是0/1标志位，按位拆分后各分量也只取0/1，传输时按位压缩
+    void shareRows(const std::string& result_name, const std::vector<std::string>& headers,
+                   const std::vector<u_int>& share_types, const std::vector<std::vector<int>>& values, bool flags = false);
 
     // 变量秘密共享操作
     // 复写，增加Server*对象的传参，将已存储的Table，所有列都以share_type共享给owners
@@ -37,6 +47,8 @@ public:
     void revealInt(std::string var_name);
     // 要求重构Table
     void revealTable(std::string table_name);
+    // 以new_headers为表头重构src_name，存为dst_name。src_name只在第一次用到时重构并缓存，之后直接在本地构造共享数据的重命名视图
+    void revealRenamedTable(std::string src_name, std::string dst_name, const std::vector<std::string>& new_headers);
     // 要求重构Vector
     void revealVec(std::string vec_name);
 
@@ -0,0 +1,108 @@
+#include "Transport.h"
+#include <sys/socket.h>
+#include <unistd.h>
+#include <iostream>
+
+bool TcpTransport::send(u_int to_id, std::string frame) {
+    if (to_id >= socks.size() || socks[to_id] < 0) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(send_mutexes[to_id]);
+    size_t total_sent = 0;
+    while (total_sent < frame.size()) {
+        ssize_t bytes_sent = ::send(socks[to_id], frame.data() + total_sent, frame.size() - total_sent, 0);
+        if (bytes_sent < 0) {
+            return false;
+        }
+        total_sent += bytes_sent;
+    }
+    return true;
+}
+
+void TcpTransport::close() {
+    for (int& sock : socks) {
+        if (sock != -1) {
+            shutdown(sock, SHUT_RDWR);
+            ::close(sock);
+            sock = -1;
+        }
+    }
+}
+
+bool InProcessTransport::send(u_int to_id, std::string frame) {
+    if (to_id >= peers.size() || peers[to_id] == nullptr) {
+        return false;
+    }
+    peers[to_id]->post(from_id, std::move(frame));
+    return true;
+}
+
+ShapedTransport::ShapedTransport(u_int from_id, std::unique_ptr<Transport> inner, const NetworkProfile& profile)
+    : from_id(from_id), inner(std::move(inner)), profile(profile), rng(std::random_device{}()) {
+    deliver_thread = std::thread(&ShapedTransport::deliverLoop, this);
+}
+
+bool ShapedTransport::send(u_int to_id, std::string frame) {
+    LinkShape shape = profile.link(from_id, to_id);
+    Clock::time_point now = Clock::now();
+
+    std::lock_guard<std::mutex> lock(mtx);
+    if (closed) {
+        return false;
+    }
+
+    // 消息在链路空闲后才开始发送，发送耗时由带宽决定
+    Clock::time_point start = std::max(now, link_free[to_id]);
+    double transfer_ms = shape.bandwidth_mbps > 0 ? frame.size() * 8 / (shape.bandwidth_mbps * 1000.0) : 0;
+    Clock::time_point sent = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(transfer_ms));
+    link_free[to_id] = sent;
+
+    double delay_ms = shape.latency_ms;
+    if (shape.jitter_ms > 0) {
+        delay_ms += std::uniform_real_distribution<double>(0, shape.jitter_ms)(rng);
+    }
+    Clock::time_point deliver = sent + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(delay_ms));
+    // 抖动不能让后发的消息先到
+    deliver = std::max(deliver, last_deliver[to_id]);
+    last_deliver[to_id] = deliver;
+
+    pending.push({deliver, next_seq++, to_id, std::move(frame)});
+    cv.notify_one();
+    return true;
+}
+
+void ShapedTransport::close() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        closed = true;
+    }
+    cv.notify_all();
+    if (deliver_thread.joinable()) {
+        deliver_thread.join();
+    }
+    inner->close();
+}
+
+void ShapedTransport::deliverLoop() {
+    std::unique_lock<std::mutex> lock(mtx);
+    while (!closed) {
+        if (pending.empty()) {
+            cv.wait(lock);
+            continue;
+        }
+        Clock::time_point deliver_time = pending.top().deliver_time;
+        if (Clock::now() < deliver_time) {
+            cv.wait_until(lock, deliver_time);
+            continue;
+        }
+        // priority_queue::top()只能取常量引用，借助const_cast移出帧数据，随后立即pop
+        Pending item = std::move(const_cast<Pending&>(pending.top()));
+        pending.pop();
+        lock.unlock();
+        if (!inner->send(item.to_id, std::move(item.frame))) {
+            std::cerr << "Error in ShapedTransport::deliverLoop(): Error delivering message to node " << item.to_id << std::endl;
+        }
+        lock.lock();
+    }
+}
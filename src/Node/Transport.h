@@ -0,0 +1,145 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <map>
+#include <queue>
+#include <thread>
+#include <random>
+#include <chrono>
+#include <memory>
+#include <condition_variable>
+#include <sys/types.h>
+
+#include "Reactor.h"
+
+// 传输方式
+static const u_int TCP_TRANSPORT = 0;           // 节点间通过TCP连接通信，用于实际部署
+static const u_int IN_PROCESS_TRANSPORT = 1;    // 同进程内的节点直接投递消息帧，不经过socket
+
+// 节点发送消息帧的传输层，接收端统一由各节点的Reactor处理
+class Transport {
+public:
+    virtual ~Transport() = default;
+
+    // 发送一条完整的消息帧，frame的所有权交给传输层，返回false表示发送失败
+    virtual bool send(u_int to_id, std::string frame) = 0;
+    // 关闭传输层持有的资源，可重复调用
+    virtual void close() {}
+};
+
+// TCP传输：每个对端一条主动建立的阻塞连接，只用于发送
+class TcpTransport : public Transport {
+public:
+    TcpTransport(std::vector<int> socks) : socks(std::move(socks)), send_mutexes(this->socks.size()) {}
+    ~TcpTransport() { close(); }
+
+    bool send(u_int to_id, std::string frame) override;
+    void close() override;
+
+private:
+    std::vector<int> socks;     // socks[to_id]为连接到to_id的套接字，-1表示未连接
+    std::vector<std::mutex> send_mutexes;   // 多个线程可能同时向同一对端发送，保证帧不交错
+};
+
+// 进程内传输：消息帧的缓冲区整体移交给对端Reactor的无锁队列，无拷贝、无socket系统调用
+class InProcessTransport : public Transport {
+public:
+    InProcessTransport(u_int from_id, std::vector<Reactor*> peers) : from_id(from_id), peers(std::move(peers)) {}
+
+    bool send(u_int to_id, std::string frame) override;
+
+private:
+    u_int from_id;
+    std::vector<Reactor*> peers;    // peers[to_id]为对端节点的Reactor
+};
+
+// 单向链路的网络条件
+struct LinkShape {
+    double latency_ms = 0;          // 单向时延
+    double jitter_ms = 0;           // 时延抖动，每条消息在[0, jitter_ms)内均匀随机
+    double bandwidth_mbps = 0;      // 带宽上限（Mbit/s），0表示不限
+
+    bool isIdeal() const { return latency_ms <= 0 && jitter_ms <= 0 && bandwidth_mbps <= 0; }
+};
+
+// 一组节点间的网络条件：默认链路条件，可按(from, to)单独覆盖
+struct NetworkProfile {
+    std::string name = "ideal";
+    LinkShape shape;
+    std::map<std::pair<u_int, u_int>, LinkShape> links;
+
+    NetworkProfile() = default;
+    NetworkProfile(const std::string& name, double latency_ms, double bandwidth_mbps, double jitter_ms = 0)
+        : name(name), shape{latency_ms, jitter_ms, bandwidth_mbps} {}
+
+    // from到to的链路条件
+    LinkShape link(u_int from, u_int to) const {
+        auto it = links.find({from, to});
+        return it == links.end() ? shape : it->second;
+    }
+    // 是否所有链路都不需要整形
+    bool isIdeal() const {
+        if (!shape.isIdeal()) {
+            return false;
+        }
+        for (const auto& [key, link_shape] : links) {
+            if (!link_shape.isIdeal()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // 用于基准测试的一组典型广域网条件
+    static std::vector<NetworkProfile> wanProfiles() {
+        return {
+            NetworkProfile("lan",                 0.1, 10000),
+            NetworkProfile("wan-10ms-1gbps",     5,    1000, 0.5),
+            NetworkProfile("wan-40ms-1gbps",     20,   1000, 2),
+            NetworkProfile("wan-100ms-100mbps",  50,   100,  5),
+        };
+    }
+};
+
+// 网络条件模拟：包装另一个传输层，按链路条件推迟每条消息的投递，完全在进程内实现，不依赖tc或root权限
+// 每条链路的发送按带宽串行占用链路，投递时刻为发送完成时刻加上时延和抖动，并保证同一链路上的消息按发送顺序投递
+class ShapedTransport : public Transport {
+public:
+    ShapedTransport(u_int from_id, std::unique_ptr<Transport> inner, const NetworkProfile& profile);
+    ~ShapedTransport() { close(); }
+
+    bool send(u_int to_id, std::string frame) override;
+    void close() override;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Pending {
+        Clock::time_point deliver_time;
+        uint64_t seq;               // 投递时刻相同时按发送顺序
+        u_int to_id;
+        std::string frame;
+
+        bool operator>(const Pending& other) const {
+            return deliver_time != other.deliver_time ? deliver_time > other.deliver_time : seq > other.seq;
+        }
+    };
+
+    u_int from_id;
+    std::unique_ptr<Transport> inner;
+    NetworkProfile profile;
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::priority_queue<Pending, std::vector<Pending>, std::greater<Pending>> pending;
+    std::map<u_int, Clock::time_point> link_free;       // 各链路上一条消息发送完毕的时刻
+    std::map<u_int, Clock::time_point> last_deliver;    // 各链路上一条消息的投递时刻
+    uint64_t next_seq = 0;
+    std::mt19937 rng;
+    bool closed = false;
+    std::thread deliver_thread;
+
+    void deliverLoop();
+};
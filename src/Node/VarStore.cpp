@@ -0,0 +1,345 @@
+#include "VarStore.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// 溢出时每次写入文件的编码块大小，整表的编码不会同时驻留在内存中
+static const size_t SPILL_BLOCK_BYTES = 4 << 20;
+
+SpillFile::SpillFile(const std::string& dir, const Table& table) : mode(table.mode), epsilon(table.epsilon) {
+    static std::atomic<uint64_t> seq{0};
+    std::string path = dir + "/prism-spill-" + std::to_string(getpid()) + "-" + std::to_string(seq.fetch_add(1));
+
+    fd = open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        throw std::runtime_error("Runtime Error in SpillFile(): Cannot create " + path + ": " + std::strerror(errno));
+    }
+    // 映射保持文件可访问，路径不再需要
+    unlink(path.c_str());
+    length = 0;
+    try {
+        table.writeBinary(SPILL_BLOCK_BYTES, [&](std::string_view block) {
+            while (!block.empty()) {
+                ssize_t n = write(fd, block.data(), block.size());
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (n < 0) {
+                    throw std::runtime_error("Runtime Error in SpillFile(): Cannot write " + path + ": " + std::strerror(errno));
+                }
+                block.remove_prefix(n);
+                length += n;
+            }
+        });
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+    // 写入的页由页缓存管理，可被系统换出，不再占用匿名内存
+    data = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        int err = errno;
+        close(fd);
+        throw std::runtime_error("Runtime Error in SpillFile(): Cannot map " + path + ": " + std::strerror(err));
+    }
+}
+
+SpillFile::~SpillFile() {
+    munmap(data, length);
+    close(fd);
+}
+
+Table SpillFile::load() const {
+    Table table(mode);
+    table.readFromBinary(std::string_view(static_cast<const char*>(data), length));
+    table.epsilon = epsilon;
+    return table;
+}
+
+SymbolTable& SymbolTable::instance() {
+    static SymbolTable table;
+    return table;
+}
+
+VarId SymbolTable::intern(std::string_view name) {
+    SymbolTable& table = instance();
+    {
+        std::shared_lock<std::shared_mutex> lock(table.mtx);
+        auto it = table.ids.find(name);
+        if (it != table.ids.end()) {
+            return it->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(table.mtx);
+    auto it = table.ids.find(name);     // 加写锁期间可能已被其他线程驻留
+    if (it != table.ids.end()) {
+        return it->second;
+    }
+    VarId id = table.names.size();
+    table.names.emplace_back(name);
+    table.ids.emplace(table.names.back(), id);
+    return id;
+}
+
+const std::string& SymbolTable::name(VarId id) {
+    SymbolTable& table = instance();
+    std::shared_lock<std::shared_mutex> lock(table.mtx);
+    return table.names.at(id);
+}
+
+VarType varTypeOf(const std::any& value) {
+    const std::type_info& type = value.type();
+    if (type == typeid(int)) return VarType::INT;
+    if (type == typeid(SharePair)) return VarType::SHARE_PAIR;
+    if (type == typeid(Table)) return VarType::TABLE;
+    if (type == typeid(std::vector<Index>)) return VarType::INDEX_VEC;
+    if (type == typeid(std::vector<SharePair>)) return VarType::SHARE_PAIR_VEC;
+    if (type == typeid(std::vector<int>)) return VarType::INT_VEC;
+    return VarType::NONE;
+}
+
+bool VarStore::contains(VarId id) const {
+    const Shard& s = shard(id);
+    std::lock_guard<std::mutex> lock(s.mtx);
+    auto it = s.slots.find(id);
+    return it != s.slots.end() && it->second->type != VarType::NONE;
+}
+
+VarType VarStore::type(VarId id) const {
+    const Shard& s = shard(id);
+    std::lock_guard<std::mutex> lock(s.mtx);
+    auto it = s.slots.find(id);
+    return it == s.slots.end() ? VarType::NONE : it->second->type;
+}
+
+std::any& VarStore::get(VarId id) {
+    Shard& s = shard(id);
+    while (true) {
+        std::shared_future<void> ready;
+        {
+            std::lock_guard<std::mutex> lock(s.mtx);
+            auto& slot = s.slots[id];
+            if (!slot) {
+                slot = std::make_shared<Slot>();
+            }
+            if (slot->type != VarType::NONE) {
+                touch(*slot);
+                return slot->value;
+            }
+            ready = slot->ready_future;
+        }
+        // 只等待该变量被设置，等待期间变量可能又被删除，醒来后重新检查
+        ready.wait();
+    }
+}
+
+std::any* VarStore::find(VarId id) {
+    Shard& s = shard(id);
+    std::lock_guard<std::mutex> lock(s.mtx);
+    auto it = s.slots.find(id);
+    if (it == s.slots.end() || it->second->type == VarType::NONE) {
+        return nullptr;
+    }
+    touch(*it->second);
+    return &it->second->value;
+}
+
+void VarStore::fill(Slot& slot, std::any value, VarType type) {
+    bool first = slot.type == VarType::NONE;
+    if (!first && !slot.spill) {
+        resident_bytes -= slot.bytes;
+    }
+    slot.spill.reset();
+    slot.value = std::move(value);
+    slot.type = type;
+    slot.bytes = estimateBytes(slot.value, type);
+    slot.last_round = round;
+    slot.version++;
+    resident_bytes += slot.bytes;
+    if (first) {
+        slot.ready.set_value();
+    }
+}
+
+void VarStore::touch(Slot& slot) {
+    if (slot.spill) {
+        slot.value = slot.spill->load();
+        slot.spill.reset();
+        resident_bytes += slot.bytes;
+        faults++;
+    }
+    slot.last_round = round;
+}
+
+void VarStore::set(VarId id, std::any value, VarType type) {
+    {
+        Shard& s = shard(id);
+        std::lock_guard<std::mutex> lock(s.mtx);
+        auto& slot = s.slots[id];
+        if (!slot) {
+            slot = std::make_shared<Slot>();
+        }
+        fill(*slot, std::move(value), type);
+    }
+    evict();
+}
+
+bool VarStore::setIfAbsent(VarId id, std::any value, VarType type) {
+    {
+        Shard& s = shard(id);
+        std::lock_guard<std::mutex> lock(s.mtx);
+        auto& slot = s.slots[id];
+        if (!slot) {
+            slot = std::make_shared<Slot>();
+        }
+        if (slot->type != VarType::NONE) {
+            return false;
+        }
+        fill(*slot, std::move(value), type);
+    }
+    evict();
+    return true;
+}
+
+bool VarStore::erase(VarId id) {
+    Shard& s = shard(id);
+    std::lock_guard<std::mutex> lock(s.mtx);
+    auto it = s.slots.find(id);
+    if (it == s.slots.end() || it->second->type == VarType::NONE) {
+        return false;
+    }
+    if (!it->second->spill) {
+        resident_bytes -= it->second->bytes;
+    }
+    s.slots.erase(it);
+    return true;
+}
+
+void VarStore::forEach(const std::function<void(const std::string& name, const std::any& value)>& func) {
+    // 先收集各分片中已设置的槽，再在锁外按变量名顺序遍历
+    std::vector<std::pair<std::string, std::shared_ptr<Slot>>> entries;
+    for (Shard& s : shards) {
+        std::lock_guard<std::mutex> lock(s.mtx);
+        for (const auto& [id, slot] : s.slots) {
+            if (slot->type != VarType::NONE) {
+                touch(*slot);
+                entries.emplace_back(SymbolTable::name(id), slot);
+            }
+        }
+    }
+    std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (const auto& [name, slot] : entries) {
+        func(name, slot->value);
+    }
+}
+
+void VarStore::setMemoryBudget(uint64_t bytes, const std::string& spill_dir) {
+    {
+        std::lock_guard<std::mutex> lock(spill_mutex);
+        this->spill_dir = spill_dir.empty() ? std::filesystem::temp_directory_path().string() : spill_dir;
+        budget = bytes;
+    }
+    evict();
+}
+
+void VarStore::nextRound() {
+    round++;
+    evict();
+}
+
+SpillStats VarStore::spillStats() const {
+    SpillStats stats;
+    stats.spills = spills;
+    stats.faults = faults;
+    stats.spilled_bytes = spilled_bytes;
+    stats.resident_bytes = resident_bytes;
+    return stats;
+}
+
+uint64_t VarStore::estimateBytes(const std::any& value, VarType type) {
+    if (type != VarType::TABLE) {
+        return 0;
+    }
+    const Table& table = *std::any_cast<Table>(&value);
+    uint64_t cells = 0;
+    for (const auto& column : table.columns) {
+        cells += column.size() * column.partNum();
+    }
+    return cells * sizeof(int) + BitColumn::wordCount(table.is_null.size()) * table.is_null.partNum() * sizeof(uint64_t);
+}
+
+void VarStore::evict() {
+    if (budget == 0 || resident_bytes <= budget) {
+        return;
+    }
+    // 已有线程在溢出时直接返回，由该线程负责回到预算以内
+    std::unique_lock<std::mutex> evicting(spill_mutex, std::try_to_lock);
+    if (!evicting.owns_lock()) {
+        return;
+    }
+
+    // 收集当前轮次尚未访问过的大表
+    struct Candidate {
+        VarId id;
+        uint64_t last_round;
+        uint64_t bytes;
+    };
+    uint64_t current_round = round;
+    std::vector<Candidate> candidates;
+    for (Shard& s : shards) {
+        std::lock_guard<std::mutex> lock(s.mtx);
+        for (const auto& [id, slot] : s.slots) {
+            if (slot->type == VarType::TABLE && !slot->spill && slot->bytes >= MIN_SPILL_BYTES && slot->last_round < current_round) {
+                candidates.push_back({id, slot->last_round, slot->bytes});
+            }
+        }
+    }
+    // 最久未访问的优先，同一轮次中大表优先
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        return a.last_round != b.last_round ? a.last_round < b.last_round : a.bytes > b.bytes;
+    });
+
+    for (const auto& candidate : candidates) {
+        if (resident_bytes <= budget) {
+            break;
+        }
+        spill(candidate.id, current_round);
+    }
+}
+
+bool VarStore::spill(VarId id, uint64_t current_round) {
+    Shard& s = shard(id);
+    std::shared_ptr<Slot> slot;
+    Table snapshot(Table::INT_MODE);
+    uint64_t version;
+    {
+        std::lock_guard<std::mutex> lock(s.mtx);
+        auto it = s.slots.find(id);
+        if (it == s.slots.end() || it->second->spill || it->second->type != VarType::TABLE || it->second->last_round >= current_round) {
+            return false;
+        }
+        slot = it->second;
+        snapshot = *std::any_cast<Table>(&slot->value);    // 与变量共享列缓冲区，不复制数据
+        version = slot->version;
+    }
+
+    // 在锁外编码并写入文件
+    auto file = std::make_unique<SpillFile>(spill_dir, snapshot);
+
+    std::lock_guard<std::mutex> lock(s.mtx);
+    // 期间变量被访问、替换或删除时放弃本次溢出
+    auto it = s.slots.find(id);
+    if (it == s.slots.end() || it->second != slot || slot->version != version || slot->last_round >= current_round) {
+        return false;
+    }
+    spilled_bytes += file->size();
+    slot->value.reset();
+    slot->spill = std::move(file);
+    resident_bytes -= slot->bytes;
+    spills++;
+    return true;
+}
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <any>
+#include <array>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <future>
+#include <functional>
+#include <unordered_map>
+#include <atomic>
+#include <cstdint>
+
+#include "../Share/Share.h"
+#include "../Table/Table.h"
+#include "../Statistic/Statistic.h"
+
+// 变量的驻留编号，同一进程内每个变量名对应唯一的VarId
+using VarId = uint32_t;
+
+// 变量名驻留表：变量名只在第一次出现时保存一份，此后各节点的变量存储都按VarId查找，不再哈希和比较字符串
+class SymbolTable {
+public:
+    static VarId intern(std::string_view name);
+    static const std::string& name(VarId id);
+
+private:
+    std::shared_mutex mtx;
+    std::unordered_map<std::string_view, VarId> ids;    // 键指向names中的字符串
+    std::deque<std::string> names;                      // names[id]为变量名，deque保证已有元素地址不变
+
+    static SymbolTable& instance();
+};
+
+// 变量存储支持的类型
+enum class VarType : uint8_t {
+    NONE = 0,           // 尚未设置
+    INT,
+    SHARE_PAIR,
+    TABLE,
+    INDEX_VEC,
+    SHARE_PAIR_VEC,
+    INT_VEC,
+};
+
+template <typename T> struct VarTypeOf { static constexpr VarType value = VarType::NONE; };
+template <> struct VarTypeOf<int> { static constexpr VarType value = VarType::INT; };
+template <> struct VarTypeOf<SharePair> { static constexpr VarType value = VarType::SHARE_PAIR; };
+template <> struct VarTypeOf<Table> { static constexpr VarType value = VarType::TABLE; };
+template <> struct VarTypeOf<std::vector<Index>> { static constexpr VarType value = VarType::INDEX_VEC; };
+template <> struct VarTypeOf<std::vector<SharePair>> { static constexpr VarType value = VarType::SHARE_PAIR_VEC; };
+template <> struct VarTypeOf<std::vector<int>> { static constexpr VarType value = VarType::INT_VEC; };
+
+// 可以存入变量存储的类型
+template <typename T>
+concept StorableVar = VarTypeOf<std::decay_t<T>>::value != VarType::NONE;
+
+// 按std::any中实际保存的类型得到VarType，不支持的类型返回NONE
+VarType varTypeOf(const std::any& value);
+
+// 溢出到磁盘的表：以toBinary的列式编码写入临时文件并映射到内存，读回时直接从映射中解码
+// 文件创建后即被unlink，映射解除后由系统回收
+class SpillFile {
+public:
+    TableMode mode;
+    double epsilon;
+
+    SpillFile(const std::string& dir, const Table& table);
+    ~SpillFile();
+    SpillFile(const SpillFile&) = delete;
+    SpillFile& operator=(const SpillFile&) = delete;
+
+    size_t size() const { return length; }
+    // 从映射中解码出原表
+    Table load() const;
+
+private:
+    int fd = -1;
+    void* data = nullptr;
+    size_t length = 0;
+};
+
+// 变量存储的内存统计
+struct SpillStats {
+    uint64_t spills = 0;            // 溢出到磁盘的次数
+    uint64_t faults = 0;            // 访问已溢出的变量、从磁盘读回的次数
+    uint64_t spilled_bytes = 0;     // 累计写入磁盘的字节数
+    uint64_t resident_bytes = 0;    // 当前驻留内存的表数据估计字节数
+};
+
+// 节点的变量存储
+// 按VarId分片加锁，每个变量一个槽，槽中记录值的类型；等待尚未设置的变量时只等待该变量自己的future，
+// 设置某个变量只会唤醒等待它的线程
+// 设置了内存预算时，驻留的表数据超出预算后，把当前轮次之前最后访问、且足够大的表溢出到磁盘，再次访问时自动读回。
+// 协议需保证不跨轮次持有变量的引用
+class VarStore {
+public:
+    static const size_t SHARD_NUM = 16;
+    static const uint64_t MIN_SPILL_BYTES = 1 << 20;   // 小于该大小的表不溢出
+
+    bool contains(VarId id) const;
+    VarType type(VarId id) const;
+
+    // 取变量，变量尚未设置时阻塞等待；返回的引用在变量被删除前有效
+    std::any& get(VarId id);
+    // 取变量，变量尚未设置时返回nullptr，不等待
+    std::any* find(VarId id);
+    // 按类型取变量，类型不符时抛出异常
+    template <typename T>
+    T& get(VarId id) {
+        std::any& value = get(id);
+        if (type(id) != VarTypeOf<T>::value) {
+            throw std::runtime_error("Runtime Error in VarStore::get(): Type mismatch for variable " + SymbolTable::name(id));
+        }
+        return *std::any_cast<T>(&value);
+    }
+
+    // 设置变量，唤醒等待该变量的线程
+    void set(VarId id, std::any value, VarType type);
+    // 变量不存在时才设置，返回是否设置成功
+    bool setIfAbsent(VarId id, std::any value, VarType type);
+    // 删除变量，返回变量原本是否存在
+    bool erase(VarId id);
+
+    // 按变量名顺序遍历所有已设置的变量，已溢出的变量会先读回
+    void forEach(const std::function<void(const std::string& name, const std::any& value)>& func);
+
+    // 设置内存预算（字节），0表示不限制；spill_dir为溢出文件所在目录，为空时使用系统临时目录
+    void setMemoryBudget(uint64_t bytes, const std::string& spill_dir = "");
+    // 进入下一轮，此前未再访问的变量成为冷变量
+    void nextRound();
+    SpillStats spillStats() const;
+
+private:
+    struct Slot {
+        std::any value;
+        VarType type = VarType::NONE;           // NONE表示只有等待者，变量尚未设置
+        std::promise<void> ready;               // 变量第一次设置时兑现
+        std::shared_future<void> ready_future;
+        uint64_t bytes = 0;                     // 表数据的估计大小，按存入时计算
+        uint64_t last_round = 0;                // 最后一次访问时的轮次
+        uint64_t version = 0;                   // 每次设置时递增，用于判断溢出期间变量是否被替换
+        std::unique_ptr<SpillFile> spill;       // 非空表示值已溢出到磁盘，value为空
+
+        Slot() : ready_future(ready.get_future().share()) {}
+    };
+
+    struct Shard {
+        mutable std::mutex mtx;
+        std::unordered_map<VarId, std::shared_ptr<Slot>> slots;
+    };
+
+    std::array<Shard, SHARD_NUM> shards;
+
+    std::atomic<uint64_t> budget{0};
+    std::atomic<uint64_t> round{0};
+    std::atomic<uint64_t> resident_bytes{0};
+    std::atomic<uint64_t> spills{0};
+    std::atomic<uint64_t> faults{0};
+    std::atomic<uint64_t> spilled_bytes{0};
+    std::string spill_dir;
+    std::mutex spill_mutex;                     // 同一时间只有一个线程执行溢出，同时保护spill_dir
+
+    Shard& shard(VarId id) { return shards[id % SHARD_NUM]; }
+    const Shard& shard(VarId id) const { return shards[id % SHARD_NUM]; }
+    // 在已加锁的分片中设置槽的值
+    void fill(Slot& slot, std::any value, VarType type);
+    // 在已加锁的分片中访问槽：已溢出时读回，并记录访问轮次
+    void touch(Slot& slot);
+    // 驻留数据超出预算时，按最后访问轮次从早到晚溢出冷变量，直到回到预算以内
+    void evict();
+    // 溢出单个变量，返回是否成功
+    bool spill(VarId id, uint64_t current_round);
+
+    static uint64_t estimateBytes(const std::any& value, VarType type);
+};
@@ -0,0 +1,36 @@
+#include "Executor.h"
+
+SerialExecutor::SerialExecutor() : worker(&SerialExecutor::run, this) {}
+
+SerialExecutor::~SerialExecutor() {
+    // 空任务表示退出
+    submit(std::function<void()>());
+    worker.join();
+}
+
+void SerialExecutor::submit(std::function<void()> task) {
+    tasks.push(std::move(task));
+    submitted.fetch_add(1, std::memory_order_release);
+    submitted.notify_one();
+}
+
+void SerialExecutor::run() {
+    uint64_t done = 0;
+    while (true) {
+        uint64_t posted = submitted.load(std::memory_order_acquire);
+        if (posted == done) {
+            submitted.wait(posted, std::memory_order_acquire);
+            continue;
+        }
+        std::function<void()> task;
+        while (!tasks.pop(task)) {
+            // 计数已增加但生产者尚未完成链接
+            std::this_thread::yield();
+        }
+        done++;
+        if (!task) {
+            return;
+        }
+        task();
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <functional>
+#include <cstdint>
+
+#include "../Node/MpscQueue.h"
+
+// 长期运行的单线程执行器，提交的任务按顺序串行执行
+// 任务队列为无锁的MpscQueue，可在任意线程并发提交；工作线程空闲时在提交计数上等待，不占用CPU
+class SerialExecutor {
+public:
+    SerialExecutor();
+    // 执行完已提交的任务后退出
+    ~SerialExecutor();
+
+    SerialExecutor(const SerialExecutor&) = delete;
+    SerialExecutor& operator=(const SerialExecutor&) = delete;
+
+    void submit(std::function<void()> task);
+
+private:
+    MpscQueue<std::function<void()>> tasks;
+    std::atomic<uint64_t> submitted{0};     // 已提交的任务数，工作线程据此判断队列中是否有任务
+    std::thread worker;                     // 最后初始化，启动时队列和计数已就绪
+
+    void run();
+};
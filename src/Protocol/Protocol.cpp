@@ -5,6 +5,12 @@ uint64_t MIX_BOUND_ = CARTESIAN_BOUND;
 
 std::mutex ptl_print_mutex;
 
+Protocol::Protocol(std::vector<Server*> servers, ThirdParty* third_party) : servers(servers), third_party(third_party) {
+    for (size_t i = 0; i < servers.size(); i++) {
+        executors.push_back(std::make_unique<SerialExecutor>());
+    }
+}
+
 void Protocol::revealInt(std::string var_name, Node *node) {
     auto it = std::find(std::begin(servers), std::end(servers), node);
     if (it != std::end(servers)) {
@@ -12,10 +18,12 @@ void Protocol::revealInt(std::string var_name, Node *node) {
         auto prevIt = (it == std::begin(servers) ? std::prev(std::end(servers)) : std::prev(it));
         (*prevIt)->revealIntTo(var_name, node);
     } else {
-        // 如过node本身没有份额，则各server将SharePair发送给node
-         for (int i = 0; i < SHARE_PARTY_NUM; i++) {
-            servers[i]->revealIntTo(var_name, node);
+        // 如过node本身没有份额，则各server将SharePair发送给node，三方的发送互相重叠
+        std::vector<std::future<void>> responses;
+        for (int i = 0; i < SHARE_PARTY_NUM; i++) {
+            responses.push_back(servers[i]->revealIntToAsync(var_name, node));
         }
+        node->waitResponses(Command::REVEAL_INT, responses);
     }
 }
 
@@ -26,10 +34,12 @@ void Protocol::revealTable(std::string table_name, Node *node) {
         auto prevIt = (it == std::begin(servers) ? std::prev(std::end(servers)) : std::prev(it));
         (*prevIt)->revealTableTo(table_name, node);
     } else {
-        // 如过node本身没有份额，则各server将SharePair发送给node
-         for (int i = 0; i < SHARE_PARTY_NUM; i++) {
-            servers[i]->revealTableTo(table_name, node);
+        // 如过node本身没有份额，则各server将SharePair发送给node，三方的发送互相重叠
+        std::vector<std::future<void>> responses;
+        for (int i = 0; i < SHARE_PARTY_NUM; i++) {
+            responses.push_back(servers[i]->revealTableToAsync(table_name, node));
         }
+        node->waitResponses(Command::REVEAL_TABLE, responses);
     }
 }
 
@@ -79,6 +89,105 @@ void Protocol::logicOR(std::string x_name, std::string y_name, std::string z_nam
     });
 }
 
+void Protocol::logicANDTable(std::string x_name, std::string y_name, std::string z_name) {
+    setupZeroSharing();
+    doEachAsync([&](Server* server) {
+        auto& x = server->getVar<Table>(x_name);
+        auto& y = server->getVar<Table>(y_name);
+        if (x.columns.size() != y.columns.size() || x.size() != y.size()) {
+            throw std::runtime_error("Runtime Error in Protocol::logicANDTable(): " + x_name + " and " + y_name + " have different shapes");
+        }
+        u_int next_id = (server->id + 1) % SHARE_PARTY_NUM;
+        u_int prev_id = (server->id + SHARE_PARTY_NUM - 1) % SHARE_PARTY_NUM;
+
+        // z_i = x_i y_i ⊕ x_i y_{i+1} ⊕ x_{i+1} y_i ⊕ α_i，加上零共享α_i后z_i对S_{i-1}是随机的
+        Table zi(Table::INT_MODE);
+        zi.headers = x.headers;
+        zi.share_types.assign(x.columns.size(), NO_SHARING);
+        zi.initColumns(x.size());
+        zi.is_null.clear();
+        for (size_t j = 0; j < x.columns.size(); j++) {
+            auto& z = zi.columns[j].part(0);
+            server->fillZeroShares(next_id, z);
+            const auto& x0 = x.columns[j].cpart(0);
+            const auto& x1 = x.columns[j].cpart(1);
+            const auto& y0 = y.columns[j].cpart(0);
+            const auto& y1 = y.columns[j].cpart(1);
+            for (size_t r = 0; r < z.size(); r++) {
+                z[r] ^= (x0[r] & y0[r]) ^ (x0[r] & y1[r]) ^ (x1[r] & y0[r]);
+            }
+        }
+
+        // 把z_i发给S_{i-1}，S_{i-1}收到后组成{z_{i-1}, z_i}；本方的[Z]在收到S_{i+1}的z_{i+1}后设置
+        TableMessage tmsg(server->id, prev_id, Command::RECEIVE_AND_TABLE_SHARE, z_name, server->serializeTable(Command::RECEIVE_AND_TABLE_SHARE, zi));
+        server->setVar(z_name + "_i", std::move(zi));
+        server->sendMessageAndWait(prev_id, tmsg);
+    });
+}
+
+void Protocol::logicNOTVec(std::string x_name, std::string y_name) {
+    // 自动解析y_name
+    y_name = y_name == "" ? Node::notVarName(x_name) : y_name;
+
+    doEachAsync([&](Server* server) {
+        auto y = server->getVar<std::vector<SharePair>>(x_name);
+        // 只翻转x_0：S0持有{x_0, x_1}，S2持有{x_2, x_0}
+        if (server->id == 0) {
+            for (auto& sp : y) sp[0] = ~sp[0];
+        } else if (server->id == 2) {
+            for (auto& sp : y) sp[1] = ~sp[1];
+        }
+        server->setVar(y_name, std::move(y));
+    });
+}
+
+void Protocol::logicANDVec(std::string x_name, std::string y_name, std::string z_name) {
+    setupZeroSharing();
+    doEachAsync([&](Server* server) {
+        auto& x = server->getVar<std::vector<SharePair>>(x_name);
+        auto& y = server->getVar<std::vector<SharePair>>(y_name);
+        if (x.size() != y.size()) {
+            throw std::runtime_error("Runtime Error in Protocol::logicANDVec(): " + x_name + " and " + y_name + " have different sizes");
+        }
+        u_int next_id = (server->id + 1) % SHARE_PARTY_NUM;
+        u_int prev_id = (server->id + SHARE_PARTY_NUM - 1) % SHARE_PARTY_NUM;
+
+        // 与logicANDTable相同：z_i = x_i y_i ⊕ x_i y_{i+1} ⊕ x_{i+1} y_i ⊕ α_i
+        std::vector<int> zi(x.size());
+        server->fillZeroShares(next_id, zi);
+        for (size_t k = 0; k < zi.size(); k++) {
+            zi[k] ^= (x[k][0] & y[k][0]) ^ (x[k][0] & y[k][1]) ^ (x[k][1] & y[k][0]);
+        }
+
+        // z_name可以与x_name、y_name相同：S_{i-1}要等本方设置z_i后才会覆盖[z]，此时本方已不再读取x、y
+        std::string zi_str;
+        BufferWriter writer(zi_str);
+        writer.writeInts(zi.data(), zi.size());
+        VarMessage vmsg(server->id, prev_id, Command::RECEIVE_AND_VEC_SHARE, z_name, zi_str);
+        server->setVar(z_name + "_i", std::move(zi));
+        server->sendMessageAndWait(prev_id, vmsg);
+    });
+}
+
+void Protocol::logicORVec(std::string x_name, std::string y_name, std::string z_name) {
+    std::string not_x_name = Node::notVarName(x_name);
+    std::string not_y_name = Node::notVarName(y_name);
+    std::string not_z_name = Node::notVarName(z_name);
+    this->logicNOTVec(x_name, not_x_name);
+    this->logicNOTVec(y_name, not_y_name);
+    this->logicANDVec(not_x_name, not_y_name, not_z_name);
+    this->logicNOTVec(not_z_name, z_name);
+
+    // 删除中间量
+    doEachAsync([&](Server* server) {
+        server->deleteVar(not_x_name);
+        server->deleteVar(not_y_name);
+        if (not_z_name != not_x_name && not_z_name != not_y_name) {
+            server->deleteVar(not_z_name);
+        }
+    });
+}
+
 void Protocol::subgraphMatchingOnlyMPC(const Table& query_graph, const std::string& result_name) {
     log("START PROTOCOL SUBGRAPH MATCHING ONLY WITH MPC");
 
@@ -91,11 +200,12 @@ void Protocol::subgraphMatchingOnlyMPC(const Table& query_graph, const std::stri
     auto symmetries = Utils::getSymmetries(edges);
 
     // 执行Pi+1 = Pi ⋈ pi+1, P0 = p0，pi的顺序与Q中边的顺序一致
-    for (int i = 0; i < query_graph.data.size() - 1; i++) {
+    for (int i = 0; i < query_graph.size() - 1; i++) {
+        nextRound();
         std::string ss_Pi = "[P" + std::to_string(i) + "]";
         std::string ss_pip1 = "[p" + std::to_string(i + 1) + "]";
         std::string ss_Pip1;
-        if (i == query_graph.data.size() - 2) { // 如果是最后一次，则将结果命名为result_name
+        if (i == query_graph.size() - 2) { // 如果是最后一次，则将结果命名为result_name
             ss_Pip1 = result_name;
         } else {    // 否则为Pi+1
             ss_Pip1 = "[P" + std::to_string(i + 1) + "]";
@@ -103,38 +213,29 @@ void Protocol::subgraphMatchingOnlyMPC(const Table& query_graph, const std::stri
 
         // 解析pi的表头
         std::vector<std::string> current_edge_str;
-        std::vector<std::any> current_edge = query_graph.data[i + 1];
+        std::vector<int> current_edge = query_graph.getIntRow(i + 1);
         for (const auto &v : current_edge) {
-            current_edge_str.push_back(std::to_string(std::any_cast<int>(v)));
+            current_edge_str.push_back(std::to_string(v));
+        }
+
+        // 解析P0的表头
+        std::vector<std::string> first_edge_str;
+        for (const auto &v : query_graph.getIntRow(0)) {
+            first_edge_str.push_back(std::to_string(v));
         }
 
         doEachAsync([&](Server *server) {
             auto &G = std::any_cast<Table &>(server->getVar("[G]"));
             if (N == 0) {
-                N = G.data.size();
+                N = G.size();
             }
 
+            // 待连接表都是[G]的重命名视图，与[G]共享数据
             // 第一次执行 P1 = P0(p0) ⋈ p1
             if (i == 0) {
-                // 解析P0的表头
-                std::vector<std::string> first_edge_str;
-                std::vector<std::any> first_edge = query_graph.data[0];
-                for (const auto &v : first_edge) {
-                    first_edge_str.push_back(std::to_string(std::any_cast<int>(v)));
-                }
-                // 初始化待连接表
-                Table P0(G);
-                P0.setHeaders(first_edge_str);
-                server->setVar("[P0]", P0);
-                Table p1(G);
-                p1.setHeaders(current_edge_str);
-                server->setVar("[p1]", p1);
-            } else {
-                // 初始化pi和索引
-                Table pip1(G);
-                pip1.setHeaders(current_edge_str);
-                server->setVar(ss_pip1, pip1);
+                server->renameTable("[G]", "[P0]", first_edge_str);
             }
+            server->renameTable("[G]", ss_pip1, current_edge_str);
         });
 
         // 计算Pi+1的AGM上界，Pi+1实际上是query_graph的前i+1条边构成的子图，i从0开始
@@ -142,8 +243,8 @@ void Protocol::subgraphMatchingOnlyMPC(const Table& query_graph, const std::stri
         std::vector<std::vector<int>> Pip1_edges;
         // 从 query 中提取前i+1条边
         for (int j = 0; j <= i + 1; j++) {
-            auto u = std::any_cast<int>(query_graph.data[j][0]);
-            auto v = std::any_cast<int>(query_graph.data[j][1]);
+            auto u = query_graph.getInt(j, 0);
+            auto v = query_graph.getInt(j, 1);
             Pip1_edges.push_back({u, v});
         }
 
@@ -151,10 +252,13 @@ void Protocol::subgraphMatchingOnlyMPC(const Table& query_graph, const std::stri
         start_ = std::chrono::steady_clock::now();
         // 使用第三方的安全连接功能，测试不同的连接方式和界限估计算法
         log("Start Join for " + ss_Pip1 + " = " + ss_Pi + " ⋈ " + ss_pip1);
-        if (i == 0 || !use_third_party) {
+        // [G]只重构一次，边表由ThirdParty在本地按表头构造
+        if (i == 0) {
+            this->third_party->revealRenamedTable("[G]", ss_Pi, first_edge_str);
+        } else if (!use_third_party) {
             this->third_party->revealTable(ss_Pi);
         }
-        this->third_party->revealTable(ss_pip1);
+        this->third_party->revealRenamedTable("[G]", ss_pip1, current_edge_str);
         this->third_party->join(ss_Pi, ss_pip1, ss_Pip1);
         // 记录测试后的时间
         end_ = std::chrono::steady_clock::now();
@@ -165,32 +269,36 @@ void Protocol::subgraphMatchingOnlyMPC(const Table& query_graph, const std::stri
             // 使用第三方的检查匹配结果功能
             this->third_party->checkInjectivity(ss_Pip1);
         } else {
-            // 使用匹配结果检查协议，需要先从ThirdParty拿到连接结果，然后自行处理
-            // this->third_party->shareTable(Node::extractVarName(ss_Pip1), BINARY_SHARING, servers);
-            // this->checkMatch(ss_Pip1, symmetries);
+            // 使用匹配结果检查协议：ThirdParty将连接结果共享给各Server后即删除，由各Server以MPC检查，下一轮连接前再重构
+            this->third_party->shareTable(Node::extractVarName(ss_Pip1), BINARY_SHARING, servers);
+            this->third_party->deleteVar(Node::extractVarName(ss_Pip1));
+            this->checkMatchMPC(ss_Pip1, {});
         }
 
         doEach([&](Server *server) {
-            if (i == 0) {   // 第一轮删除初始化的P0，之后的Partial Result不会传回来
+            if (i == 0 || !use_third_party) {   // 删除已由ThirdParty重构的Pi，使用ThirdParty时之后的Partial Result不会传回来
                 server->deleteVar(ss_Pi);
             }
             server->deleteVar(ss_pip1);
         });
 
-        if (i == query_graph.data.size() - 2) {     // 如果是最后一轮连接
+        if (i == query_graph.size() - 2) {     // 如果是最后一轮连接
             log("Start Symmetry Check for match " + ss_Pip1);
             if (use_third_party) {
                 // 使用第三方的检查匹配结果功能
                 this->third_party->checkSymmetry(ss_Pip1, symmetries);
                 this->third_party->shareTable(Node::extractVarName(ss_Pip1), BINARY_SHARING, servers);
+                this->third_party->deleteVar(Node::extractVarName(ss_Pip1));
             } else {
-                // 使用匹配结果检查协议，需要先从ThirdParty拿到连接结果，然后自行处理
-                this->third_party->shareTable(Node::extractVarName(ss_Pip1), BINARY_SHARING, servers);
-                this->checkMatch(ss_Pip1, symmetries);
+                // 各Server已持有连接结果，且已检查过单射性
+                this->checkMatchMPC(ss_Pip1, symmetries, false);
             }
-            this->third_party->deleteVar(Node::extractVarName(ss_Pip1));
         }
     }
+    // 释放ThirdParty缓存的[G]
+    if (this->third_party->hasVar("G")) {
+        this->third_party->deleteVar("G");
+    }
     log("END PROTOCOL SUBGRAPH MATCHING");
 
 }
@@ -208,11 +316,12 @@ void Protocol::subgraphMatchingNoJoinPlan(const Table &query_graph, const std::s
     auto symmetries = Utils::getSymmetries(edges);
 
     // 执行Pi+1 = Pi ⋈ pi+1, P0 = p0，pi的顺序与Q中边的顺序一致
-    for (int i = 0; i < query_graph.data.size() - 1; i++) {
+    for (int i = 0; i < query_graph.size() - 1; i++) {
+        nextRound();
         std::string ss_Pi = "[P" + std::to_string(i) + "]";
         std::string ss_pip1 = "[p" + std::to_string(i + 1) + "]";
         std::string ss_Pip1;
-        if (i == query_graph.data.size() - 2) { // 如果是最后一次，则将结果命名为result_name
+        if (i == query_graph.size() - 2) { // 如果是最后一次，则将结果命名为result_name
             ss_Pip1 = result_name;
         } else {    // 否则为Pi+1
             ss_Pip1 = "[P" + std::to_string(i + 1) + "]";
@@ -220,63 +329,48 @@ void Protocol::subgraphMatchingNoJoinPlan(const Table &query_graph, const std::s
 
         // 解析pi的表头
         std::vector<std::string> current_edge_str;
-        std::vector<std::any> current_edge = query_graph.data[i + 1];
+        std::vector<int> current_edge = query_graph.getIntRow(i + 1);
         for (const auto &v : current_edge) {
-            current_edge_str.push_back(std::to_string(std::any_cast<int>(v)));
+            current_edge_str.push_back(std::to_string(v));
+        }
+
+        // 解析P0的表头
+        std::vector<std::string> first_edge_str;
+        for (const auto &v : query_graph.getIntRow(0)) {
+            first_edge_str.push_back(std::to_string(v));
         }
 
         doEachAsync([&](Server *server) {
             auto &G = std::any_cast<Table &>(server->getVar("[G]"));
             if (N == 0) {
-                N = G.data.size();
+                N = G.size();
                 mf = G.max_freqs[0];
             }
 
             auto index_arr = std::any_cast<std::vector<Index>>(server->getVar("G-idx"));
 
+            // 待连接表都是[G]的重命名视图，与[G]共享数据
             // 第一次执行 P1 = P0(p0) ⋈ p1
             if (i == 0) {
-                // 解析P0的表头
-                std::vector<std::string> first_edge_str;
-                std::vector<std::any> first_edge = query_graph.data[0];
-                for (const auto &v : first_edge) {
-                    first_edge_str.push_back(std::to_string(std::any_cast<int>(v)));
-                }
-                // 初始化待连接表
-                Table P0(G);
-                P0.setHeaders(first_edge_str);
-                server->setVar("[P0]", P0);
+                server->renameTable("[G]", "[P0]", first_edge_str);
                 // 对属性a,b,ab都构建索引
-                // index_arr[0].setAttrs(P0.headers);
-                // index_arr[1].setAttrs({P0.headers[0]});
-                // index_arr[2].setAttrs({P0.headers[1]});
+                // index_arr[0].setAttrs(first_edge_str);
+                // index_arr[1].setAttrs({first_edge_str[0]});
+                // index_arr[2].setAttrs({first_edge_str[1]});
                 // 对属性a,b都构建索引
-                index_arr[0].setAttrs({P0.headers[0]});
-                index_arr[1].setAttrs({P0.headers[1]});
+                index_arr[0].setAttrs({first_edge_str[0]});
+                index_arr[1].setAttrs({first_edge_str[1]});
                 server->setVar("P0-idx", index_arr);
-                Table p1(G);
-                p1.setHeaders(current_edge_str);
-                server->setVar("[p1]", p1);
-                // index_arr[0].setAttrs(p1.headers);
-                // index_arr[1].setAttrs({p1.headers[0]});
-                // index_arr[2].setAttrs({p1.headers[1]});
-                // 对属性a,b都构建索引
-                index_arr[0].setAttrs({p1.headers[0]});
-                index_arr[1].setAttrs({p1.headers[1]});
-                server->setVar("p1-idx", index_arr);
-            } else {
-                // 初始化pi和索引
-                Table pip1(G);
-                pip1.setHeaders(current_edge_str);
-                server->setVar(ss_pip1, pip1);
-                // index_arr[0].setAttrs(pip1.headers);
-                // index_arr[1].setAttrs({pip1.headers[0]});
-                // index_arr[2].setAttrs({pip1.headers[1]});
-                // 对属性a,b都构建索引
-                index_arr[0].setAttrs({pip1.headers[0]});
-                index_arr[1].setAttrs({pip1.headers[1]});
-                server->setVar(server->extractVarName(ss_pip1) + "-idx", index_arr);
             }
+            // 初始化pi和索引
+            server->renameTable("[G]", ss_pip1, current_edge_str);
+            // index_arr[0].setAttrs(current_edge_str);
+            // index_arr[1].setAttrs({current_edge_str[0]});
+            // index_arr[2].setAttrs({current_edge_str[1]});
+            // 对属性a,b都构建索引
+            index_arr[0].setAttrs({current_edge_str[0]});
+            index_arr[1].setAttrs({current_edge_str[1]});
+            server->setVar(server->extractVarName(ss_pip1) + "-idx", index_arr);
         });
 
         // 计算Pi+1的AGM上界，Pi+1实际上是query_graph的前i+1条边构成的子图，i从0开始
@@ -284,8 +378,8 @@ void Protocol::subgraphMatchingNoJoinPlan(const Table &query_graph, const std::s
         std::vector<std::vector<int>> Pip1_edges;
         // 从 query 中提取前i+1条边
         for (int j = 0; j <= i + 1; j++) {
-            auto u = std::any_cast<int>(query_graph.data[j][0]);
-            auto v = std::any_cast<int>(query_graph.data[j][1]);
+            auto u = query_graph.getInt(j, 0);
+            auto v = query_graph.getInt(j, 1);
             Pip1_edges.push_back({u, v});
         }
         // AGM_BOUND_ = computeAGMBound(Pip1_edges, N);
@@ -296,16 +390,15 @@ void Protocol::subgraphMatchingNoJoinPlan(const Table &query_graph, const std::s
         // 使用第三方的安全连接功能，测试不同的连接方式和界限估计算法
         log("Start Join for " + ss_Pip1 + " = " + ss_Pi + " ⋈ " + ss_pip1);
 
-        if (i == 0 || !use_third_party) {
-            this->third_party->revealTable(ss_Pi);
-        }
-
-        if (i > 0) {    // 模拟MPC
+        // [G]只重构一次，边表由ThirdParty在本地按表头构造
+        if (i == 0) {
+            this->third_party->revealRenamedTable("[G]", ss_Pi, first_edge_str);
+        } else {    // 模拟MPC
             // 主动获取Pi
             this->third_party->revealTable(ss_Pi);
         }
 
-        this->third_party->revealTable(ss_pip1);
+        this->third_party->revealRenamedTable("[G]", ss_pip1, current_edge_str);
         this->third_party->bucketJoin(ss_Pi, ss_pip1, ss_Pip1, MF_BOUND);
         // 记录测试后的时间
         end_ = std::chrono::steady_clock::now();
@@ -321,11 +414,8 @@ void Protocol::subgraphMatchingNoJoinPlan(const Table &query_graph, const std::s
         if (use_third_party) {
             // 使用第三方的检查匹配结果功能
             this->third_party->checkInjectivity(ss_Pip1);
-        } else {
-            // 使用匹配结果检查协议，需要先从ThirdParty拿到连接结果，然后自行处理
-            // this->third_party->shareTable(Node::extractVarName(ss_Pip1), BINARY_SHARING, servers);
-            // this->checkMatch(ss_Pip1, symmetries);
         }
+        // 不使用ThirdParty时，在各Server拿到连接结果后以MPC检查
 
         doEach([&](Server *server) {
             if (i == 0) {   // 第一轮删除初始化的P0，之后的Partial Result不会传回来
@@ -334,7 +424,7 @@ void Protocol::subgraphMatchingNoJoinPlan(const Table &query_graph, const std::s
             server->deleteVar(ss_pip1);
         });
 
-        if (i == query_graph.data.size() - 2) {     // 如果是最后一轮连接
+        if (i == query_graph.size() - 2) {     // 如果是最后一轮连接
             log("Start Symmetry Check for match " + ss_Pip1);
             if (use_third_party) {
                 // 使用第三方的检查匹配结果功能
@@ -343,7 +433,7 @@ void Protocol::subgraphMatchingNoJoinPlan(const Table &query_graph, const std::s
             } else {
                 // 使用匹配结果检查协议，需要先从ThirdParty拿到连接结果，然后自行处理
                 this->third_party->shareTable(Node::extractVarName(ss_Pip1), BINARY_SHARING, servers);
-                this->checkMatch(ss_Pip1, symmetries);
+                this->checkMatchMPC(ss_Pip1, symmetries);
             }
             this->third_party->deleteVar(Node::extractVarName(ss_Pip1));
         }
@@ -351,8 +441,15 @@ void Protocol::subgraphMatchingNoJoinPlan(const Table &query_graph, const std::s
         else {      // 模拟MPC
             this->third_party->shareTable(Node::extractVarName(ss_Pip1), BINARY_SHARING, servers);
             this->third_party->deleteVar(Node::extractVarName(ss_Pip1));
+            if (!use_third_party) {
+                this->checkMatchMPC(ss_Pip1, {});
+            }
         }
     }
+    // 释放ThirdParty缓存的[G]
+    if (this->third_party->hasVar("G")) {
+        this->third_party->deleteVar("G");
+    }
     log("END PROTOCOL SUBGRAPH MATCHING");
 }
 
@@ -369,6 +466,7 @@ void Protocol::subgraphMatching(const Table& query_graph, const std::string& res
 
     // --------------------- PHASE 1: STAR DECOMPOSITION ---------------------
     log("PHASE 1: STAR DECOMPOSITION");
+    beginPhase("star decomposition");
 
     std::vector<Utils::StarGraph> stars;
     // 将query分解为一系列星型子图
@@ -387,6 +485,7 @@ void Protocol::subgraphMatching(const Table& query_graph, const std::string& res
 
     // --------------------- PHASE 2: STAR MATCHING ---------------------
     log("PHASE 2: STAR MATCHING");
+    beginPhase("star matching");
 
     // 计算query的对称节点
     std::ostringstream symmetries_oss;     // 用于接收对称节点打印
@@ -397,6 +496,7 @@ void Protocol::subgraphMatching(const Table& query_graph, const std::string& res
     // 执行 stari+1 = stari ⋈ ei+1，i = {1, ..., biggest.size()}，star1 = e1，ei表示biggest中的第i条边，索引从1开始
     log("Start Multi-round BucktJoin");
     for (int i = 1; i < biggest.size(); i++) {
+        nextRound();
         // 解析每一轮构建星型子图的变量名
         std::string ss_stari = "[star" + std::to_string(i) + "]";
         std::string ss_eip1 = "[e" + std::to_string(i + 1) + "]";
@@ -408,25 +508,23 @@ void Protocol::subgraphMatching(const Table& query_graph, const std::string& res
         if (i == 1) {
             log("Initialing " + ss_stari + " as [e1]");
         }
+        // 解析 ei+1 的表头 ei+1 = (root, neighbors[i])，注意e是从1开始计数，neighbors数组本身是从0开始计数
+        std::vector<std::string> current_edge_str = {std::to_string(biggest.root), std::to_string(biggest.neighbors[i])};
+        // 第一轮连接还需要star1，即e1的表头
+        std::vector<std::string> first_edge_str = {std::to_string(biggest.root), std::to_string(biggest.neighbors[0])};
+
         doEachAsync([&](Server* server) {
             auto& G = std::any_cast<Table&>(server->getVar("[G]"));
             if (N == 0) {
-                N = G.data.size();
+                N = G.size();
                 mf = G.max_freqs[0];
             }
             auto index_arr = std::any_cast<std::vector<Index>>(server->getVar("G-idx"));
 
-            // 解析 ei+1 的表头 ei+1 = (root, neighbors[i])，注意e是从1开始计数，neighbors数组本身是从0开始计数
-            std::vector<std::string> current_edge_str = {std::to_string(biggest.root), std::to_string(biggest.neighbors[i])};
-
-            // 如果是第一轮连接，则需要额外解析star1，即e1的表头
+            // 待连接表都是[G]的重命名视图，与[G]共享数据
             if (i == 1) {
-                std::vector<std::string> first_edge_str = {std::to_string(biggest.root), std::to_string(biggest.neighbors[i - 1])};
-
                 // 初始化待连接表star1
-                Table S1(G);
-                S1.setHeaders(first_edge_str);
-                server->setVar(ss_stari, S1);
+                server->renameTable("[G]", ss_stari, first_edge_str);
                 // 构建索引，由于星型连接的连接键仅为root节点，故只对root构建索引
                 auto root_index = index_arr[1];     // 0是(u,v)二维索引，1和2分别对应u和v的一维索引
                 root_index.setAttrs({first_edge_str[0]});
@@ -434,9 +532,7 @@ void Protocol::subgraphMatching(const Table& query_graph, const std::string& res
             }
 
             // 如果不是第一轮连接，则仅需要初始化待连接表ei+1即可
-            Table eip1(G);
-            eip1.setHeaders(current_edge_str);
-            server->setVar(ss_eip1, eip1);
+            server->renameTable("[G]", ss_eip1, current_edge_str);
             // 构建索引
             auto root_index = index_arr[1];
             root_index.setAttrs({current_edge_str[0]});
@@ -446,24 +542,29 @@ void Protocol::subgraphMatching(const Table& query_graph, const std::string& res
         // 记录测试前的时间
         start_ = std::chrono::steady_clock::now();
         // 使用第三方的安全BucketJoin连接功能
-        if (i == 1 || !use_third_party) {   // 如果是第一轮连接，则需要传递，否则ThirdParty本地有保存
+        // [G]只在第一轮重构一次，star1和各ei+1都由ThirdParty在本地按表头构造
+        if (i == 1) {
+            this->third_party->revealRenamedTable("[G]", ss_stari, first_edge_str);
+        } else if (!use_third_party) {  // 否则ThirdParty本地有保存
             this->third_party->revealTable(ss_stari);
         }
-        this->third_party->revealTable(ss_eip1);
+        this->third_party->revealRenamedTable("[G]", ss_eip1, current_edge_str);
         this->third_party->bucketJoin(ss_stari, ss_eip1, ss_starip1, MIX_BOUND);
         // 记录测试后的时间
         end_ = std::chrono::steady_clock::now();
         log("Time cost: " + std::to_string(getDuration()) + " ms");
         
         log("Injectivity Check for match " + ss_starip1);
+        beginPhase("checks");
         if (use_third_party) {
             // 使用第三方的匹配结果检查功能，Servers保存Check后的中间星型结果
             this->third_party->checkInjectivity(ss_starip1); 
         } else {
-            // 使用匹配结果检查协议，需要先从ThirdParty拿到连接结果，然后自行处理
-            // this->third_party->shareTable(Node::extractVarName(ss_starip1), BINARY_SHARING, this->servers);
-            // this->checkMatch(ss_starip1, symmetries);
+            // 使用匹配结果检查协议：ThirdParty将连接结果共享给各Server，由各Server以MPC检查，下一轮连接前再重构
+            this->third_party->shareTable(Node::extractVarName(ss_starip1), BINARY_SHARING, this->servers);
+            this->checkMatchMPC(ss_starip1, {});
         }
+        beginPhase("star matching");
 
         // 拓扑复用
         // 检查stars中是否有当前size的star
@@ -499,14 +600,19 @@ void Protocol::subgraphMatching(const Table& query_graph, const std::string& res
             server->deleteVar(ss_eip1);
         });
 
-        // ThirdParty 删除连接结果
-        if (i == biggest.size() - 1) {
+        // ThirdParty 删除连接结果，不使用ThirdParty检查时各Server已持有该结果
+        if (i == biggest.size() - 1 || !use_third_party) {
             this->third_party->deleteVar(Node::extractVarName(ss_starip1));
         }
     }
+    // 释放ThirdParty缓存的[G]
+    if (this->third_party->hasVar("G")) {
+        this->third_party->deleteVar("G");
+    }
 
     // --------------------- PHASE 3: STAR ASSEMBLY ---------------------
     log("PHASE 3: STAR ASSEMBLY");
+    beginPhase("star assembly");
     // 处理完stars的匹配结果后，开始执行普通连接
     // 如果星型子图数量大于1，则计算 stars 之间的连接次序
     if (stars.size() > 1) {
@@ -527,6 +633,7 @@ void Protocol::subgraphMatching(const Table& query_graph, const std::string& res
         // 按照stars_sorted中次序依次连接星型子图
         log("Start Multi-round Join");
         for (int i = 0; i < stars_sorted.size() - 1; i++) {
+            nextRound();
             log("Round " + std::to_string(i + 1) + ": " + result_name + " = " + result_name + " ⋈ " + "[star" + std::to_string(stars_sorted[i + 1].size()) + "]");
 
             // 如果i = 0，额外初始化结果表为stars_sorted[0]
@@ -579,14 +686,17 @@ void Protocol::subgraphMatching(const Table& query_graph, const std::string& res
             log("Time cost: " + std::to_string(getDuration()) + " ms");
 
             log("Injectivity Check for match " + result_name);
+            beginPhase("checks");
             if (use_third_party) {
                 // 使用第三方的匹配结果检查功能
                 this->third_party->checkInjectivity(result_name);
             } else {
-                // 使用匹配结果检查协议，需要先从ThirdParty拿到连接结果，然后自行处理 
-                // this->third_party->shareTable(Node::extractVarName(result_name), BINARY_SHARING, servers);
-                // this->checkMatch(result_name, symmetries);
+                // 使用匹配结果检查协议：ThirdParty将连接结果共享给各Server后即删除，由各Server以MPC检查，下一轮连接前再重构
+                this->third_party->shareTable(Node::extractVarName(result_name), BINARY_SHARING, servers);
+                this->third_party->deleteVar(Node::extractVarName(result_name));
+                this->checkMatchMPC(result_name, {});
             }
+            beginPhase("star assembly");
 
             // // ThirdParty 共享并删除连接结果
             // if (i == stars_sorted.size() - 2) {
@@ -607,16 +717,19 @@ void Protocol::subgraphMatching(const Table& query_graph, const std::string& res
     }
 
     log("Symmetry Check for match " + result_name);
+    beginPhase("checks");
     if (use_third_party) {
         // 使用第三方的匹配结果检查功能
         this->third_party->checkSymmetry(result_name, symmetries);
         this->third_party->shareTable(Node::extractVarName(result_name), BINARY_SHARING, servers);
+        this->third_party->deleteVar(Node::extractVarName(result_name));
     } else {
-        // 使用匹配结果检查协议，需要先从ThirdParty拿到连接结果，然后自行处理
-        this->third_party->shareTable(Node::extractVarName(result_name), BINARY_SHARING, servers);
-        this->checkMatch(result_name, symmetries);
+        // 使用匹配结果检查协议，各Server已持有连接结果，且已检查过单射性
+        if (this->third_party->hasVar(Node::extractVarName(result_name))) {
+            this->third_party->deleteVar(Node::extractVarName(result_name));
+        }
+        this->checkMatchMPC(result_name, symmetries, false);
     }
-    this->third_party->deleteVar(Node::extractVarName(result_name));
 
     // 最后，删除所有中间star匹配结果
     log("Deleting intermediate vars");
@@ -626,156 +739,120 @@ void Protocol::subgraphMatching(const Table& query_graph, const std::string& res
         }
     });
 
+    endPhase();
     log("END PROTOCOL SUBGRAPH MATCHING");
 }
 
 void Protocol::checkMatch(std::string table_name, std::vector<std::vector<int>> symmetries) {
     log("START PROTOCOL CONSTRAINT VERIFICATION");
-    // 获取table的size
-    int table_size = std::any_cast<Table>(servers[0]->getVar(table_name)).data.size();
+    // 获取table的size，并找出有效的对称组：symmetries中存的是节点的id，只保留存在于当前子匹配中的节点映射，至少两列才需要检查
+    size_t table_size;
+    std::vector<std::vector<std::string>> symmetry_groups;
+    {
+        const auto& t = servers[0]->getVar<Table>(table_name);
+        table_size = t.size();
+        for (const auto& symmetry : symmetries) {
+            std::vector<std::string> group;
+            for (const auto& node_id : symmetry) {
+                if (t.getColumnIdx(std::to_string(node_id)) != -1) {
+                    group.push_back(std::to_string(node_id));
+                }
+            }
+            if (group.size() > 1) {
+                symmetry_groups.push_back(group);
+            }
+        }
+    }
 
-    // 逐行进行匹配约束检查
-    for (int row_idx = 0; row_idx < table_size; row_idx++) {
-        // log("check " + std::to_string(row_idx) + " rows");
-        // 1 重复约束检查
-        
-        // 使用Sort指令获得perm：发送table.data[i] = "[A]"，获得"[Pi]"
+    // 发送 (CMD_ROWS, [M]) 指令给ThirdParty，[M]的每一行分别计算，结果表存为result_name
+    auto rowsCommand = [&](u_int command, const std::string& arg_name, const std::string& result_name) {
         doEachAsync([&](Server* server) {
-            // 获取要检查的table
-            auto& t = std::any_cast<Table&>(server->getVar(table_name));
-            // 获取table的第i行数据
-            std::vector<SharePair> A;
-            for (auto& item : t.data[row_idx]) {
-                A.push_back(std::any_cast<SharePair>(item));
-            }
-            server->setVar("[A]", A);
-            // 发送 (SORT, [A]) 指令给ThirdParty
-            VarMessage vmsg(server->id, third_party->id, Command::SORT_VECTOR, "[A]", SPs2String(A), "[Pi]");
+            auto& M = server->getVar<Table>(arg_name);
+            VarMessage vmsg(server->id, third_party->id, command, arg_name, server->serializeTable(command, M), result_name);
             server->sendMessageAndWait(third_party->id, vmsg);
         });
+    };
 
-        // 使用Perm指令对该行数据进行排序：发送"[Pi]", "[A]"，获得"[A']"
+    // 按行块批量检查，每块的往返次数固定，与行数无关
+    for (size_t start = 0; start < table_size; start += CHECK_BLOCK_ROWS) {
+        size_t end = std::min(table_size, start + CHECK_BLOCK_ROWS);
+        // 取出当前行块作为[A]，每一行是一个待检查的匹配
         doEachAsync([&](Server* server) {
-            // 获取对应table的第i行数据的perm
-            auto& Pi = std::any_cast<std::vector<SharePair>&>(server->getVar("[Pi]"));
-            // 获取table的第i行数据
-            auto& A = std::any_cast<std::vector<SharePair>&>(server->getVar("[A]"));
-            // 发送 (PERM, [Pi], [A]) 指令给ThirdParty
-            VarsMessage vsmsg(server->id, third_party->id, Command::PERM_VECTOR, {
-                {"[Pi]", SPs2String(Pi)},
-                {"[A]", SPs2String(A)}
-            }, "[A']");
-            server->sendMessageAndWait(third_party->id, vsmsg);
+            Table A = server->getVar<Table>(table_name).slice(start, end);
+            A.is_null.clear();
+            server->setVar("[A]", std::move(A));
         });
 
-        // 使用CompareNeighbor指令进行相邻对比：发送"[A']"，获得 "[D]"
-        doEachAsync([&](Server* server) {
-            // 获取排序后的[A']
-            auto& A_prime = std::any_cast<std::vector<SharePair>&>(server->getVar("[A']"));
-            // 发送 (CPN_EQU, [A]) 指令给ThirdParty
-            VarMessage vmsg(server->id, third_party->id, Command::COMPARE_NEIGHBOR_EQ, "[A']", SPs2String(A_prime), "[D]");
-            server->sendMessageAndWait(third_party->id, vmsg);
-        });
+        // 1 重复约束检查
+        // 使用SORT_ROWS指令获得各行的perm：发送"[A]"，获得"[Pi]"
+        rowsCommand(Command::SORT_ROWS, "[A]", "[Pi]");
 
-        // 使用 OR_VEC 指令对向量求析取：发送 "[D]"，获得 "[d]"
+        // 使用PERM_ROWS指令对各行数据进行排序：发送"[Pi]", "[A]"，获得"[A']"
         doEachAsync([&](Server* server) {
-            // 获取标识符向量
-            auto& D = std::any_cast<std::vector<SharePair>&>(server->getVar("[D]"));
-            // 发送 (ORV, [D]) 指令给ThirdParty
-            VarMessage vmsg(server->id, third_party->id, Command::OR_VECTOR, "[D]", SPs2String(D), "[d]");
-            server->sendMessageAndWait(third_party->id, vmsg);
+            auto& Pi = server->getVar<Table>("[Pi]");
+            auto& A = server->getVar<Table>("[A]");
+            VarsMessage vsmsg(server->id, third_party->id, Command::PERM_ROWS, {
+                {"[Pi]", server->serializeTable(Command::PERM_ROWS, Pi)},
+                {"[A]", server->serializeTable(Command::PERM_ROWS, A)}
+            }, "[A']");
+            server->sendMessageAndWait(third_party->id, vsmsg);
         });
-        
-        // 2 对称约束检查
-        // 初始化symmetries中每一个对称组，并执行相邻大于比较
-        std::vector<int> valid_symmetry_group_idx; // 记录有效对称组的索引
-        // 如果存在对称节点的话才做
-        if (symmetries.size() != 0) {
-            for (int i = 0; i < symmetries.size(); i++) {
-                // 依次处理每个对称组
-                doEachAsync([&](Server *server) {
-                    // 获取table，用于计算各点对应的列idx
-                    auto &t = std::any_cast<Table &>(server->getVar(table_name));
-                    // 获取table的第i行数据，即要处理的向量[A]
-                    auto &A = std::any_cast<std::vector<SharePair> &>(server->getVar("[A]"));
-                    // 提取改对称组
-                    std::vector<SharePair> P_i;
-                    for (const auto &node_id : symmetries[i]) { // symmetries中存的是节点的id，并不是列号
-                        auto col_idx = t.getColumnIdx(std::to_string(node_id));
-                        if (col_idx != -1) { // 提取对称组中存在于当前子匹配的节点映射
-                            P_i.push_back(A[col_idx]);
-                        }
-                    }
-                    // 使用CompareNeighbor_asc指令进行相邻大于对比：发送"[P_i]"，获得"[E_i]"，E_i[j] = 1 表示 A[j-1] >
-                    // A[j]
-                    if (P_i.size() > 1) {
-                        VarMessage vmsg(server->id, third_party->id, Command::COMPARE_NEIGHBOR_GT,
-                                        "[G_" + std::to_string(i) + "]", SPs2String(P_i),
-                                        "[E_" + std::to_string(i) + "]");
-                        server->sendMessageAndWait(third_party->id, vmsg);
-                        // Server0辅助Protocol存储有效的对称组索引
-                        if (server->id == 0) {
-                            valid_symmetry_group_idx.push_back(i);
-                        }
-                    }
-                });
 
-                if (valid_symmetry_group_idx.back() == i) { // 如果当前对称组有效
-                    // 将大于比较的结果求析取：发送 "[E_i]" 获得 "[e_i]"
-                    doEachAsync([&](Server *server) {
-                        // 获取相邻比较的输出[E_i]
-                        auto &E_i =
-                            std::any_cast<std::vector<SharePair> &>(server->getVar("[E_" + std::to_string(i) + "]"));
-                        // 使用 OR_VEC 指令对向量求析取：发送 "[E_i]"，获得 "[e_i]"
-                        VarMessage vmsg(server->id, third_party->id, Command::OR_VECTOR,
-                                        "[E_" + std::to_string(i) + "]", SPs2String(E_i),
-                                        "[e_" + std::to_string(i) + "]");
-                        server->sendMessageAndWait(third_party->id, vmsg);
-                    });
-                }
-            }
+        // 使用COMPARE_NEIGHBOR_EQ_ROWS指令进行各行相邻对比：发送"[A']"，获得"[D]"
+        rowsCommand(Command::COMPARE_NEIGHBOR_EQ_ROWS, "[A']", "[D]");
+
+        // 使用OR_ROWS指令对各行求析取：发送"[D]"，获得单列的"[d]"
+        rowsCommand(Command::OR_ROWS, "[D]", "[d]");
 
-            // 使用 OR_VEC 指令对向量求析取：发送 "[E]"，获得 "[e]"，其中 [E] = {[e_1], [e_2], ...}
-            doEachAsync([&](Server *server) {
-                // 将 [e_i] 组合成数组 [E]
-                std::vector<SharePair> E;
-                // 对有效的对称组比较结果操作
-                for (int i = 0; i < valid_symmetry_group_idx.size(); i++) {
-                    auto &e_i = std::any_cast<SharePair &>(
-                        server->getVar("[e_" + std::to_string(valid_symmetry_group_idx[i]) + "]"));
-                    E.push_back(e_i);
+        // 2 对称约束检查
+        for (size_t g = 0; g < symmetry_groups.size(); g++) {
+            std::string G_name = "[G_" + std::to_string(g) + "]";
+            std::string E_name = "[E_" + std::to_string(g) + "]";
+            std::string e_name = "[e_" + std::to_string(g) + "]";
+            // 提取该对称组的各列
+            doEachAsync([&](Server* server) {
+                Table G = server->getVar<Table>("[A]").select(symmetry_groups[g]);
+                G.is_null.clear();
+                server->setVar(G_name, std::move(G));
+            });
+            // 相邻大于对比：发送"[G_g]"，获得"[E_g]"，E_g[r][j] = 1 表示 G_g[r][j-1] > G_g[r][j]
+            rowsCommand(Command::COMPARE_NEIGHBOR_GT_ROWS, G_name, E_name);
+            // 将大于比较的结果求析取：发送"[E_g]"，获得"[e_g]"
+            rowsCommand(Command::OR_ROWS, E_name, e_name);
+        }
+
+        if (!symmetry_groups.empty()) {
+            // 将各组的[e_g]按列组合成[E]，求析取获得"[e]"
+            doEachAsync([&](Server* server) {
+                Table E(Table::SHARE_PAIR_MODE);
+                E.is_null.clear();
+                for (size_t g = 0; g < symmetry_groups.size(); g++) {
+                    auto& e_g = server->getVar<Table>("[e_" + std::to_string(g) + "]");
+                    E.addColumn("e_" + std::to_string(g), BINARY_SHARING, e_g.columns[0]);
                 }
-                VarMessage vmsg(server->id, third_party->id, Command::OR_VECTOR, "[E]", SPs2String(E), "[e]");
-                server->sendMessageAndWait(third_party->id, vmsg);
+                server->setVar("[E]", std::move(E));
             });
+            rowsCommand(Command::OR_ROWS, "[E]", "[e]");
         }
 
+        // 使用计算出的[d]、[e]以及原本的isNull，更新当前行块的isNull
         doEachAsync([&](Server* server) {
-            auto& t = std::any_cast<Table&>(server->getVar(table_name));
-            auto is_null = std::any_cast<SharePair&>(t.is_null[row_idx]);
-
-            if (symmetries.size() != 0) {
-                // 使用计算出的[d]和[e]以及原本的isNull，更新isNull[row_idx]
-                auto &d = std::any_cast<SharePair &>(server->getVar("[d]"));
-                auto &e = std::any_cast<SharePair &>(server->getVar("[e]"));
-
-                VarMessage vmsg(server->id, third_party->id, Command::OR_VECTOR, "", SPs2String({d, e, is_null}),
-                                "[isNull]");
-                server->sendMessageAndWait(third_party->id, vmsg);
-            } else {
-                // 使用计算出的[d]以及原本的isNull，更新isNull[row_idx]
-                auto &d = std::any_cast<SharePair &>(server->getVar("[d]"));
-
-                VarMessage vmsg(server->id, third_party->id, Command::OR_VECTOR, "", SPs2String({d, is_null}),
-                                "[isNull]");
-                server->sendMessageAndWait(third_party->id, vmsg);
+            Table F = server->getVar<Table>("[d]");
+            if (!symmetry_groups.empty()) {
+                F.addColumn("e", BINARY_SHARING, server->getVar<Table>("[e]").columns[0]);
             }
-            
-            auto new_is_null = std::any_cast<SharePair>(server->getVar("[isNull]"));
-            // 更新t.isNull[row_idx]的值
-            t.is_null[row_idx] = new_is_null;
+            BitColumn is_null;
+            is_null.append(server->getVar<Table>(table_name).is_null, start, end);
+            F.addColumn("isNull", BINARY_SHARING, is_null.toColumn());
+            server->setVar("[F]", std::move(F));
+            VarMessage vmsg(server->id, third_party->id, Command::OR_ROWS, "[F]", server->serializeTable(Command::OR_ROWS, server->getVar<Table>("[F]")), "[isNull]");
+            server->sendMessageAndWait(third_party->id, vmsg);
+
+            // 写回t.isNull[start, end)
+            const Column& new_is_null = server->getVar<Table>("[isNull]").columns[0];
+            server->getVar<Table>(table_name).is_null.assign(start, BitColumn::fromColumn(new_is_null));
         });
-        
+
         // 删除所有的中间变量
         doEachAsync([&](Server* server) {
             server->deleteVar("[A]");
@@ -783,24 +860,292 @@ void Protocol::checkMatch(std::string table_name, std::vector<std::vector<int>>
             server->deleteVar("[A']");
             server->deleteVar("[D]");
             server->deleteVar("[d]");
-            if (symmetries.size() != 0) {
-                for (int i = 0; i < valid_symmetry_group_idx.size(); i++) {
-                    server->deleteVar("[E_" + std::to_string(valid_symmetry_group_idx[i]) + "]");
-                    server->deleteVar("[e_" + std::to_string(valid_symmetry_group_idx[i]) + "]");
-                }
+            for (size_t g = 0; g < symmetry_groups.size(); g++) {
+                server->deleteVar("[G_" + std::to_string(g) + "]");
+                server->deleteVar("[E_" + std::to_string(g) + "]");
+                server->deleteVar("[e_" + std::to_string(g) + "]");
+            }
+            if (!symmetry_groups.empty()) {
+                server->deleteVar("[E]");
                 server->deleteVar("[e]");
             }
+            server->deleteVar("[F]");
             server->deleteVar("[isNull]");
         });
-        log_process(row_idx + 1, table_size);
+        log_process(end, table_size);
+    }
+}
+
+// 布尔共享列的本地运算：S_i持有{x_i, x_{i+1}}，异或、移位以及与公开常数求与都在两个分量上分别计算即可
+static Column xorColumn(const Column& a, const Column& b) {
+    Column c(2, a.size());
+    for (u_int k = 0; k < 2; k++) {
+        auto& dst = c.part(k);
+        const auto& pa = a.cpart(k);
+        const auto& pb = b.cpart(k);
+        for (size_t r = 0; r < dst.size(); r++) {
+            dst[r] = pa[r] ^ pb[r];
+        }
+    }
+    return c;
+}
+
+// 取非只需翻转x_0：S_0翻转第0个分量，S_2翻转第1个分量
+static Column notColumn(const Column& a, u_int party) {
+    Column c = a;
+    if (party == 0 || party == 2) {
+        for (auto& v : c.part(party == 0 ? 0 : 1)) {
+            v = ~v;
+        }
+    }
+    return c;
+}
+
+// 按32位无符号数逻辑移位，shift > 0右移，shift < 0左移
+static Column shiftColumn(const Column& a, int shift) {
+    Column c(2, a.size());
+    for (u_int k = 0; k < 2; k++) {
+        auto& dst = c.part(k);
+        const auto& src = a.cpart(k);
+        for (size_t r = 0; r < dst.size(); r++) {
+            uint32_t v = static_cast<uint32_t>(src[r]);
+            dst[r] = static_cast<int>(shift >= 0 ? v >> shift : v << -shift);
+        }
+    }
+    return c;
+}
+
+static Column maskColumn(const Column& a, uint32_t mask) {
+    Column c(2, a.size());
+    for (u_int k = 0; k < 2; k++) {
+        auto& dst = c.part(k);
+        const auto& src = a.cpart(k);
+        for (size_t r = 0; r < dst.size(); r++) {
+            dst[r] = static_cast<int>(static_cast<uint32_t>(src[r]) & mask);
+        }
     }
+    return c;
+}
+
+// 以若干布尔共享列构造logicANDTable的输入表
+static Table wireTable(std::vector<Column> columns) {
+    Table t(Table::SHARE_PAIR_MODE);
+    for (size_t j = 0; j < columns.size(); j++) {
+        t.headers.push_back(std::to_string(j));
+        t.share_types.push_back(BINARY_SHARING);
+    }
+    t.columns = std::move(columns);
+    t.is_null.clear();
+    return t;
+}
+
+void Protocol::setupZeroSharing() {
+    doEachAsync([&](Server* server) {
+        server->sendZeroSeed((server->id + SHARE_PARTY_NUM - 1) % SHARE_PARTY_NUM);
+    });
+}
+
+void Protocol::checkMatchMPC(std::string table_name, std::vector<std::vector<int>> symmetries, bool check_injectivity) {
+    log("START PROTOCOL CONSTRAINT VERIFICATION WITH MPC");
+    // 需要比较的列对(p, q)：单射性比较所有两列是否相等；对称性要求对称组中相邻两列v[p] < v[q]，ordered表示需要检查v[p] >= v[q]
+    struct ColumnPair {
+        int p;
+        int q;
+        bool ordered;
+    };
+    std::vector<ColumnPair> pairs;
+    size_t table_size;
+    {
+        const auto& t = servers[0]->getVar<Table>(table_name);
+        table_size = t.size();
+        std::map<std::pair<int, int>, size_t> pair_idx;
+        if (check_injectivity) {
+            for (int p = 0; p < static_cast<int>(t.columns.size()); p++) {
+                for (int q = p + 1; q < static_cast<int>(t.columns.size()); q++) {
+                    pair_idx[{p, q}] = pairs.size();
+                    pairs.push_back({p, q, false});
+                }
+            }
+        }
+        for (const auto& symmetry : symmetries) {
+            // symmetries中存的是节点的id，只比较存在于当前子匹配中的节点映射
+            std::vector<int> indices;
+            for (const auto& node_id : symmetry) {
+                int idx = t.getColumnIdx(std::to_string(node_id));
+                if (idx != -1) {
+                    indices.push_back(idx);
+                }
+            }
+            for (size_t j = 0; j + 1 < indices.size(); j++) {
+                int p = indices[j], q = indices[j + 1];
+                auto key = std::minmax(p, q);
+                auto it = pair_idx.find(key);
+                if (it != pair_idx.end()) {     // 大于等于已包含相等
+                    pairs[it->second] = {p, q, true};
+                } else {
+                    pair_idx[key] = pairs.size();
+                    pairs.push_back({p, q, true});
+                }
+            }
+        }
+    }
+    if (table_size == 0 || pairs.empty()) {
+        return;
+    }
+    std::vector<size_t> ordered_idx;
+    for (size_t k = 0; k < pairs.size(); k++) {
+        if (pairs[k].ordered) {
+            ordered_idx.push_back(k);
+        }
+    }
+    size_t np = pairs.size();
+    size_t ns = ordered_idx.size();
+
+    // 1 比较电路，所有行、所有列对在同一轮中计算
+    // 每一位上：E = ~(v[p] ⊕ v[q]) 表示该位相等，G = v[p] ∧ ~v[q] 表示该位上v[p]更大
+    // 第j层合并跨度s = 2^j的相邻两段：G ← G_高 ⊕ (E_高 ∧ G_低)，E ← E_高 ∧ E_低，其中两项互斥，或可以用异或代替
+    // 5层之后第0位即为整个32位字的比较结果：E为v[p] == v[q]，G为v[p] > v[q]
+    doEachAsync([&](Server* server) {
+        const auto& t = server->getVar<Table>(table_name);
+        std::vector<Column> E, X, Y;
+        for (const auto& pair : pairs) {
+            E.push_back(notColumn(xorColumn(t.columns[pair.p], t.columns[pair.q]), server->id));
+        }
+        for (size_t k : ordered_idx) {
+            X.push_back(t.columns[pairs[k].p]);
+            Y.push_back(notColumn(t.columns[pairs[k].q], server->id));
+        }
+        server->setVar("[E]", wireTable(std::move(E)));
+        if (ns > 0) {
+            server->setVar("[X]", wireTable(std::move(X)));
+            server->setVar("[Y]", wireTable(std::move(Y)));
+        }
+    });
+    if (ns > 0) {
+        logicANDTable("[X]", "[Y]", "[GT]");
+    }
+
+    for (int shift = 1; shift < 32; shift <<= 1) {
+        // 本轮的与门：E ∧ (E >> s)，以及有序列对的 (E >> s) ∧ G
+        doEachAsync([&](Server* server) {
+            auto& E = server->getVar<Table>("[E]");
+            std::vector<Column> X, Y;
+            for (size_t k = 0; k < np; k++) {
+                X.push_back(E.columns[k]);
+                Y.push_back(shiftColumn(E.columns[k], shift));
+            }
+            if (ns > 0) {
+                auto& G = server->getVar<Table>("[GT]");
+                for (size_t j = 0; j < ns; j++) {
+                    X.push_back(shiftColumn(E.columns[ordered_idx[j]], shift));
+                    Y.push_back(G.columns[j]);
+                }
+            }
+            server->setVar("[X]", wireTable(std::move(X)));
+            server->setVar("[Y]", wireTable(std::move(Y)));
+        });
+        logicANDTable("[X]", "[Y]", "[Z]");
+        doEachAsync([&](Server* server) {
+            auto& Z = server->getVar<Table>("[Z]");
+            std::vector<Column> E(Z.columns.begin(), Z.columns.begin() + np);
+            if (ns > 0) {
+                auto& G = server->getVar<Table>("[GT]");
+                std::vector<Column> G_next;
+                for (size_t j = 0; j < ns; j++) {
+                    G_next.push_back(xorColumn(shiftColumn(G.columns[j], shift), Z.columns[np + j]));
+                }
+                server->setVar("[GT]", wireTable(std::move(G_next)));
+            }
+            server->setVar("[E]", wireTable(std::move(E)));
+            server->deleteVar("[X]");
+            server->deleteVar("[Y]");
+            server->deleteVar("[Z]");
+        });
+    }
+
+    // 2 各行的违规标志：单射性为相等E，对称性为大于等于G ⊕ E，再加上原本的isNull
+    // 标志都在第0位，按32个一组左移到不同的位上异或即打包进一个字，打包后取非，OR(f) = ~AND(~f)，未使用的位取非后为1，不影响求与
+    size_t flag_num = np + 1;
+    size_t word_num = (flag_num + 31) / 32;
+    doEachAsync([&](Server* server) {
+        auto& E = server->getVar<Table>("[E]");
+        std::vector<Column> flags;
+        for (size_t k = 0; k < np; k++) {
+            flags.push_back(maskColumn(E.columns[k], 1));
+        }
+        if (ns > 0) {
+            auto& G = server->getVar<Table>("[GT]");
+            for (size_t j = 0; j < ns; j++) {
+                flags[ordered_idx[j]] = maskColumn(xorColumn(G.columns[j], E.columns[ordered_idx[j]]), 1);
+            }
+        }
+        flags.push_back(server->getVar<Table>(table_name).is_null.toColumn());
+
+        std::vector<Column> words(word_num, Column(2, table_size));
+        for (size_t f = 0; f < flag_num; f++) {
+            words[f / 32] = xorColumn(words[f / 32], shiftColumn(flags[f], -static_cast<int>(f % 32)));
+        }
+        for (auto& word : words) {
+            word = notColumn(word, server->id);
+        }
+        server->setVar("[W]", wireTable(std::move(words)));
+        server->deleteVar("[E]");
+        if (ns > 0) {
+            server->deleteVar("[GT]");
+        }
+    });
+
+    // 3 求与：先把多个字两两合并为一个字，再在字内按移位跨度1, 2, 4, ...合并
+    while (word_num > 1) {
+        size_t half = word_num / 2;
+        doEachAsync([&](Server* server) {
+            auto& W = server->getVar<Table>("[W]");
+            server->setVar("[X]", wireTable(std::vector<Column>(W.columns.begin(), W.columns.begin() + half)));
+            server->setVar("[Y]", wireTable(std::vector<Column>(W.columns.begin() + half, W.columns.begin() + 2 * half)));
+        });
+        logicANDTable("[X]", "[Y]", "[Z]");
+        doEachAsync([&](Server* server) {
+            auto& W = server->getVar<Table>("[W]");
+            std::vector<Column> words = server->getVar<Table>("[Z]").columns;
+            if (word_num % 2 == 1) {
+                words.push_back(W.columns.back());
+            }
+            server->setVar("[W]", wireTable(std::move(words)));
+            server->deleteVar("[X]");
+            server->deleteVar("[Y]");
+            server->deleteVar("[Z]");
+        });
+        word_num = (word_num + 1) / 2;
+    }
+    size_t used_bits = std::min<size_t>(flag_num, 32);
+    for (int shift = 1; shift < static_cast<int>(used_bits); shift <<= 1) {
+        doEachAsync([&](Server* server) {
+            auto& W = server->getVar<Table>("[W]");
+            server->setVar("[X]", wireTable({W.columns[0]}));
+            server->setVar("[Y]", wireTable({shiftColumn(W.columns[0], shift)}));
+        });
+        logicANDTable("[X]", "[Y]", "[Z]");
+        doEachAsync([&](Server* server) {
+            server->setVar("[W]", server->getVar<Table>("[Z]"));
+            server->deleteVar("[X]");
+            server->deleteVar("[Y]");
+            server->deleteVar("[Z]");
+        });
+    }
+
+    // 4 第0位取非即为各行新的isNull
+    doEachAsync([&](Server* server) {
+        server->getVar<Table>(table_name).is_null = BitColumn::fromColumn(notColumn(server->getVar<Table>("[W]").columns[0], server->id));
+        server->deleteVar("[W]");
+    });
+    log("END PROTOCOL CONSTRAINT VERIFICATION WITH MPC");
 }
 
 void Protocol::checkMatch_new(std::string table_name, std::vector<std::vector<int>> symmetries) {
     log("START PROTOCOL CONSTRAINT VERIFICATION");
 
     // 获取table的size
-    int table_size = std::any_cast<Table>(servers[0]->getVar(table_name)).data.size();
+    int table_size = std::any_cast<Table&>(servers[0]->getVar(table_name)).size();
 
     // 逐行进行匹配约束检查
     for (int row_idx = 0; row_idx < table_size; row_idx++) {
@@ -808,10 +1153,7 @@ void Protocol::checkMatch_new(std::string table_name, std::vector<std::vector<in
         // 各方准备表T的第i行数据t
         doEachAsync([&](Server* server) {
             auto& T = std::any_cast<Table&>(server->getVar(table_name));
-            std::vector<SharePair> t;
-            for (auto& item : T.data[row_idx]) {
-                t.push_back(std::any_cast<SharePair>(item));
-            }
+            std::vector<SharePair> t = T.getSharePairRow(row_idx);
             server->setVar("[t]", t);
         });
         
@@ -852,7 +1194,7 @@ void Protocol::checkMatch_new(std::string table_name, std::vector<std::vector<in
         // Update isNull
         doEachAsync([&](Server* server) {
             auto& T = std::any_cast<Table&>(server->getVar(table_name));
-            auto& isNull = std::any_cast<SharePair&>(T.is_null[row_idx]);
+            auto isNull = T.getIsNullSharePair(row_idx);
             server->setVar("[isNull]", isNull);
         });
 
@@ -862,7 +1204,7 @@ void Protocol::checkMatch_new(std::string table_name, std::vector<std::vector<in
         doEachAsync([&](Server* server) {
             auto& T = std::any_cast<Table&>(server->getVar(table_name));
             auto isNull_new = std::any_cast<SharePair>(server->getVar("[isNull]"));
-            T.is_null[row_idx] = isNull_new;
+            T.is_null.set(row_idx, isNull_new);
         });
 
         // 删除中间变量
@@ -886,6 +1228,42 @@ void Protocol::checkMatch_new(std::string table_name, std::vector<std::vector<in
     log("END PROTOCOL CONSTRAINT VERIFICATION");
 }
 
+void Protocol::nextRound() {
+    for (auto server : servers) {
+        server->nextRound();
+    }
+    if (third_party) {
+        third_party->nextRound();
+    }
+}
+
+void Protocol::beginPhase(const std::string& phase) {
+    endPhase();
+    current_phase = phase;
+    phase_start = collectNetStats();
+}
+
+void Protocol::endPhase() {
+    if (current_phase.empty()) {
+        return;
+    }
+    NetSnapshot delta = collectNetStats();
+    delta -= phase_start;
+    NetMetrics::global().add(current_phase, delta);
+    current_phase.clear();
+}
+
+NetSnapshot Protocol::collectNetStats() const {
+    NetSnapshot sum;
+    for (auto server : servers) {
+        sum += server->net_stats.snapshot();
+    }
+    if (third_party) {
+        sum += third_party->net_stats.snapshot();
+    }
+    return sum;
+}
+
 void Protocol::log(const std::string& log) const {
     if (!isLog) { return; }
     std::cout << "\033[1m" << "<LOG>[PROTOCOL]: " << log << "\033[0m" << std::endl;
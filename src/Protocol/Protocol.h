@@ -2,8 +2,11 @@
 
 #include "../Node/Server.h"
 #include "../Node/ThirdParty.h"
+#include "Executor.h"
 #include <future>
 #include <mutex>
+#include <latch>
+#include <exception>
 
 class Protocol {
 public:
@@ -12,10 +15,8 @@ public:
 
     bool use_third_party = true;   // 对于部分功能，是否使用可信第三方，默认为true
 
-    std::mutex doEach_mutex;
-
     // --------------------- 构造函数 ---------------------
-    Protocol(std::vector<Server*> servers, ThirdParty* third_party) : servers(servers), third_party(third_party) {}
+    Protocol(std::vector<Server*> servers, ThirdParty* third_party);
 
     // --------------------- 秘密共享和重构 ---------------------
     // server申请重构int类型var
@@ -30,6 +31,16 @@ public:
     void logicAND(std::string x_name, std::string y_name, std::string z_name);
     // [z] ← [x] ∨ [y]
     void logicOR(std::string x_name, std::string y_name, std::string z_name);
+    // [Z] ← [X] ∧ [Y]，X、Y为形状相同的布尔共享表，逐元素按位求与，每个Server只发送一条重共享消息
+    void logicANDTable(std::string x_name, std::string y_name, std::string z_name);
+    // 向量版本：x、y为等长的std::vector<SharePair>布尔共享，逐元素按位计算，整个向量只需一轮通信
+    // 各门均按位计算，一个元素的各个比特可以装入互不相关的布尔值，同时参与运算
+    // [y] ← ![x]，本地计算
+    void logicNOTVec(std::string x_name, std::string y_name = "");
+    // [z] ← [x] ∧ [y]，每个Server只发送一条重共享消息
+    void logicANDVec(std::string x_name, std::string y_name, std::string z_name);
+    // [z] ← [x] ∨ [y] = !(![x] ∧ ![y])
+    void logicORVec(std::string x_name, std::string y_name, std::string z_name);
 
     // --------------------- 特殊功能协议 ---------------------
     // 有Join Plan，星型分解和对称节点
@@ -38,10 +49,24 @@ public:
     void subgraphMatchingNoJoinPlan(const Table& query_graph, const std::string& result_name);
     // 有Join Plan，星型分解和对称节点
     void subgraphMatching(const Table& query_graph, const std::string& result_name);
-    // 安全约束验证协议
+    // 安全约束验证协议：按行块批量交给ThirdParty检查，每块一次处理CHECK_BLOCK_ROWS行
+    static const size_t CHECK_BLOCK_ROWS = 1 << 16;
     void checkMatch(std::string table_name, std::vector<std::vector<int>> symmetries);
     // 安全约束验证协议（新）
     void checkMatch_new(std::string table_name, std::vector<std::vector<int>> symmetries);
+    // 不依赖ThirdParty的安全约束验证协议：三方在布尔共享上批量计算所有行的相等、大于比较电路，直接更新isNull
+    // symmetries为空时只检查单射性，check_injectivity为false时只检查对称性；通信轮数只与位宽和列数的对数有关
+    void checkMatchMPC(std::string table_name, std::vector<std::vector<int>> symmetries, bool check_injectivity = true);
+
+    // --------------------- 网络统计 ---------------------
+    // 结束当前阶段，把期间所有Server和ThirdParty的网络统计增量登记到NetMetrics，并开始名为phase的新阶段
+    void beginPhase(const std::string& phase);
+    // 结束当前阶段
+    void endPhase();
+
+    // --------------------- 内存管理 ---------------------
+    // 进入协议的下一轮：各节点此前未再访问的变量成为冷变量，超出内存预算时可被溢出到磁盘
+    void nextRound();
 
     // --------------------- 打印函数 ---------------------
     void log(const std::string& log) const;
@@ -50,6 +75,20 @@ public:
 private:
     bool isLog = true;
 
+    // 每个Server一个长期运行的执行器，doEachAsync把任务投递给各Server的执行器
+    std::vector<std::unique_ptr<SerialExecutor>> executors;
+    // 只保护一批任务的投递：各执行器按相同的次序收到各批任务，并发的批次之间不会互相等待成环
+    std::mutex submit_mutex;
+
+    // 各Server之间交换零共享的种子，供与门重随机化使用；已交换过时不再发送
+    void setupZeroSharing();
+
+    std::string current_phase;      // 当前统计阶段，为空表示不在任何阶段中
+    NetSnapshot phase_start;        // 当前阶段开始时各节点网络统计之和
+
+    // 所有Server和ThirdParty当前网络统计之和
+    NetSnapshot collectNetStats() const;
+
     template <typename Func> 
     void doEach(Func func) {
         for (auto server : servers) {
@@ -57,28 +96,34 @@ private:
         }
     }
 
+    // 各Server在自己的执行器上并行执行func，全部完成后返回；任一任务抛出的异常在此重新抛出
     template<typename Func>
     void doEachAsync(Func func) {
-        std::lock_guard<std::mutex> guard(doEach_mutex);
-        std::vector<std::future<void>> futures;
-        // 打印开始提示（主线程）
-        // log("Start doEachAsync");
-
-        // 为每个Server启动异步任务
-        for (auto server : servers) {
-            futures.emplace_back(std::async(std::launch::async, [server, &func] {
-                // server->log("Start Action");
-                func(server);
-                // server->log("End Action");
-            }));
+        std::latch done(servers.size());
+        std::vector<std::exception_ptr> errors(servers.size());
+
+        // 把任务投递给各Server的执行器
+        {
+            std::lock_guard<std::mutex> guard(submit_mutex);
+            for (size_t i = 0; i < servers.size(); i++) {
+                executors[i]->submit([this, i, &func, &done, &errors] {
+                    try {
+                        func(servers[i]);
+                    } catch (...) {
+                        errors[i] = std::current_exception();
+                    }
+                    done.count_down();
+                });
+            }
         }
 
-        // 阻塞等待所有异步任务完成
-        for (auto& future : futures) {
-            future.get();
+        // 阻塞等待所有任务完成
+        done.wait();
+        for (auto& error : errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
         }
-
-        // log("End doEachAsync");
     }
 
     std::chrono::steady_clock::time_point start_, end_;     // 时间点
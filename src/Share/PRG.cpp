@@ -0,0 +1,96 @@
+#include "PRG.h"
+#include <random>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+
+static inline uint32_t rotl32(uint32_t x, int n) {
+    return (x << n) | (x >> (32 - n));
+}
+
+#define CHACHA_QUARTER_ROUND(a, b, c, d) \
+    a += b; d ^= a; d = rotl32(d, 16);   \
+    c += d; b ^= c; b = rotl32(b, 12);   \
+    a += b; d ^= a; d = rotl32(d, 8);    \
+    c += d; b ^= c; b = rotl32(b, 7);
+
+PRG::PRG(std::string_view seed) {
+    if (seed.size() != SEED_SIZE) {
+        throw std::invalid_argument("Invalid argument in PRG(): Seed must be " + std::to_string(SEED_SIZE) + " bytes");
+    }
+    for (size_t i = 0; i < key.size(); i++) {
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(seed.data()) + 4 * i;
+        key[i] = uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+    }
+}
+
+std::string PRG::randomSeed() {
+    std::random_device rd;
+    std::string seed(SEED_SIZE, '\0');
+    for (size_t i = 0; i < SEED_SIZE; i += 4) {
+        uint32_t word = rd();
+        std::memcpy(seed.data() + i, &word, 4);
+    }
+    return seed;
+}
+
+std::string PRG::seed() const {
+    std::string seed(SEED_SIZE, '\0');
+    for (size_t i = 0; i < key.size(); i++) {
+        for (int b = 0; b < 4; b++) {
+            seed[4 * i + b] = static_cast<char>((key[i] >> (8 * b)) & 0xFF);
+        }
+    }
+    return seed;
+}
+
+void PRG::block(uint64_t counter, uint32_t out[BLOCK_WORDS]) const {
+    // "expand 32-byte k"，块计数器占12、13两个字，nonce固定为0
+    uint32_t state[BLOCK_WORDS] = {
+        0x61707865, 0x3320646e, 0x79622d32, 0x6b206574,
+        key[0], key[1], key[2], key[3], key[4], key[5], key[6], key[7],
+        static_cast<uint32_t>(counter), static_cast<uint32_t>(counter >> 32), 0, 0
+    };
+    uint32_t x[BLOCK_WORDS];
+    std::memcpy(x, state, sizeof(state));
+    for (int round = 0; round < 10; round++) {
+        // 列轮
+        CHACHA_QUARTER_ROUND(x[0], x[4], x[8],  x[12]);
+        CHACHA_QUARTER_ROUND(x[1], x[5], x[9],  x[13]);
+        CHACHA_QUARTER_ROUND(x[2], x[6], x[10], x[14]);
+        CHACHA_QUARTER_ROUND(x[3], x[7], x[11], x[15]);
+        // 对角轮
+        CHACHA_QUARTER_ROUND(x[0], x[5], x[10], x[15]);
+        CHACHA_QUARTER_ROUND(x[1], x[6], x[11], x[12]);
+        CHACHA_QUARTER_ROUND(x[2], x[7], x[8],  x[13]);
+        CHACHA_QUARTER_ROUND(x[3], x[4], x[9],  x[14]);
+    }
+    for (size_t i = 0; i < BLOCK_WORDS; i++) {
+        out[i] = x[i] + state[i];
+    }
+}
+
+void PRG::fill(uint64_t offset, uint32_t* out, size_t n) const {
+    uint32_t buffer[BLOCK_WORDS];
+    uint64_t counter = offset / BLOCK_WORDS;
+    size_t skip = offset % BLOCK_WORDS;
+    size_t produced = 0;
+    while (produced < n) {
+        block(counter++, buffer);
+        size_t take = std::min(BLOCK_WORDS - skip, n - produced);
+        std::memcpy(out + produced, buffer + skip, take * sizeof(uint32_t));
+        produced += take;
+        skip = 0;
+    }
+}
+
+void PRG::fillShares(uint64_t offset, int* out, size_t n) const {
+    static_assert(sizeof(int) == sizeof(uint32_t), "int must be 32 bits");
+    uint32_t* words = reinterpret_cast<uint32_t*>(out);
+    fill(offset, words, n);
+    for (size_t i = 0; i < n; i++) {
+        out[i] = static_cast<int>(words[i] & RING_MASK);
+    }
+}
+
+#undef CHACHA_QUARTER_ROUND
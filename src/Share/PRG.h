@@ -0,0 +1,38 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+#include "Share.h"
+
+// 基于ChaCha20的计数器模式伪随机数生成器
+// 同一个种子在任意位置展开得到的随机字完全确定，持有相同种子的各方可以各自在本地生成相同的随机份额
+class PRG {
+public:
+    static const size_t SEED_SIZE = 32;     // 种子（ChaCha20密钥）字节数
+    static const size_t BLOCK_WORDS = 16;   // 每个ChaCha20块输出的32位字数
+
+    PRG() { key.fill(0); }
+    // 由SEED_SIZE字节的种子构造
+    PRG(std::string_view seed);
+
+    // 生成一个新的随机种子
+    static std::string randomSeed();
+    // 以二进制串的形式返回种子
+    std::string seed() const;
+
+    // 输出密钥流中从第offset个字开始的n个32位字
+    void fill(uint64_t offset, uint32_t* out, size_t n) const;
+    // 输出密钥流中从第offset个字开始的n个环上的份额
+    void fillShares(uint64_t offset, int* out, size_t n) const;
+    void fillShares(uint64_t offset, std::vector<int>& out) const { fillShares(offset, out.data(), out.size()); }
+
+private:
+    std::array<uint32_t, 8> key;
+
+    // 计算第counter个块
+    void block(uint64_t counter, uint32_t out[BLOCK_WORDS]) const;
+};
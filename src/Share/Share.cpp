@@ -1,16 +1,68 @@
 #include "Share.h"
+#include "PRG.h"
+#include <charconv>
+#include <algorithm>
+#include <cctype>
+
+namespace {
+
+// 线程私有的ChaCha20密钥流，首次使用时以std::random_device取种子
+// 逐个取值时从缓冲区中读取，整段取值时直接在密钥流上展开，两者共用同一个位置，取出的字不会重复
+class ShareStream {
+public:
+    static const size_t BUFFER_WORDS = 4 * PRG::BLOCK_WORDS;
+
+    ShareStream() : prg(PRG::randomSeed()) {}
+
+    uint32_t next() {
+        if (used == BUFFER_WORDS) {
+            prg.fill(offset, buffer.data(), BUFFER_WORDS);
+            offset += BUFFER_WORDS;
+            used = 0;
+        }
+        return buffer[used++];
+    }
+
+    void fill(uint32_t* out, size_t n) {
+        prg.fill(offset, out, n);
+        offset += n;
+    }
+
+private:
+    PRG prg;
+    uint64_t offset = 0;
+    std::array<uint32_t, BUFFER_WORDS> buffer;
+    size_t used = BUFFER_WORDS;
+};
+
+ShareStream& shareStream() {
+    static thread_local ShareStream stream;
+    return stream;
+}
+
+}
+
+int ringRandom() {
+    return static_cast<int>(shareStream().next() & RING_MASK);
+}
+
+void ringRandomFill(int* out, size_t n) {
+    static_assert(sizeof(int) == sizeof(uint32_t), "int must be 32 bits");
+    ring_t* words = reinterpret_cast<ring_t*>(out);
+    shareStream().fill(words, n);
+    for (size_t i = 0; i < n; i++) {
+        words[i] &= RING_MASK;
+    }
+}
 
 ShareTuple::ShareTuple(int value, u_int type) {
     this->type = type;
 
+    data[0] = ringRandom();
+    data[1] = ringRandom();
     if (type == ARITHMETIC_SHARING) {
-        data[0] = std::rand() % MOD;
-        data[1] = std::rand() % MOD;
-        data[2] = (value - data[0] - data[1]) % MOD;
-        data[2] = data[2] < 0 ? data[2] + MOD : data[2];
+        data[2] = ringSub(ringSub(value, data[0]), data[1]);
     } else {
-        data[0] = std::rand() % MOD;
-        data[1] = std::rand() % MOD;
         data[2] = value ^ data[0] ^ data[1];
     }
 }
@@ -55,12 +107,7 @@ std::string ShareTuple::toDataString() {
 }
 
 int ShareTuple::compute() {
-    if (type == ARITHMETIC_SHARING) {
-        int res = (data[0] + data[1] + data[2]) % MOD;
-        return res < 0 ? res + MOD : res; //  确保落在[0,MOD)
-    } else {
-        return data[0] ^ data[1] ^ data[2];
-    }
+    return reconstructValue(data[0], data[1], data[2], type);
 }
 
 SharePair &SharePair::operator=(const SharePair &copy) {
@@ -76,8 +123,8 @@ SharePair SharePair::operator+(const SharePair &rhs) const {
     }
 
     SharePair result;
-    result.data[0] = (data[0] + rhs.data[0]) % MOD;
-    result.data[1] = (data[1] + rhs.data[1]) % MOD;
+    result.data[0] = ringAdd(data[0], rhs.data[0]);
+    result.data[1] = ringAdd(data[1], rhs.data[1]);
     result.type = this->type;
     return result;
 }
@@ -88,8 +135,8 @@ SharePair SharePair::operator-(const SharePair &rhs) const {
     }
 
     SharePair result;
-    result.data[0] = (data[0] - rhs.data[0]) % MOD;
-    result.data[1] = (data[1] - rhs.data[1]) % MOD;
+    result.data[0] = ringSub(data[0], rhs.data[0]);
+    result.data[1] = ringSub(data[1], rhs.data[1]);
     result.type = this->type;
     return result;
 }
@@ -106,22 +153,38 @@ SharePair SharePair::operator^(const SharePair &rhs) const {
     return result;
 }
 
-void SharePair::fromString(const std::string& str) {
-    // "type s_i,s_{i+1}"
-    std::istringstream iss(str);
-    std::string token;
-
-    // 读取type
-    iss >> type;
+// 从str的pos处解析一个整数，跳过前导空格，解析后pos指向数字之后的位置
+static bool parseInt(std::string_view str, size_t& pos, int& value) {
+    while (pos < str.size() && str[pos] == ' ') {
+        pos++;
+    }
+    auto [ptr, ec] = std::from_chars(str.data() + pos, str.data() + str.size(), value);
+    if (ec != std::errc()) {
+        return false;
+    }
+    pos = ptr - str.data();
+    return true;
+}
 
-    // 跳过空格
-    iss.ignore();
+// 解析一个"type s_i,s_{i+1}"格式的SharePair，解析后pos指向其之后的位置
+static bool parseSharePair(std::string_view str, size_t& pos, SharePair& sp) {
+    int type;
+    if (!parseInt(str, pos, type)) {
+        return false;
+    }
+    sp.type = type;
+    if (!parseInt(str, pos, sp.data[0]) || pos >= str.size() || str[pos] != ',') {
+        return false;
+    }
+    pos++;
+    return parseInt(str, pos, sp.data[1]);
+}
 
-    for (int i = 0; i < 2; i++) {
-        if (!std::getline(iss, token, (i == 0 ? ',' : '\n'))) {
-            throw std::invalid_argument("Invalid argument in fromString(): Invalid SharePair format");
-        }
-        data[i] = std::stoi(token);
+void SharePair::fromString(std::string_view str) {
+    // "type s_i,s_{i+1}"
+    size_t pos = 0;
+    if (!parseSharePair(str, pos, *this)) {
+        throw std::invalid_argument("Invalid argument in fromString(): Invalid SharePair format");
     }
 }
 
@@ -147,21 +210,105 @@ std::string SharePair::toDataString() const {
 }
 
 
-std::vector<SharePair> String2SPs(const std::string& str) {
-    std::vector<SharePair> result;
-    std::istringstream iss(str);
-    std::vector<std::string> tokens;
-    std::string token;
+void reconstructColumn(const std::vector<int>& x1, const std::vector<int>& x2, const std::vector<int>& x3,
+                       u_int type, std::vector<int>& out) {
+    size_t n = x1.size();
+    if (x2.size() != n || x3.size() != n) {
+        throw std::invalid_argument("Invalid argument in reconstructColumn(): Shares have different sizes");
+    }
+    out.resize(n);
+    // 共享类型的判断提到循环外，循环体只有加法和按位运算，可以向量化
+    const ring_t* a = reinterpret_cast<const ring_t*>(x1.data());
+    const ring_t* b = reinterpret_cast<const ring_t*>(x2.data());
+    const ring_t* c = reinterpret_cast<const ring_t*>(x3.data());
+    ring_t* o = reinterpret_cast<ring_t*>(out.data());
+    if (type == ARITHMETIC_SHARING) {
+        for (size_t r = 0; r < n; r++) {
+            o[r] = (a[r] + b[r] + c[r]) & RING_MASK;
+        }
+    } else {
+        for (size_t r = 0; r < n; r++) {
+            o[r] = a[r] ^ b[r] ^ c[r];
+        }
+    }
+}
 
-    // 分割所有token
-    while (iss >> token) {
-        tokens.push_back(token);
+void accumulateColumn(std::vector<int>& acc, const std::vector<int>& x, u_int type) {
+    size_t n = acc.size();
+    if (x.size() != n) {
+        throw std::invalid_argument("Invalid argument in accumulateColumn(): Shares have different sizes");
     }
+    ring_t* a = reinterpret_cast<ring_t*>(acc.data());
+    const ring_t* b = reinterpret_cast<const ring_t*>(x.data());
+    if (type == ARITHMETIC_SHARING) {
+        for (size_t r = 0; r < n; r++) {
+            a[r] = (a[r] + b[r]) & RING_MASK;
+        }
+    } else {
+        for (size_t r = 0; r < n; r++) {
+            a[r] ^= b[r];
+        }
+    }
+}
+
+void splitColumn(const std::vector<int>& values, u_int type,
+                 std::vector<int>& x1, std::vector<int>& x2, std::vector<int>& x3) {
+    size_t n = values.size();
+    x1.resize(n);
+    x2.resize(n);
+    x3.resize(n);
+    ringRandomFill(x1.data(), n);
+    ringRandomFill(x2.data(), n);
+    const ring_t* v = reinterpret_cast<const ring_t*>(values.data());
+    const ring_t* a = reinterpret_cast<const ring_t*>(x1.data());
+    const ring_t* b = reinterpret_cast<const ring_t*>(x2.data());
+    ring_t* c = reinterpret_cast<ring_t*>(x3.data());
+    if (type == ARITHMETIC_SHARING) {
+        for (size_t r = 0; r < n; r++) {
+            c[r] = (v[r] - a[r] - b[r]) & RING_MASK;
+        }
+    } else {
+        for (size_t r = 0; r < n; r++) {
+            c[r] = v[r] ^ a[r] ^ b[r];
+        }
+    }
+}
+
+void splitBits(const std::vector<int>& values, std::vector<int>& x1, std::vector<int>& x2, std::vector<int>& x3) {
+    size_t n = values.size();
+    x1.resize(n);
+    x2.resize(n);
+    x3.resize(n);
+    // 每个随机字提供32行的分量，x1、x2各取一段
+    size_t words = (n + 31) / 32;
+    std::vector<uint32_t> bits(2 * words);
+    shareStream().fill(bits.data(), bits.size());
+    const uint32_t* b1 = bits.data();
+    const uint32_t* b2 = bits.data() + words;
+    for (size_t r = 0; r < n; r++) {
+        x1[r] = (b1[r / 32] >> (r % 32)) & 1;
+        x2[r] = (b2[r / 32] >> (r % 32)) & 1;
+        x3[r] = (values[r] & 1) ^ x1[r] ^ x2[r];
+    }
+}
 
-    // 每两个token组成一个SharePair
-    for (size_t i = 0; i + 1 < tokens.size(); i += 2) {
-        std::string pairStr = tokens[i] + " " + tokens[i + 1];
-        result.emplace_back(SharePair(pairStr));
+std::vector<SharePair> String2SPs(std::string_view str) {
+    // 每个SharePair为"type s_i,s_{i+1}"，相邻的SharePair以空格分隔，直接在原字符串上解析
+    std::vector<SharePair> result;
+    result.reserve(std::count(str.begin(), str.end(), ','));
+    size_t pos = 0;
+    while (true) {
+        while (pos < str.size() && std::isspace(static_cast<unsigned char>(str[pos]))) {
+            pos++;
+        }
+        if (pos >= str.size()) {
+            break;
+        }
+        SharePair sp;
+        if (!parseSharePair(str, pos, sp)) {
+            throw std::invalid_argument("Invalid argument in String2SPs(): Invalid SharePair format");
+        }
+        result.push_back(sp);
     }
 
     return result;
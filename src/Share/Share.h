@@ -6,6 +6,9 @@
 #include <array>
 #include <sstream>
 #include <limits>
+#include <string_view>
+#include <cstdint>
+#include <cstdlib>
 
 static const u_int NO_SHARING = 0;
 static const u_int BINARY_SHARING = 1;
@@ -15,8 +18,26 @@ static const int EMPTY = std::numeric_limits<int>::min();
 
 static const u_int SHARE_PARTY_NUM = 3;
 
-// 秘密共享的模数
-static const int MOD = 1048576;
+// 秘密共享的环Z_{2^SHARE_RING_BITS}，位宽在编译时选择（不超过32），份额按int存储
+// 算术共享在uint32_t上利用自然溢出计算，再与RING_MASK按位与，不需要取模和负数修正；布尔共享按位异或，与位宽无关
+// 默认31位：份额和明文都落在[0, 2^31)，以int存储时始终非负
+#ifndef SHARE_RING_BITS
+#define SHARE_RING_BITS 31
+#endif
+static_assert(SHARE_RING_BITS >= 1 && SHARE_RING_BITS <= 32, "SHARE_RING_BITS must be in [1, 32]");
+
+using ring_t = uint32_t;
+static const ring_t RING_MASK = ~ring_t(0) >> (32 - SHARE_RING_BITS);
+// 可以秘密共享的最大明文值
+static const int MAX_SHARE_VALUE = RING_MASK > ring_t(INT32_MAX) ? INT32_MAX : static_cast<int>(RING_MASK);
+
+// 环上的加减法
+inline int ringAdd(int a, int b) { return static_cast<int>((static_cast<ring_t>(a) + static_cast<ring_t>(b)) & RING_MASK); }
+inline int ringSub(int a, int b) { return static_cast<int>((static_cast<ring_t>(a) - static_cast<ring_t>(b)) & RING_MASK); }
+// 环上均匀随机的份额，取自当前线程私有的ChaCha20密钥流，多线程生成份额时互不加锁
+int ringRandom();
+// 从当前线程的密钥流中取n个环上均匀随机的份额
+void ringRandomFill(int* out, size_t n);
 
 // 秘密x=x1+x2+x3, ShareTuple表示{x1,x2,x3}
 class ShareTuple {
@@ -73,7 +94,7 @@ public:
         : data(d), type(type) {};
 
     // 解析string构造函数
-    SharePair(const std::string& str) { fromString(str); }
+    SharePair(std::string_view str) { fromString(str); }
     
     SharePair& operator=(const SharePair& copy);
     SharePair operator+(const SharePair& rhs) const;
@@ -86,11 +107,34 @@ public:
         return data == other.data;
     }
 
-    void fromString(const std::string& str);
+    void fromString(std::string_view str);
     void fromDataString(const std::string& str);
     std::string toString() const;
     std::string toDataString() const;
 };
 
-std::vector<SharePair> String2SPs(const std::string& str);
+// 由三个分量重构秘密值
+inline int reconstructValue(int x1, int x2, int x3, u_int type) {
+    if (type == ARITHMETIC_SHARING) {
+        return static_cast<int>((static_cast<ring_t>(x1) + static_cast<ring_t>(x2) + static_cast<ring_t>(x3)) & RING_MASK);
+    }
+    return x1 ^ x2 ^ x3;
+}
+
+// 按列重构：out[r] = reconstructValue(x1[r], x2[r], x3[r], type)
+void reconstructColumn(const std::vector<int>& x1, const std::vector<int>& x2, const std::vector<int>& x3,
+                       u_int type, std::vector<int>& out);
+
+// 按列累加一个分量：acc[r] = acc[r] + x[r]（算术共享）或acc[r] ^ x[r]（布尔共享），三个分量依次累加即得明文
+void accumulateColumn(std::vector<int>& acc, const std::vector<int>& x, u_int type);
+
+// 按列拆分：将values的每个值以type随机拆分为三个分量，与ShareTuple(secret, type)的拆分方式一致
+// x1、x2整段从密钥流中取出，x3的计算循环中不含分支，可以向量化
+void splitColumn(const std::vector<int>& values, u_int type,
+                 std::vector<int>& x1, std::vector<int>& x2, std::vector<int>& x3);
+
+// 按列拆分0/1标志位：以布尔共享拆分，各分量也只取0/1
+void splitBits(const std::vector<int>& values, std::vector<int>& x1, std::vector<int>& x2, std::vector<int>& x3);
+
+std::vector<SharePair> String2SPs(std::string_view str);
 std::string SPs2String(const std::vector<SharePair>& sharePairs);
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "Table.h"
-
-#include "Table.h"
+#include <cstdint>
+#include <type_traits>
+#include <omp.h>
 
 const std::string print_color = "\033[94m";
 const std::string default_color = "\033[0m";
@@ -8,6 +9,325 @@ const std::string default_color = "\033[0m";
 bool enable_log = true;
 std::mutex table_print_mutex;
 
+Column::Column(u_int part_num, size_t rows) {
+    parts.reserve(part_num);
+    for (u_int k = 0; k < part_num; k++) {
+        parts.push_back(std::make_shared<std::vector<int>>(rows, 0));
+    }
+}
+
+void Column::setParts(std::vector<std::vector<int>> data) {
+    parts.clear();
+    for (auto& p : data) {
+        parts.push_back(std::make_shared<std::vector<int>>(std::move(p)));
+    }
+}
+
+void Column::sharePart(u_int k, const Column& other, u_int other_k) {
+    if (k >= parts.size()) {
+        parts.resize(k + 1);
+    }
+    parts[k] = other.parts[other_k];
+}
+
+void Column::resize(size_t rows) {
+    for (u_int k = 0; k < parts.size(); k++) {
+        part(k).resize(rows, 0);
+    }
+}
+
+void Column::reserve(size_t rows) {
+    for (u_int k = 0; k < parts.size(); k++) {
+        part(k).reserve(rows);
+    }
+}
+
+void Column::clear() {
+    // 不修改可能被共享的缓冲区，直接换成空的缓冲区
+    for (auto& p : parts) {
+        p = std::make_shared<std::vector<int>>();
+    }
+}
+
+SharePair Column::getSharePair(size_t row, u_int type) const {
+    if (parts.size() != 2) {
+        throw std::runtime_error("Runtime Error in Column::getSharePair(): Column is not in SHARE_PAIR_MODE");
+    }
+    return SharePair({(*parts[0])[row], (*parts[1])[row]}, type);
+}
+
+ShareTuple Column::getShareTuple(size_t row, u_int type) const {
+    if (parts.size() != 3) {
+        throw std::runtime_error("Runtime Error in Column::getShareTuple(): Column is not in SHARE_TUPLE_MODE");
+    }
+    return ShareTuple({(*parts[0])[row], (*parts[1])[row], (*parts[2])[row]}, type);
+}
+
+void Column::set(size_t row, const SharePair& sp) {
+    part(0)[row] = sp[0];
+    part(1)[row] = sp[1];
+}
+
+void Column::set(size_t row, const ShareTuple& st) {
+    part(0)[row] = st[0];
+    part(1)[row] = st[1];
+    part(2)[row] = st[2];
+}
+
+void Column::push_back(const SharePair& sp) {
+    part(0).push_back(sp[0]);
+    part(1).push_back(sp[1]);
+}
+
+void Column::push_back(const ShareTuple& st) {
+    part(0).push_back(st[0]);
+    part(1).push_back(st[1]);
+    part(2).push_back(st[2]);
+}
+
+void Column::append(const Column& other, size_t start, size_t end) {
+    if (parts.empty()) {
+        *this = Column(other.partNum());
+    }
+    if (parts.size() != other.parts.size()) {
+        throw std::invalid_argument("Invalid argument in Column::append(): Columns have different part number");
+    }
+    for (u_int k = 0; k < parts.size(); k++) {
+        const auto& src = other.cpart(k);
+        auto& dst = part(k);
+        dst.insert(dst.end(), src.begin() + start, src.begin() + end);
+    }
+}
+
+Column Column::gather(const std::vector<size_t>& rows) const {
+    Column result(parts.size(), rows.size());
+    for (u_int k = 0; k < parts.size(); k++) {
+        const int* src = parts[k]->data();
+        int* dst = result.part(k).data();
+        for (size_t i = 0; i < rows.size(); i++) {
+            dst[i] = src[rows[i]];
+        }
+    }
+    return result;
+}
+
+BitColumn::BitColumn(u_int part_num, size_t rows, int value) : rows(rows) {
+    parts.reserve(part_num);
+    for (u_int k = 0; k < part_num; k++) {
+        parts.push_back(std::make_shared<std::vector<uint64_t>>(wordCount(rows), value & 1 ? ~uint64_t(0) : 0));
+        clearTail(k);
+    }
+}
+
+void BitColumn::sharePart(u_int k, const BitColumn& other, u_int other_k) {
+    if (k >= parts.size()) {
+        parts.resize(k + 1);
+    }
+    parts[k] = other.parts[other_k];
+    rows = other.rows;
+}
+
+BitColumn BitColumn::component(u_int k) const {
+    BitColumn result;
+    result.sharePart(0, *this, k);
+    return result;
+}
+
+void BitColumn::clearTail(u_int k) {
+    size_t tail = rows % WORD_BITS;
+    if (tail != 0) {
+        words(k).back() &= (uint64_t(1) << tail) - 1;
+    }
+}
+
+void BitColumn::resize(size_t new_rows, int value) {
+    size_t old_rows = rows;
+    rows = new_rows;
+    for (u_int k = 0; k < parts.size(); k++) {
+        auto& w = words(k);
+        w.resize(wordCount(new_rows), 0);
+        if (value & 1) {
+            // 填充新增的行：先补齐原最后一个字的高位，再整字填充
+            for (size_t r = old_rows; r < new_rows && r % WORD_BITS != 0; r++) {
+                w[r / WORD_BITS] |= uint64_t(1) << (r % WORD_BITS);
+            }
+            std::fill(w.begin() + wordCount(old_rows), w.end(), ~uint64_t(0));
+        }
+        clearTail(k);
+    }
+}
+
+void BitColumn::clear() {
+    // 不修改可能被共享的缓冲区，直接换成空的缓冲区
+    for (auto& p : parts) {
+        p = std::make_shared<std::vector<uint64_t>>();
+    }
+    rows = 0;
+}
+
+void BitColumn::set(u_int k, size_t row, int value) {
+    uint64_t& word = words(k)[row / WORD_BITS];
+    uint64_t bit = uint64_t(1) << (row % WORD_BITS);
+    word = value & 1 ? word | bit : word & ~bit;
+}
+
+SharePair BitColumn::getSharePair(size_t row, u_int type) const {
+    if (parts.size() != 2) {
+        throw std::runtime_error("Runtime Error in BitColumn::getSharePair(): Column is not in SHARE_PAIR_MODE");
+    }
+    return SharePair({get(0, row), get(1, row)}, type);
+}
+
+ShareTuple BitColumn::getShareTuple(size_t row, u_int type) const {
+    if (parts.size() != 3) {
+        throw std::runtime_error("Runtime Error in BitColumn::getShareTuple(): Column is not in SHARE_TUPLE_MODE");
+    }
+    return ShareTuple({get(0, row), get(1, row), get(2, row)}, type);
+}
+
+void BitColumn::set(size_t row, const SharePair& sp) {
+    set(0, row, sp[0]);
+    set(1, row, sp[1]);
+}
+
+void BitColumn::set(size_t row, const ShareTuple& st) {
+    set(0, row, st[0]);
+    set(1, row, st[1]);
+    set(2, row, st[2]);
+}
+
+void BitColumn::push_back(int value) {
+    resize(rows + 1);
+    set(0, rows - 1, value);
+}
+
+void BitColumn::push_back(const SharePair& sp) {
+    resize(rows + 1);
+    set(rows - 1, sp);
+}
+
+void BitColumn::push_back(const ShareTuple& st) {
+    resize(rows + 1);
+    set(rows - 1, st);
+}
+
+void BitColumn::append(const BitColumn& other, size_t start, size_t end) {
+    if (parts.empty()) {
+        *this = BitColumn(other.partNum());
+    }
+    if (parts.size() != other.parts.size()) {
+        throw std::invalid_argument("Invalid argument in BitColumn::append(): Columns have different part number");
+    }
+    size_t offset = rows;
+    resize(rows + (end - start));
+    for (u_int k = 0; k < parts.size(); k++) {
+        const auto& src = other.cwords(k);
+        auto& dst = words(k);
+        for (size_t r = start; r < end; r++) {
+            size_t to = offset + r - start;
+            dst[to / WORD_BITS] |= ((src[r / WORD_BITS] >> (r % WORD_BITS)) & 1) << (to % WORD_BITS);
+        }
+    }
+}
+
+void BitColumn::assign(size_t start, const BitColumn& other) {
+    if (parts.size() != other.parts.size() || start + other.rows > rows) {
+        throw std::invalid_argument("Invalid argument in BitColumn::assign(): Column shapes do not match");
+    }
+    for (u_int k = 0; k < parts.size(); k++) {
+        const auto& src = other.cwords(k);
+        auto& dst = words(k);
+        if (start % WORD_BITS == 0) {
+            // 对齐时整字复制，最后一个不完整的字只覆盖低位
+            size_t full = other.rows / WORD_BITS;
+            std::copy(src.begin(), src.begin() + full, dst.begin() + start / WORD_BITS);
+            size_t tail = other.rows % WORD_BITS;
+            if (tail != 0) {
+                uint64_t mask = (uint64_t(1) << tail) - 1;
+                uint64_t& word = dst[start / WORD_BITS + full];
+                word = (word & ~mask) | (src[full] & mask);
+            }
+        } else {
+            for (size_t r = 0; r < other.rows; r++) {
+                size_t to = start + r;
+                uint64_t bit = uint64_t(1) << (to % WORD_BITS);
+                uint64_t& word = dst[to / WORD_BITS];
+                word = (src[r / WORD_BITS] >> (r % WORD_BITS)) & 1 ? word | bit : word & ~bit;
+            }
+        }
+    }
+}
+
+BitColumn BitColumn::gather(const std::vector<size_t>& rows) const {
+    BitColumn result(parts.size(), rows.size());
+    for (u_int k = 0; k < parts.size(); k++) {
+        const uint64_t* src = parts[k]->data();
+        uint64_t* dst = result.words(k).data();
+        for (size_t i = 0; i < rows.size(); i++) {
+            dst[i / WORD_BITS] |= ((src[rows[i] / WORD_BITS] >> (rows[i] % WORD_BITS)) & 1) << (i % WORD_BITS);
+        }
+    }
+    return result;
+}
+
+BitColumn BitColumn::fromColumn(const Column& column) {
+    BitColumn result(column.partNum(), column.size());
+    for (u_int k = 0; k < column.partNum(); k++) {
+        const auto& src = column.cpart(k);
+        auto& dst = result.words(k);
+        for (size_t r = 0; r < src.size(); r++) {
+            dst[r / WORD_BITS] |= uint64_t(src[r] & 1) << (r % WORD_BITS);
+        }
+    }
+    return result;
+}
+
+Column BitColumn::toColumn() const {
+    Column result(parts.size(), rows);
+    for (u_int k = 0; k < parts.size(); k++) {
+        const auto& src = *parts[k];
+        auto& dst = result.part(k);
+        for (size_t r = 0; r < rows; r++) {
+            dst[r] = (src[r / WORD_BITS] >> (r % WORD_BITS)) & 1;
+        }
+    }
+    return result;
+}
+
+template <typename Op>
+BitColumn& BitColumn::combine(const BitColumn& other, Op op) {
+    if (parts.size() != other.parts.size() || rows != other.rows) {
+        throw std::invalid_argument("Invalid argument in BitColumn: Columns have different shapes");
+    }
+    for (u_int k = 0; k < parts.size(); k++) {
+        const auto& src = other.cwords(k);
+        auto& dst = words(k);
+        for (size_t w = 0; w < dst.size(); w++) {
+            dst[w] = op(dst[w], src[w]);
+        }
+    }
+    return *this;
+}
+
+BitColumn& BitColumn::operator^=(const BitColumn& other) {
+    return combine(other, [](uint64_t a, uint64_t b) { return a ^ b; });
+}
+
+BitColumn& BitColumn::operator&=(const BitColumn& other) {
+    return combine(other, [](uint64_t a, uint64_t b) { return a & b; });
+}
+
+BitColumn& BitColumn::operator|=(const BitColumn& other) {
+    return combine(other, [](uint64_t a, uint64_t b) { return a | b; });
+}
+
+void BitColumn::flip(u_int k) {
+    for (auto& word : words(k)) {
+        word = ~word;
+    }
+    clearTail(k);
+}
+
 std::vector<std::string> Table::split(const std::string& str) {
     std::vector<std::string> tokens;
     std::istringstream iss(str);
@@ -18,37 +338,81 @@ std::vector<std::string> Table::split(const std::string& str) {
     return tokens;
 }
 
-void Table::validateData(const std::vector<std::any>& row) {
-    if (row.size() != headers.size()) {
-        throw std::invalid_argument("Invalid argument in validateData(): Data row size does not match headers size");
+u_int Table::partNum() const {
+    if (mode == INT_MODE) {
+        return 1;
+    } else if (mode == SHARE_PAIR_MODE) {
+        return 2;
+    } else if (mode == SHARE_TUPLE_MODE) {
+        return 3;
+    }
+    throw std::invalid_argument("Invalid argument in partNum(): Unknown table mode: " + std::to_string(mode));
+}
+
+void Table::initColumns(size_t rows) {
+    // 每列各自分配缓冲区，避免由同一个Column拷贝出的各列共享缓冲区
+    columns.clear();
+    columns.reserve(headers.size());
+    for (size_t j = 0; j < headers.size(); j++) {
+        columns.emplace_back(partNum(), rows);
     }
+    is_null = BitColumn(partNum(), rows);
 }
 
-std::any Table::convertStringToData(const std::string& str, u_int share_type) {
+void Table::appendValueFromString(Column& column, const std::string& str) {
     if (mode == INT_MODE) {
-        return std::any(std::stoi(str));
+        column.push_back(std::stoi(str));
     } else if (mode == SHARE_TUPLE_MODE) {
-        ShareTuple sv(share_type);
+        ShareTuple sv(NO_SHARING);
         sv.fromDataString(str);
-        return std::any(sv);
+        column.push_back(sv);
     } else if (mode == SHARE_PAIR_MODE) {
         SharePair s;
-        s.type = share_type;
         s.fromDataString(str);
-        return std::any(s);
+        column.push_back(s);
+    } else {
+        throw std::invalid_argument("Invalid argument in appendValueFromString(): Unknown data type: " + std::to_string(mode));
     }
-    throw std::invalid_argument("Invalid argument in convertStringToData(): Unknown data type: " + mode);
 }
 
-std::string Table::convertDataToString(const std::any& value) const {
-    if (mode == INT_MODE) {
-        return std::to_string(std::any_cast<int>(value));
-    } else if (mode == SHARE_TUPLE_MODE) {
-        return std::any_cast<ShareTuple>(value).toDataString();
-    } else if (mode == SHARE_PAIR_MODE) {
-        return std::any_cast<SharePair>(value).toDataString();
+void Table::appendValueFromString(BitColumn& column, const std::string& str) {
+    Column value(partNum());
+    appendValueFromString(value, str);
+    column.append(BitColumn::fromColumn(value), 0, 1);
+}
+
+std::string Table::valueToString(const BitColumn& column, size_t row) const {
+    std::string str = std::to_string(column.get(0, row));
+    for (u_int k = 1; k < column.partNum(); k++) {
+        str += "," + std::to_string(column.get(k, row));
+    }
+    return str;
+}
+
+std::string Table::valueToString(const Column& column, size_t row) const {
+    std::string str = std::to_string(column.cpart(0)[row]);
+    for (u_int k = 1; k < column.partNum(); k++) {
+        str += "," + std::to_string(column.cpart(k)[row]);
     }
-    throw std::invalid_argument("Invalid argument in convertDataToString(): Unknown data type: " + mode);
+    return str;
+}
+
+std::vector<int> Table::getIntRow(size_t row) const {
+    std::vector<int> values;
+    values.reserve(columns.size());
+    for (const auto& column : columns) {
+        values.push_back(column.getInt(row));
+    }
+    return values;
+}
+
+std::vector<SharePair> Table::getSharePairRow(size_t row) const {
+    std::vector<SharePair> values;
+    values.reserve(columns.size());
+    for (size_t j = 0; j < columns.size(); j++) {
+        values.push_back(getSharePair(row, j));
+    }
+    return values;
 }
 
 void Table::readFromFile(const std::string& filename) {
@@ -58,10 +422,11 @@ void Table::readFromFile(const std::string& filename) {
     }
     
     headers.clear();
-    data.clear();
+    share_types.clear();
+    columns.clear();
     is_null.clear();
 
-    int is_null_idx;
+    int is_null_idx = -1;
     
     std::string line;
     if (std::getline(file, line)) {     // 第一行是表头
@@ -97,31 +462,33 @@ void Table::readFromFile(const std::string& filename) {
         }
     }
 
+    if (is_null_idx != -1) {
+        headers.erase(headers.begin() + is_null_idx);
+        share_types.erase(share_types.begin() + is_null_idx);
+    }
+    initColumns();
+
     // 读取文件中的表不需要手动输入max_freqs信息
     
     while (std::getline(file, line)) {
-        std::vector<std::any> row;
         std::istringstream iss(line);
         std::string value;
-        int i = 0;  // 记录是第几列的数据，用于确定此列对应的共享类型
+        int i = 0;  // 记录是第几列的数据
+        int j = 0;  // 记录是第几个数据列
         while (iss >> value) {
             if (i == is_null_idx) {
-                is_null.push_back(convertStringToData(value, share_types[i]));
+                appendValueFromString(is_null, value);
             } else {
-                row.push_back(convertStringToData(value, share_types[i]));
+                appendValueFromString(columns[j++], value);
             }
             i++;
         }
-        data.push_back(row);
     }
 
-    if (is_null_idx != -1) {
-        headers.erase(headers.begin() + is_null_idx);
-        share_types.erase(share_types.begin() + is_null_idx);
-    } else {
+    if (is_null_idx == -1) {
         // 为默认INT_MODE的输入文件添加isNull
         if (mode == INT_MODE) {
-            is_null.assign(data.size(), 0);
+            is_null.resize(size());
         }
     }
 
@@ -133,10 +500,11 @@ void Table::readFromString(const std::string& str) {
     std::istringstream iss(str);
     
     headers.clear();
-    data.clear();
+    share_types.clear();
+    columns.clear();
     is_null.clear();
     
-    int is_null_idx;
+    int is_null_idx = -1;
     
     std::string line;
     if (std::getline(iss, line)) {
@@ -170,6 +538,12 @@ void Table::readFromString(const std::string& str) {
         }
     }
 
+    if (is_null_idx != -1) {
+        headers.erase(headers.begin() + is_null_idx);
+        share_types.erase(share_types.begin() + is_null_idx);
+    }
+    initColumns();
+
     // 如果是通过字符串读取表，则第三行已经被设定为最大频率信息，读取即可
     if (std::getline(iss, line)) {     // 第三行是最大频率
         auto mfs_str = split(line);
@@ -179,26 +553,19 @@ void Table::readFromString(const std::string& str) {
     }
     
     while (std::getline(iss, line)) {
-        std::vector<std::any> row;
         std::istringstream lineStream(line);
         std::string value;
-        int i = 0;  // 记录是第几列的数据，用于确定此列对应的共享类型
+        int i = 0;  // 记录是第几列的数据
+        int j = 0;  // 记录是第几个数据列
         while (lineStream >> value) {
             if (i == is_null_idx) {
-                is_null.push_back(convertStringToData(value, share_types[i]));
+                appendValueFromString(is_null, value);
             } else {
-                row.push_back(convertStringToData(value, share_types[i]));
+                appendValueFromString(columns[j++], value);
             }
             i++;
         }
-        data.push_back(row);
     }
-
-    if (is_null_idx != -1) {
-        headers.erase(headers.begin() + is_null_idx);
-        share_types.erase(share_types.begin() + is_null_idx);
-    }
-
 }
 
 std::string Table::toString() const {
@@ -247,15 +614,16 @@ std::string Table::toString() const {
     }
     
     // 转换数据
-    for (int i = 0; i < data.size(); i++) {
+    size_t rows = size();
+    for (size_t i = 0; i < rows; i++) {
         oss << "\n";
-        for (size_t j = 0; j < data[i].size(); ++j) {
-            oss << convertDataToString(data[i][j]);
-            if (j < data[i].size() - 1) {
+        for (size_t j = 0; j < columns.size(); ++j) {
+            oss << valueToString(columns[j], i);
+            if (j < columns.size() - 1) {
                 oss << " ";
             } else {
                 if (!is_null.empty()) {
-                    oss << " " + convertDataToString(is_null[i]);
+                    oss << " " + valueToString(is_null, i);
                 }
             }
         }
@@ -264,6 +632,147 @@ std::string Table::toString() const {
     return oss.str();
 }
 
+static const uint32_t TABLE_BINARY_MAGIC = 0x32425450;     // "PTB2"
+// 数据列分量的编码方式
+static const uint8_t PART_INTS = 0;     // 原始int32数组
+static const uint8_t PART_BITS = 1;     // 取值全为0/1，按位压缩为uint64数组
+
+// 编码时每写满一段就调用一次flush，由调用方决定是否将缓冲区交出并清空
+// 大的数据分量按BINARY_CHUNK_ROWS行切段写入，使分块输出时缓冲区不必容纳整列
+static const size_t BINARY_CHUNK_ROWS = 1 << 16;
+
+template <typename Flush>
+static void encodeTable(const Table& table, std::string& bin, Flush&& flush) {
+    size_t rows = table.size();
+    bool has_is_null = !table.is_null.empty();
+    BufferWriter writer(bin);
+
+    // 表头
+    writer.writeU32(TABLE_BINARY_MAGIC);
+    writer.writeU32(table.mode);
+    writer.writeU32(table.columns.size());
+    writer.writeU64(rows);
+    writer.writeU8(has_is_null ? 1 : 0);
+    for (size_t j = 0; j < table.columns.size(); j++) {
+        writer.writeString(table.headers[j]);
+        writer.writeU32(table.share_types[j]);
+    }
+    writer.writeU32(table.max_freqs.size());
+    for (const auto& mf : table.max_freqs) {
+        writer.writeU64(mf);
+    }
+    flush();
+
+    // 数据块，按列、按分量依次写入，每个分量前有一个字节的编码方式
+    std::vector<uint64_t> words;
+    for (size_t j = 0; j < table.columns.size(); j++) {
+        const auto& column = table.columns[j];
+        for (u_int k = 0; k < column.partNum(); k++) {
+            const auto& values = column.cpart(k);
+            bool packed = table.share_types[j] == BINARY_SHARING &&
+                          std::all_of(values.begin(), values.end(), [](int v) { return v == 0 || v == 1; });
+            writer.writeU8(packed ? PART_BITS : PART_INTS);
+            // BINARY_CHUNK_ROWS是字长的整数倍，每段的位压缩结果可直接接在前一段之后
+            for (size_t begin = 0; begin < rows; begin += BINARY_CHUNK_ROWS) {
+                size_t end = std::min(rows, begin + BINARY_CHUNK_ROWS);
+                if (packed) {
+                    words.assign(BitColumn::wordCount(end - begin), 0);
+                    for (size_t r = begin; r < end; r++) {
+                        words[(r - begin) / BitColumn::WORD_BITS] |= uint64_t(values[r]) << ((r - begin) % BitColumn::WORD_BITS);
+                    }
+                    writer.writeWords(words.data(), words.size());
+                } else {
+                    writer.writeInts(values.data() + begin, end - begin);
+                }
+                flush();
+            }
+        }
+    }
+    if (has_is_null) {
+        for (u_int k = 0; k < table.is_null.partNum(); k++) {
+            writer.writeWords(table.is_null.cwords(k).data(), BitColumn::wordCount(rows));
+            flush();
+        }
+    }
+}
+
+std::string Table::toBinary() const {
+    size_t rows = size();
+    std::string bin;
+    bin.reserve(64 + headers.size() * 16 + columns.size() * partNum() * (rows * sizeof(int32_t) + 1) +
+                partNum() * BitColumn::wordCount(rows) * sizeof(uint64_t));
+    encodeTable(*this, bin, [] {});
+    return bin;
+}
+
+void Table::writeBinary(size_t block_bytes, const std::function<void(std::string_view)>& sink) const {
+    std::string bin;
+    bin.reserve(block_bytes + BINARY_CHUNK_ROWS * sizeof(int32_t));
+    encodeTable(*this, bin, [&] {
+        if (bin.size() >= block_bytes) {
+            sink(bin);
+            bin.clear();
+        }
+    });
+    if (!bin.empty()) {
+        sink(bin);
+    }
+}
+
+void Table::readFromBinary(std::string_view bin) {
+    BufferReader reader(bin);
+
+    if (reader.readU32() != TABLE_BINARY_MAGIC) {
+        throw std::invalid_argument("Invalid argument in readFromBinary(): Not a binary table");
+    }
+    if (reader.readU32() != mode) {
+        throw std::invalid_argument("Invalid argument in readFromBinary(): Binary table mode does not match table mode");
+    }
+    uint32_t column_num = reader.readU32();
+    uint64_t rows = reader.readU64();
+    bool has_is_null = reader.readU8() != 0;
+
+    headers.clear();
+    share_types.clear();
+    max_freqs.clear();
+    for (uint32_t j = 0; j < column_num; j++) {
+        headers.emplace_back(reader.readString());
+        share_types.push_back(reader.readU32());
+    }
+    uint32_t mf_num = reader.readU32();
+    for (uint32_t j = 0; j < mf_num; j++) {
+        max_freqs.push_back(reader.readU64());
+    }
+
+    // 直接读入预先分配好的列
+    initColumns(rows);
+    std::vector<uint64_t> words(BitColumn::wordCount(rows));
+    for (auto& column : columns) {
+        for (u_int k = 0; k < column.partNum(); k++) {
+            auto& values = column.part(k);
+            uint8_t encoding = reader.readU8();
+            if (encoding == PART_BITS) {
+                reader.readWords(words.data(), words.size());
+                for (size_t r = 0; r < rows; r++) {
+                    values[r] = (words[r / BitColumn::WORD_BITS] >> (r % BitColumn::WORD_BITS)) & 1;
+                }
+            } else if (encoding == PART_INTS) {
+                reader.readInts(values.data(), rows);
+            } else {
+                throw std::invalid_argument("Invalid argument in readFromBinary(): Unknown column encoding " + std::to_string(encoding));
+            }
+        }
+    }
+    if (has_is_null) {
+        for (u_int k = 0; k < is_null.partNum(); k++) {
+            reader.readWords(is_null.words(k).data(), BitColumn::wordCount(rows));
+            is_null.clearTail(k);
+        }
+    } else {
+        is_null.clear();
+    }
+}
+
 // TODO 添加新增列的最大频率统计
 void Table::addColumn(const std::string& column_name, u_int share_type) {       
     // 检查列名是否存在
@@ -282,31 +791,14 @@ void Table::addColumn(const std::string& column_name, u_int share_type) {
         }
     }
 
+    size_t rows = size();
     headers.push_back(column_name);
     share_types.push_back(share_type);
-    
-    for (u_int i = 0; i < data.size(); i++) {
-        switch (mode) {
-            case INT_MODE: {
-                data[i].push_back(0);
-                break;
-            }
-            case SHARE_TUPLE_MODE: {
-                data[i].push_back(ShareTuple({0, 0, 0}, share_type));
-                break;
-            }
-            case SHARE_PAIR_MODE: {
-                data[i].push_back(SharePair({0, 0}, share_type));
-                break;
-            }
-            default:
-                throw std::runtime_error("Runtime error in addColumn(): Unsupported data mode");
-        }
-    }
+    columns.emplace_back(partNum(), rows);
 }
 
 // TODO 添加新增列的最大频率统计
-void Table::addColumn(const std::string& column_name, u_int share_type, const std::vector<std::any>& column_data) {
+void Table::addColumn(const std::string& column_name, u_int share_type, const Column& column_data) {
     // 检查列名是否存在
     if (std::find(headers.begin(), headers.end(), column_name) != headers.end()) {
         throw std::invalid_argument("Bad argument in addColumn(): Column header already exists");
@@ -323,44 +815,27 @@ void Table::addColumn(const std::string& column_name, u_int share_type, const st
         }
     }
 
-    // 检查数据长度是否与现有行匹配
-    if (!data.empty() && column_data.size() != data.size()) {
+    // 检查数据长度和分量个数是否与现有行匹配
+    if (!columns.empty() && column_data.size() != size()) {
         throw std::invalid_argument("Bad argument in addColumn(): new column size doesn't match existing rows");
     }
+    if (column_data.partNum() != partNum()) {
+        throw std::invalid_argument("Bad argument in addColumn(): new column doesn't match table mode");
+    }
 
     headers.push_back(column_name);
     share_types.push_back(share_type);
-
-    // 如果是第一列，则直接添加数据
-    if (data.empty()) {
-        data.resize(column_data.size());
-    }
-
-    // 添加新列数据
-    for (u_int i = 0; i < column_data.size(); i++) {
-        data[i].push_back(column_data[i]);
-    }
+    columns.push_back(column_data);
 }
 
-std::vector<std::any> Table::getColumn(const std::string& col_name) {
+const Column& Table::getColumn(const std::string& col_name) const {
     // 查找列名对应的索引
-    auto it = std::find(headers.begin(), headers.end(), col_name);
-    if (it == headers.end()) {
+    int col_idx = getColumnIdx(col_name);
+    if (col_idx == -1) {
         throw std::invalid_argument("Invalid argument in Table::getColumn(): Column name not found");
     }
     
-    size_t col_idx = std::distance(headers.begin(), it);
-    
-    // 创建结果向量并预分配空间
-    std::vector<std::any> result;
-    result.reserve(data.size());
-    
-    // 提取指定列的所有数据
-    for (const auto& row : data) {
-        result.push_back(row[col_idx]);
-    }
-    
-    return result;
+    return columns[col_idx];
 }
 
 int Table::getColumnIdx(const std::string& col_name) const {
@@ -370,76 +845,52 @@ int Table::getColumnIdx(const std::string& col_name) const {
     return std::distance(headers.begin(), it);
 }
 
-std::vector<std::vector<std::any>> Table::select(std::vector<std::string> col_names) const {
-    std::vector<int> col_idxs;
+Table Table::select(std::vector<std::string> col_names) const {
+    Table result(this->mode);
+    result.epsilon = this->epsilon;
     for (auto col_name : col_names) {
         int idx = getColumnIdx(col_name);
         if (idx == -1) {
-            throw std::runtime_error("Runtime Error in Table::getColumns: no such col called " + col_name);
+            throw std::runtime_error("Runtime Error in Table::select(): no such col called " + col_name);
         }
-        col_idxs.push_back(idx);
-    }
-
-    std::vector<std::vector<std::any>> columns;
-    for (auto item : this->data) {
-        std::vector<std::any> row;
-        for (auto idx : col_idxs) {
-            row.push_back(item[idx]);
+        result.headers.push_back(headers[idx]);
+        result.share_types.push_back(share_types[idx]);
+        result.columns.push_back(columns[idx]);
+        if (idx < max_freqs.size()) {
+            result.max_freqs.push_back(max_freqs[idx]);
         }
-        columns.push_back(row);
     }
+    result.is_null = this->is_null;
 
-    return columns;
-}
-
-/*
-std::vector<std::vector<std::any>> Table::getColumns(std::vector<std::string> col_names) {
-    // 找到所需列的索引
-    std::vector<size_t> col_indices;
-    col_indices.reserve(col_names.size());
-    
-    for (const auto& name : col_names) {
-        auto it = std::find(headers.begin(), headers.end(), name);
-        if (it == headers.end()) {
-            throw std::invalid_argument("Column name '" + name + "' not found");
-        }
-        col_indices.push_back(std::distance(headers.begin(), it));
-    }
-    
-    // 创建结果矩阵并预分配空间
-    std::vector<std::vector<std::any>> result(col_names.size());
-    for (auto& col : result) {
-        col.reserve(data.size());
-    }
-    
-    // 按列填充数据
-    for (size_t i = 0; i < data.size(); ++i) {
-        for (size_t j = 0; j < col_indices.size(); ++j) {
-            result[j].push_back(data[i][col_indices[j]]);
-        }
-    }
-    
     return result;
 }
-*/
 
 std::vector<std::vector<int>> Table::selectAsInt(std::vector<std::string> col_names) const {
     // 要求表本身必须是INT_MODE
     if (this->mode != INT_MODE) {
         throw std::runtime_error("Runtime Error in Table::selectAsInt(): Table has to be INT_MODE");
     }
-    // 提取每一行并转为Int
-    auto columns = this->select(col_names);
-    std::vector<std::vector<int>> columns_int;
-    for (auto& row : columns) {
-        std::vector<int> row_int;
-        for (auto& item : row) {
-            row_int.push_back(std::any_cast<int>(item));
+
+    std::vector<const std::vector<int>*> selected;
+    for (auto col_name : col_names) {
+        int idx = getColumnIdx(col_name);
+        if (idx == -1) {
+            throw std::runtime_error("Runtime Error in Table::selectAsInt(): no such col called " + col_name);
+        }
+        selected.push_back(&columns[idx].part(0));
+    }
+
+    // 按行输出
+    size_t rows = size();
+    std::vector<std::vector<int>> rows_int(rows, std::vector<int>(selected.size()));
+    for (size_t j = 0; j < selected.size(); j++) {
+        const auto& col = *selected[j];
+        for (size_t i = 0; i < rows; i++) {
+            rows_int[i][j] = col[i];
         }
-        columns_int.push_back(row_int);
     }
 
-    return columns_int;
+    return rows_int;
 }
 
 Table Table::slice(int start, int end) const {
@@ -447,12 +898,14 @@ Table Table::slice(int start, int end) const {
     t_slice.headers = this->headers;
     t_slice.share_types = this->share_types;
     t_slice.max_freqs = this->max_freqs;        // 添加的最大频率统计
+    t_slice.epsilon = this->epsilon;
 
     // 复制指定范围的数据和isnull标识符
-    for (int i = start; i < end; i++) {
-        t_slice.data.push_back(this->data[i]);
-        t_slice.is_null.push_back(this->is_null[i]);
+    t_slice.columns.resize(columns.size());
+    for (size_t j = 0; j < columns.size(); j++) {
+        t_slice.columns[j].append(columns[j], start, end);
     }
+    t_slice.is_null.append(is_null, start, end);
 
     return t_slice;
 }
@@ -470,63 +923,66 @@ void Table::concate(const Table& t) {       // 用在BucketJoin中，由于拆
         }
     }
     
-    // 预先分配内存以提高性能
-    data.reserve(data.size() + t.data.size());
-    is_null.reserve(is_null.size() + t.is_null.size());
-    
-    // 将新表的数据追加到当前表
-    data.insert(data.end(), t.data.begin(), t.data.end());
-    is_null.insert(is_null.end(), t.is_null.begin(), t.is_null.end());
+    // 按列追加新表的数据
+    if (columns.empty()) {
+        columns.resize(t.columns.size());
+    }
+    for (size_t j = 0; j < columns.size(); j++) {
+        columns[j].append(t.columns[j], 0, t.columns[j].size());
+    }
+    is_null.append(t.is_null, 0, t.is_null.size());
+}
+
+Table Table::gather(const std::vector<size_t>& rows) const {
+    Table result(this->mode);
+    result.headers = this->headers;
+    result.share_types = this->share_types;
+    result.max_freqs = this->max_freqs;
+    result.epsilon = this->epsilon;
+
+    result.columns.reserve(columns.size());
+    for (const auto& column : columns) {
+        result.columns.push_back(column.gather(rows));
+    }
+    result.is_null = is_null.gather(rows);
+
+    return result;
 }
 
 void Table::sortBy(std::vector<std::string> attrs) {
     // 要求表本身必须是INT_MODE
     if (this->mode != INT_MODE) {
-        throw std::runtime_error("Runtime Error in Table::selectAsInt(): Table has to be INT_MODE");
+        throw std::runtime_error("Runtime Error in Table::sortBy(): Table has to be INT_MODE");
     }
 
-    std::vector<int> col_indices;
+    std::vector<const int*> keys;
     for (const auto& attr : attrs) {
         int idx = getColumnIdx(attr);
         if (idx == -1) {
             throw std::runtime_error("Runtime Error in Attribute Table::sortBy(): " + attr + " not found in table");
         }
-        col_indices.push_back(idx);
+        keys.push_back(columns[idx].part(0).data());
     }
 
-    // 定义比较函数
-    auto comparator = [this, &col_indices](const std::vector<std::any>& row1, const std::vector<std::any>& row2) -> bool {
-        for (int col_idx : col_indices) {
-            // 获取当前比较的值
-            int val1 = std::any_cast<int>(row1[col_idx]);
-            int val2 = std::any_cast<int>(row2[col_idx]);
-
-            if (val1 != val2) {
-                return val1 < val2;
+    // 对行号进行稳定排序，比较时直接读取连续的键列
+    std::vector<size_t> indices(size());
+    std::iota(indices.begin(), indices.end(), 0);       // 索引数组初始为0,1,...,m-1
+    std::stable_sort(indices.begin(), indices.end(), [&keys](size_t i1, size_t i2) {
+        for (const int* key : keys) {
+            if (key[i1] != key[i2]) {
+                return key[i1] < key[i2];
             }
         }
         return false;
-    };
+    });
 
-    // 对is_null标识符同步调整顺序
+    // 按排序后的行号重排每一列以及is_null
+    for (auto& column : columns) {
+        column = column.gather(indices);
+    }
     if (!is_null.empty()) {
-        // 创建原始索引数组
-        std::vector<size_t> indices(data.size());
-        std::iota(indices.begin(), indices.end(), 0);       // 索引数组初始为1,2,...,m
-        // 根据data的新顺序重新排序indices
-        std::stable_sort(indices.begin(), indices.end(), [this, &comparator](size_t i1, size_t i2) {
-            return comparator(data[i1], data[i2]);
-        });
-        // 使用indices重排is_null
-        std::vector<std::any> new_is_null(is_null.size());
-        for (size_t i = 0; i < indices.size(); i++) {
-            new_is_null[i] = is_null[indices[i]];
-        }
-        is_null = std::move(new_is_null);
+        is_null = is_null.gather(indices);
     }
-
-    // 执行排序
-    std::stable_sort(data.begin(), data.end(), comparator);
 }
 
 void Table::setHeaders(const std::vector<std::string>& new_headers) {
@@ -541,12 +997,18 @@ void Table::setHeaders(const std::vector<std::string>& new_headers) {
     this->headers = new_headers;
 }
 
+Table Table::renamed(const std::vector<std::string>& new_headers) const {
+    Table view(*this);
+    view.setHeaders(new_headers);
+    return view;
+}
+
 Range Table::getColumnValueRange(int col_idx) const {
     if (this->mode != Table::INT_MODE) {
         throw std::runtime_error("Runtime Error in Table::getColumnValueRange(): only supports INT_MODE table");
     }
 
-    if (data.empty()) {
+    if (empty()) {
         throw std::runtime_error("Runtime Error in Table::getColumnValueRange(): Cannot get value range from empty table");
     }
 
@@ -554,18 +1016,11 @@ Range Table::getColumnValueRange(int col_idx) const {
         throw std::runtime_error("Runtime Error in Table::getColumnValueRange(): Column index out of range");
     }
 
-    // 用第一行初始化范围
-    int min_val = std::any_cast<int>(data[0][col_idx]);
-    int max_val = min_val;
-
     // 遍历该列所有的值
-    for (const auto& row : data) {
-        int val = std::any_cast<int>(row[col_idx]);
-        min_val = std::min(min_val, val);
-        max_val = std::max(max_val, val);
-    }
+    const auto& values = columns[col_idx].part(0);
+    auto [min_it, max_it] = std::minmax_element(values.begin(), values.end());
 
-    return {min_val, max_val};
+    return {*min_it, *max_it};
 }
 
 std::vector<Range> Table::getAllColumnValueRange() const {
@@ -573,7 +1028,7 @@ std::vector<Range> Table::getAllColumnValueRange() const {
         throw std::runtime_error("Runtime Error in Table::getColumnValueRange(): only supports INT_MODE table");
     }
 
-    if (data.empty()) {
+    if (empty()) {
         throw std::runtime_error("Runtime Error in Table::getColumnValueRange(): Cannot get value range from empty table");
     }
 
@@ -591,9 +1046,9 @@ void Table::padding(const uint64_t& padding_to) {
 
     std::vector<Range> value_ranges;
 
-    if (this->data.empty()) {
+    if (this->empty()) {
         for (int i = 0; i < this->headers.size(); i++) {
-            value_ranges.push_back({1, MOD - 1});
+            value_ranges.push_back({1, MAX_SHARE_VALUE});
         }
     } else {
         // 获取所有列的值域
@@ -608,7 +1063,7 @@ void Table::padding(const uint64_t& padding_to, std::vector<Range> value_ranges)
         throw std::runtime_error("Runtime Error in Table::padding(): Padding only supports INT_MODE table");
     }
 
-    if (!this->data.empty()) {
+    if (!this->empty()) {
         value_ranges = this->getAllColumnValueRange();
     }
 
@@ -616,27 +1071,27 @@ void Table::padding(const uint64_t& padding_to, std::vector<Range> value_ranges)
     std::random_device rd;
     std::mt19937 gen(rd());
 
-    // 为每列创建随机数分布
-    std::vector<std::uniform_int_distribution<int>> distributions;
-    for (const auto& range : value_ranges) {
-        distributions.emplace_back(range.first, range.second);
-    }
-    
     // 先清除数据中原有的dummy
     this->clearDummy();
 
-    // 填充dummy值
-    while (this->data.size() < padding_to) {
-        std::vector<std::any> dummy_row;
-        dummy_row.reserve(this->headers.size());
+    size_t current = this->size();
+    if (current >= padding_to) {
+        return;
+    }
+    if (columns.size() != headers.size()) {
+        initColumns(current);
+    }
 
-        for (int col = 0; col < this->headers.size(); col++) {
-            dummy_row.push_back(distributions[col](gen));
+    // 按列一次性填充dummy值
+    for (size_t col = 0; col < columns.size(); col++) {
+        std::uniform_int_distribution<int> distribution(value_ranges[col].first, value_ranges[col].second);
+        auto& values = columns[col].part(0);
+        values.reserve(padding_to);
+        for (size_t i = current; i < padding_to; i++) {
+            values.push_back(distribution(gen));
         }
-
-        this->data.push_back(dummy_row);
-        this->is_null.push_back(1);
     }
+    is_null.resize(padding_to, 1);
 }
 
 void Table::clearDummy() {
@@ -645,29 +1100,33 @@ void Table::clearDummy() {
         throw std::runtime_error("Runtime Error in Table::clearDummy(): can only be called in INT_MODE.");
     }
 
-    std::vector<std::vector<std::any>> new_data;
-    std::vector<std::any> new_is_null;
+    if (is_null.empty()) {
+        return;
+    }
 
-    for (size_t i = 0; i < data.size(); ++i) {
-        try {
-            int null_flag = std::any_cast<int>(is_null[i]);
-            if (null_flag != 1) { // 保留非dummy数据
-                new_data.push_back(std::move(data[i]));
-                new_is_null.push_back(std::move(is_null[i]));
-            }
-        } catch (const std::bad_any_cast &e) {
-            throw std::runtime_error("Runtime Error in Table::clearDummy(): Invalid type in is_null array when in INT_MODE.");
+    // 收集非dummy的行号
+    size_t rows = is_null.size();
+    std::vector<size_t> kept;
+    kept.reserve(rows);
+    for (size_t i = 0; i < rows; ++i) {
+        if (is_null.getInt(i) != 1) {    // 保留非dummy数据
+            kept.push_back(i);
         }
     }
+    if (kept.size() == rows) {
+        return;
+    }
 
-    // 更新data和is_null数组
-    data = std::move(new_data);
-    is_null = std::move(new_is_null);
+    // 更新各列和is_null
+    for (auto& column : columns) {
+        column = column.gather(kept);
+    }
+    is_null = is_null.gather(kept);
 }
 
 void Table::normalize() {       // 添加对max_freqs的更新
     // 如果没有头部或数据，直接返回
-    if (headers.empty() || data.empty()) {
+    if (headers.empty() || empty()) {
         return;
     }
     
@@ -681,71 +1140,47 @@ void Table::normalize() {       // 添加对max_freqs的更新
     std::sort(indices.begin(), indices.end(), 
               [this](size_t a, size_t b) { return headers[a] < headers[b]; });
     
-    // 创建新的已排序的headers和share_types
+    // 创建新的已排序的headers和share_types，列存储下只需移动整列
     std::vector<std::string> sorted_headers(headers.size());
     std::vector<u_int> sorted_share_types(share_types.size());
     std::vector<uint64_t> sorted_max_freqs(max_freqs.size());
+    std::vector<Column> sorted_columns(columns.size());
     
     for (size_t i = 0; i < indices.size(); ++i) {
         sorted_headers[i] = headers[indices[i]];
         sorted_share_types[i] = share_types[indices[i]];
         sorted_max_freqs[i] = max_freqs[indices[i]];
-    }
-    
-    // 重新排列data中的每一行
-    for (auto& row : data) {
-        if (row.size() >= indices.size()) {  // 确保行有足够的元素
-            std::vector<std::any> sorted_row(row.size());
-            for (size_t i = 0; i < indices.size(); ++i) {
-                sorted_row[i] = row[indices[i]];
-            }
-            row = std::move(sorted_row);
-        }
+        sorted_columns[i] = std::move(columns[indices[i]]);
     }
     
     // 用排序后的数据替换原始数据
     headers = std::move(sorted_headers);
     share_types = std::move(sorted_share_types);
     max_freqs = std::move(sorted_max_freqs);
+    columns = std::move(sorted_columns);
 }
 
 void Table::calcualteMaxFreqs() {
     // 如果数据为空，返回空结果
-    if (data.empty() || mode != INT_MODE) {
+    if (empty() || mode != INT_MODE) {
         this->max_freqs.resize(headers.size(), 0);
         return;
     }
     
-    // 确定列数（使用第一行的元素数量）
-    size_t numColumns = data[0].size();
+    size_t numColumns = columns.size();
     std::vector<uint64_t> maxFrequencies(numColumns, 0);
     
     // 对每一列进行处理
     for (size_t col = 0; col < numColumns; ++col) {
         // 使用unordered_map统计频率，键为int值，值为出现次数
+        const auto& values = columns[col].part(0);
         std::unordered_map<int, uint64_t> frequencyMap;
+        frequencyMap.reserve(values.size());
         
-        // 统计该列中每个值的频率
-        for (const auto& row : data) {
-            // 检查列索引是否有效
-            if (col < row.size()) {
-                try {
-                    int value = std::any_cast<int>(row[col]);
-                    frequencyMap[value]++;
-                } catch (const std::bad_any_cast&) {
-                    // 如果类型转换失败，可以选择忽略或记录错误
-                    std::cerr << "Warning: Value at row " << (&row - &data[0]) 
-                              << ", column " << col << " is not an int." << default_color << std::endl;
-                }
-            }
-        }
-        
-        // 找出该列中频率最高的值
+        // 统计该列中每个值的频率，并记录最高的频率
         uint64_t maxFreq = 0;
-        for (const auto& pair : frequencyMap) {
-            if (pair.second > maxFreq) {
-                maxFreq = pair.second;
-            }
+        for (int value : values) {
+            maxFreq = std::max(maxFreq, ++frequencyMap[value]);
         }
         
         // 存储该列的最大频率
@@ -790,6 +1225,311 @@ void log_process(size_t current, size_t total) {
     }
 }
 
+// 哈希连接的并行参数：两表合计行数达到PARALLEL_JOIN_ROWS时使用基数划分的并行连接，结果行数达到该值时并行拼接各列
+static const size_t PARALLEL_JOIN_ROWS = 1 << 16;
+static const size_t RADIX_PARTITION_ROWS = 1 << 12;    // 每个分区建表的目标行数
+static const size_t MAX_RADIX_PARTITIONS = 1 << 12;
+
+// 按匹配的行号对，逐列拼出连接结果：[left的所有列] + [right中right_cols指定的列]
+static void gatherJoinResult(Table& result, const Table& left, const std::vector<size_t>& left_rows,
+                             const Table& right, const std::vector<size_t>& right_cols,
+                             const std::vector<size_t>& right_rows) {
+    // 各列互不相关，结果较大时并行拼接
+    size_t left_cols = left.columns.size();
+    result.columns.assign(left_cols + right_cols.size(), Column());
+    #pragma omp parallel for schedule(dynamic) if (left_rows.size() >= PARALLEL_JOIN_ROWS)
+    for (size_t j = 0; j < result.columns.size(); j++) {
+        result.columns[j] = j < left_cols ? left.columns[j].gather(left_rows) : right.columns[right_cols[j - left_cols]].gather(right_rows);
+    }
+    result.is_null = BitColumn(1, left_rows.size());
+}
+
+// 哈希连接的连接键：1~2列打包为一个64位整数，3~4列打包为两个64位整数
+struct JoinKey128 {
+    uint64_t lo;
+    uint64_t hi;
+    bool operator==(const JoinKey128& other) const { return lo == other.lo && hi == other.hi; }
+};
+
+template <size_t K>
+using JoinKey = std::conditional_t<(K <= 2), uint64_t, JoinKey128>;
+
+// 将第row行的K个连接键按32位依次打包
+template <size_t K>
+static inline JoinKey<K> packJoinKey(const std::vector<const int*>& keys, size_t row) {
+    uint64_t w[2] = {0, 0};
+    for (size_t c = 0; c < K; c++) {
+        w[c / 2] |= uint64_t(static_cast<uint32_t>(keys[c][row])) << (32 * (c % 2));
+    }
+    if constexpr (K <= 2) {
+        return w[0];
+    } else {
+        return JoinKey128{w[0], w[1]};
+    }
+}
+
+// splitmix64的混合函数
+static inline uint64_t mixHash(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+static inline uint64_t hashJoinKey(uint64_t key) { return mixHash(key); }
+static inline uint64_t hashJoinKey(const JoinKey128& key) { return mixHash(key.lo ^ mixHash(key.hi)); }
+
+// 开放寻址（线性探测）的连接哈希表：每个不同的键占一个槽，槽中记录该键的行号在rows中的区间
+// rows按键分组连续存放，组内保持建表时的行序
+// 建表和探测的行由ids给出（为nullptr时为0~n-1），划分后的连接只处理各自分区中的行
+template <size_t K>
+class FlatJoinTable {
+public:
+    FlatJoinTable(const std::vector<const int*>& keys, const BitColumn& is_null, const size_t* ids, size_t n) {
+        size_t capacity = 16;
+        while (capacity < 2 * n) {
+            capacity <<= 1;
+        }
+        mask = capacity - 1;
+        slots.assign(capacity, Slot{});
+
+        // 第一遍插入各键并计数，第二遍按前缀和把行号写入各组
+        std::vector<size_t> row_slot(n, EMPTY_SLOT);
+        for (size_t i = 0; i < n; i++) {
+            size_t row = ids ? ids[i] : i;
+            if (is_null.getInt(row) != 0) {
+                continue;
+            }
+            JoinKey<K> key = packJoinKey<K>(keys, row);
+            size_t s = hashJoinKey(key) & mask;
+            while (slots[s].count != 0 && !(slots[s].key == key)) {
+                s = (s + 1) & mask;
+            }
+            slots[s].key = key;
+            slots[s].count++;
+            row_slot[i] = s;
+        }
+        size_t begin = 0;
+        for (auto& slot : slots) {
+            slot.begin = begin;
+            begin += slot.count;
+            slot.count = 0;
+        }
+        rows.resize(begin);
+        for (size_t i = 0; i < n; i++) {
+            if (row_slot[i] != EMPTY_SLOT) {
+                Slot& slot = slots[row_slot[i]];
+                rows[slot.begin + slot.count++] = ids ? ids[i] : i;
+            }
+        }
+    }
+
+    // 逐批探测：先为一批行计算键和哈希并预取对应的槽，再依次查找，每行只计算一次哈希
+    // 对每个匹配调用emit(probe_row, build_row)，按探测的行序、同一行内按建表的行序
+    template <typename Emit>
+    void probe(const std::vector<const int*>& keys, const BitColumn& is_null, const size_t* ids, size_t n, Emit&& emit) const {
+        static constexpr size_t BATCH = 16;
+        JoinKey<K> batch_keys[BATCH];
+        size_t batch_slots[BATCH];
+        for (size_t base = 0; base < n; base += BATCH) {
+            size_t m = std::min(BATCH, n - base);
+            for (size_t t = 0; t < m; t++) {
+                size_t row = ids ? ids[base + t] : base + t;
+                batch_keys[t] = packJoinKey<K>(keys, row);
+                batch_slots[t] = hashJoinKey(batch_keys[t]) & mask;
+                __builtin_prefetch(&slots[batch_slots[t]]);
+            }
+            for (size_t t = 0; t < m; t++) {
+                size_t row = ids ? ids[base + t] : base + t;
+                if (is_null.getInt(row) != 0) {
+                    continue;
+                }
+                size_t s = batch_slots[t];
+                while (slots[s].count != 0 && !(slots[s].key == batch_keys[t])) {
+                    s = (s + 1) & mask;
+                }
+                const Slot& slot = slots[s];
+                for (size_t j = slot.begin; j < slot.begin + slot.count; j++) {
+                    emit(row, rows[j]);
+                }
+            }
+        }
+    }
+
+private:
+    static constexpr size_t EMPTY_SLOT = SIZE_MAX;
+
+    struct Slot {
+        JoinKey<K> key{};
+        size_t begin = 0;
+        size_t count = 0;       // 为0表示空槽
+    };
+
+    std::vector<Slot> slots;
+    std::vector<size_t> rows;
+    size_t mask;
+};
+
+// 按连接键的哈希将非空行划分到partitions个分区（2的幂，取哈希的高位），各分区内保持行序
+// 各线程先统计自己负责的一段行在各分区的行数，再按（分区, 线程）的次序写入，offsets[p]为第p个分区在ids中的起点
+template <size_t K>
+static void radixPartition(const std::vector<const int*>& keys, const BitColumn& is_null, size_t n, size_t partitions,
+                           std::vector<size_t>& ids, std::vector<size_t>& offsets) {
+    int shift = 64 - __builtin_ctzll(partitions);
+    size_t threads = omp_get_max_threads();
+    size_t chunk = (n + threads - 1) / threads;
+    std::vector<uint32_t> part_of(n);
+    std::vector<std::vector<size_t>> hist(threads, std::vector<size_t>(partitions, 0));
+    #pragma omp parallel for schedule(static, 1)
+    for (size_t t = 0; t < threads; t++) {
+        for (size_t i = t * chunk; i < std::min(n, (t + 1) * chunk); i++) {
+            if (is_null.getInt(i) != 0) {
+                part_of[i] = UINT32_MAX;
+                continue;
+            }
+            // partitions为1时shift为64，单独处理
+            part_of[i] = partitions == 1 ? 0 : hashJoinKey(packJoinKey<K>(keys, i)) >> shift;
+            hist[t][part_of[i]]++;
+        }
+    }
+    offsets.assign(partitions + 1, 0);
+    size_t total = 0;
+    for (size_t p = 0; p < partitions; p++) {
+        offsets[p] = total;
+        for (size_t t = 0; t < threads; t++) {
+            size_t count = hist[t][p];
+            hist[t][p] = total;
+            total += count;
+        }
+    }
+    offsets[partitions] = total;
+    ids.resize(total);
+    #pragma omp parallel for schedule(static, 1)
+    for (size_t t = 0; t < threads; t++) {
+        for (size_t i = t * chunk; i < std::min(n, (t + 1) * chunk); i++) {
+            if (part_of[i] != UINT32_MAX) {
+                ids[hist[t][part_of[i]]++] = i;
+            }
+        }
+    }
+}
+
+// 基数划分的并行哈希连接：两表按同样的哈希高位划分，各分区的建表和探测互不相关，在所有线程上并行
+// 先统计每个探测行的匹配数，前缀和得到各行在结果中的位置，再并行写出，结果的行序与串行的哈希连接相同
+template <size_t K>
+static void radixHashJoin(const std::vector<const int*>& build_keys, const BitColumn& build_null, size_t build_n,
+                          const std::vector<const int*>& probe_keys, const BitColumn& probe_null, size_t probe_n,
+                          std::vector<size_t>& probe_rows, std::vector<size_t>& build_rows) {
+    // 每个分区的建表约RADIX_PARTITION_ROWS行，使其哈希表留在缓存中；分区数至少为线程数的4倍，便于负载均衡
+    size_t partitions = 1;
+    size_t threads = omp_get_max_threads();
+    while (partitions < MAX_RADIX_PARTITIONS && (partitions < 4 * threads || build_n / partitions > RADIX_PARTITION_ROWS)) {
+        partitions <<= 1;
+    }
+    std::vector<size_t> build_ids, build_offsets, probe_ids, probe_offsets;
+    radixPartition<K>(build_keys, build_null, build_n, partitions, build_ids, build_offsets);
+    radixPartition<K>(probe_keys, probe_null, probe_n, partitions, probe_ids, probe_offsets);
+
+    // 各分区的匹配先写入分区自己的缓冲区，同时统计每个探测行的匹配数；每个探测行只属于一个分区，不会冲突
+    std::vector<size_t> matches(probe_n + 1, 0);
+    std::vector<std::vector<size_t>> part_build_rows(partitions);
+    #pragma omp parallel for schedule(dynamic)
+    for (size_t p = 0; p < partitions; p++) {
+        FlatJoinTable<K> table(build_keys, build_null, build_ids.data() + build_offsets[p], build_offsets[p + 1] - build_offsets[p]);
+        table.probe(probe_keys, probe_null, probe_ids.data() + probe_offsets[p], probe_offsets[p + 1] - probe_offsets[p],
+                    [&](size_t probe_row, size_t build_row) {
+                        matches[probe_row]++;
+                        part_build_rows[p].push_back(build_row);
+                    });
+    }
+    // 前缀和得到每个探测行的匹配在结果中的起点
+    size_t total = 0;
+    for (size_t i = 0; i < probe_n; i++) {
+        size_t count = matches[i];
+        matches[i] = total;
+        total += count;
+    }
+    matches[probe_n] = total;
+    probe_rows.resize(total);
+    build_rows.resize(total);
+    // 分区内的匹配按探测行的行序排列，依次对应各探测行的区间
+    #pragma omp parallel for schedule(dynamic)
+    for (size_t p = 0; p < partitions; p++) {
+        size_t j = 0;
+        for (size_t k = probe_offsets[p]; k < probe_offsets[p + 1]; k++) {
+            size_t row = probe_ids[k];
+            for (size_t pos = matches[row]; pos < matches[row + 1]; pos++) {
+                probe_rows[pos] = row;
+                build_rows[pos] = part_build_rows[p][j++];
+            }
+        }
+    }
+}
+
+// 连接键超过4列时的哈希连接，键以字符串拼接
+static void stringHashJoin(const std::vector<const int*>& build_keys, const BitColumn& build_null, size_t build_n,
+                           const std::vector<const int*>& probe_keys, const BitColumn& probe_null, size_t probe_n,
+                           std::vector<size_t>& probe_rows, std::vector<size_t>& build_rows) {
+    std::unordered_map<std::string, std::vector<size_t>> hash_table;
+    for (size_t i = 0; i < build_n; i++) {
+        if (build_null.getInt(i) != 0) {
+            continue;
+        }
+        std::string keys;
+        for (const int* key : build_keys) {
+            keys += (std::to_string(key[i]) + " ");
+        }
+        hash_table[keys].push_back(i);
+    }
+    for (size_t i = 0; i < probe_n; i++) {
+        if (probe_null.getInt(i) != 0) {
+            continue;
+        }
+        std::string keys;
+        for (const int* key : probe_keys) {
+            keys += (std::to_string(key[i]) + " ");
+        }
+        auto it = hash_table.find(keys);
+        if (it != hash_table.end()) {
+            for (size_t j : it->second) {
+                probe_rows.push_back(i);
+                build_rows.push_back(j);
+            }
+        }
+    }
+}
+
+// 按连接键列数选择特化的连接核
+template <size_t K>
+static void flatHashJoin(const std::vector<const int*>& build_keys, const BitColumn& build_null, size_t build_n,
+                         const std::vector<const int*>& probe_keys, const BitColumn& probe_null, size_t probe_n,
+                         std::vector<size_t>& probe_rows, std::vector<size_t>& build_rows) {
+    // 表足够大、且不在其他并行区域（如BucketJoin的各个桶）中时，使用基数划分的并行连接
+    if (build_n + probe_n >= PARALLEL_JOIN_ROWS && omp_get_max_threads() > 1 && !omp_in_parallel()) {
+        radixHashJoin<K>(build_keys, build_null, build_n, probe_keys, probe_null, probe_n, probe_rows, build_rows);
+        return;
+    }
+    FlatJoinTable<K>(build_keys, build_null, nullptr, build_n).probe(probe_keys, probe_null, nullptr, probe_n,
+        [&](size_t probe_row, size_t build_row) {
+            probe_rows.push_back(probe_row);
+            build_rows.push_back(build_row);
+        });
+}
+
+// 以build的连接键建表、以probe的连接键探测，按probe的行序输出匹配的行号对，同一probe行的匹配按build的行序排列
+static void hashJoinRows(const std::vector<const int*>& build_keys, const BitColumn& build_null, size_t build_n,
+                         const std::vector<const int*>& probe_keys, const BitColumn& probe_null, size_t probe_n,
+                         std::vector<size_t>& probe_rows, std::vector<size_t>& build_rows) {
+    switch (build_keys.size()) {
+        case 1: flatHashJoin<1>(build_keys, build_null, build_n, probe_keys, probe_null, probe_n, probe_rows, build_rows); break;
+        case 2: flatHashJoin<2>(build_keys, build_null, build_n, probe_keys, probe_null, probe_n, probe_rows, build_rows); break;
+        case 3: flatHashJoin<3>(build_keys, build_null, build_n, probe_keys, probe_null, probe_n, probe_rows, build_rows); break;
+        case 4: flatHashJoin<4>(build_keys, build_null, build_n, probe_keys, probe_null, probe_n, probe_rows, build_rows); break;
+        default: stringHashJoin(build_keys, build_null, build_n, probe_keys, probe_null, probe_n, probe_rows, build_rows); break;
+    }
+}
+
 Table Join(const Table& table1, const Table& table2) {
     // 检查待连接的表是否都为INT_MODE，否则不提供连接操作
     if (!(table1.mode == Table::INT_MODE && table2.mode == Table::INT_MODE)) {
@@ -876,44 +1616,44 @@ Table Join(const Table& table1, const Table& table2) {
             t2_header_str += ")";
         }
     }
-    log("T1" + t1_header_str + " ⋈ T2" + t2_header_str + ", |T1| = " + std::to_string(table1.data.size()) + ", |T2| = " + std::to_string(table2.data.size()) + ", Loop count = " + std::to_string(table1.data.size() * table2.data.size()));
+    log("T1" + t1_header_str + " ⋈ T2" + t2_header_str + ", |T1| = " + std::to_string(table1.size()) + ", |T2| = " + std::to_string(table2.size()) + ", Loop count = " + std::to_string(table1.size() * table2.size()));
 
-    // 对每一行数据进行连接
-    for (int i = 0; i < table1.data.size(); i++) {
-        int isNull1 = std::any_cast<int>(table1.is_null[i]);
-        // if (isNull1 == 1) continue;
-        for (int j = 0; j < table2.data.size(); j++) {
-            int isNull2 = std::any_cast<int>(table2.is_null[j]);
-            // if (isNull2 == 1) continue;
+    // 非连接键的table2列号
+    std::vector<size_t> t2_cols;
+    for (size_t k = 0; k < table2.headers.size(); ++k) {
+        if (std::find(commonHeaders.begin(), commonHeaders.end(), table2.headers[k]) == commonHeaders.end()) {
+            t2_cols.push_back(k);
+        }
+    }
 
+    // 对每一行数据进行连接，只记录匹配的行号对
+    std::vector<size_t> t1_rows;
+    std::vector<size_t> t2_rows;
+    const auto& isNull1 = table1.is_null;
+    const auto& isNull2 = table2.is_null;
+    for (size_t i = 0; i < table1.size(); i++) {
+        for (size_t j = 0; j < table2.size(); j++) {
             bool match = true;
             // 检查所有连接键是否匹配
             for (const auto &[idx1, idx2] : keyIndices) {
-                int val1 = std::any_cast<int>(table1.data[i][idx1]);
-                int val2 = std::any_cast<int>(table2.data[j][idx2]);
-                if (val1 != val2) {
+                if (table1.getInt(i, idx1) != table2.getInt(j, idx2)) {
                     match = false;
                     break;
                 }
             }
 
             // 如果所有键都匹配，合并这两行
-            if (match && isNull1 == 0 && isNull2 == 0) {
-                std::vector<std::any> newRow = table1.data[i];
-                for (size_t k = 0; k < table2.headers.size(); ++k) {
-                    if (std::find(commonHeaders.begin(), commonHeaders.end(), table2.headers[k]) ==
-                        commonHeaders.end()) {
-                        newRow.push_back(table2.data[j][k]);
-                    }
-                }
-                result.data.push_back(std::move(newRow));
-                result.is_null.push_back(0);
+            if (match && isNull1.getInt(i) == 0 && isNull2.getInt(j) == 0) {
+                t1_rows.push_back(i);
+                t2_rows.push_back(j);
             }
         }
 
-        log_process(i + 1, table1.data.size());
+        log_process(i + 1, table1.size());
     }
 
+    gatherJoinResult(result, table1, t1_rows, table2, t2_cols, t2_rows);
+
     return result;
 }
 
@@ -923,17 +1663,17 @@ Table Join(const Table& table1, const Table& table2, const uint64_t& padding_to)
     if (padding_to == 0) {
         return result;
     } else if (padding_to == CARTESIAN_BOUND) {
-        result.padding(table1.data.size() * table2.data.size());
-        std::cout << print_color << "Use CARTESIAN_BOUND Padding Strategy: CARTESIAN_BOUND = " << table1.data.size() * table2.data.size() << default_color << std::endl;
+        result.padding(table1.size() * table2.size());
+        std::cout << print_color << "Use CARTESIAN_BOUND Padding Strategy: CARTESIAN_BOUND = " << table1.size() * table2.size() << default_color << std::endl;
     } else if (padding_to == AGM_BOUND) {
         // 确保AGM Bound已经计算，否则填充到笛卡尔积
         if (AGM_BOUND_ == CARTESIAN_BOUND) {
-            result.padding(table1.data.size() * table2.data.size());
+            result.padding(table1.size() * table2.size());
             std::cout << print_color
                       << "Use CARTESIAN_BOUND Padding Strategy due to AGM has not been initialized: CARTESIAN_BOUND = "
-                      << table1.data.size() * table2.data.size() << default_color << std::endl;
+                      << table1.size() * table2.size() << default_color << std::endl;
         } else {
-            result.padding(std::max(AGM_BOUND_, result.data.size()));
+            result.padding(std::max(AGM_BOUND_, result.size()));
             std::cout << print_color << "Use AGM_BOUND Padding Strategy: AGM Bound = " << AGM_BOUND_ << default_color
                       << std::endl;
         }
@@ -955,8 +1695,8 @@ Table Join(const Table& table1, const Table& table2, const uint64_t& padding_to)
             MFs.push_back({table1.max_freqs[key_pair.first], table2.max_freqs[key_pair.second]});
         }
         // 计算当前连接的agm bound和mf bound
-        auto current_agm_bound = Utils::computeAGMBound(table1.headers, table2.headers, table1.data.size(), table2.data.size());
-        auto current_mf_bound = Utils::computeMFBound(MFs, {table1.data.size(), table2.data.size()});
+        auto current_agm_bound = Utils::computeAGMBound(table1.headers, table2.headers, table1.size(), table2.size());
+        auto current_mf_bound = Utils::computeMFBound(MFs, {table1.size(), table2.size()});
 
         if (padding_to == MF_BOUND) {
             result.padding(current_mf_bound);
@@ -969,7 +1709,7 @@ Table Join(const Table& table1, const Table& table2, const uint64_t& padding_to)
         result.padding(MIX_BOUND_);
         log("Use MIX_BOUND Padding Strategy: Mix Bound = " + std::to_string(MIX_BOUND_));
     } else {
-        result.padding(std::max(padding_to, result.data.size()));
+        result.padding(std::max(padding_to, result.size()));
         log("Use Determined Value Padding Strategy: padding_to = " + std::to_string(padding_to));
     }
 
@@ -1002,8 +1742,8 @@ Table Join_Hash(const Table& table1, const Table& table2) {
     }
 
     // 区分大小表
-    size_t n1 = table1.data.size();
-    size_t n2 = table2.data.size();
+    size_t n1 = table1.size();
+    size_t n2 = table2.size();
 
     const Table* smaller_table = (n1 <= n2) ? &table1 : &table2;
     const Table* bigger_table = (n1 <= n2) ? &table2 : &table1;
@@ -1034,8 +1774,8 @@ Table Join_Hash(const Table& table1, const Table& table2) {
         }
     }
 
-    log("T1" + bigger_header_str + " ⋈ T2" + smaller_header_str + ", |T1| = " + std::to_string(bigger_table->data.size()) 
-        + " as probing table, |T2| = " + std::to_string(smaller_table->data.size()) + " as building table");
+    log("T1" + bigger_header_str + " ⋈ T2" + smaller_header_str + ", |T1| = " + std::to_string(bigger_table->size()) 
+        + " as probing table, |T2| = " + std::to_string(smaller_table->size()) + " as building table");
 
     // 构建结果表的表头: result.headers = [bigger.headers] + ([smaller.headers] \ [commonHeaders])
     result.headers = bigger_table->headers;
@@ -1079,49 +1819,31 @@ Table Join_Hash(const Table& table1, const Table& table2) {
         }
     }
 
-    // 初始化哈希表 (keys_str, row)
-    std::unordered_map<std::string, std::vector<const std::vector<std::any>*>> hash_table;
-    // log("Building hash table");
-    for (int i = 0; i < smaller_table->data.size(); i++) {
-        std::string keys;
-        for (const auto& pair : keyIndices) {
-            size_t idx = (n1 <= n2) ? pair.first : pair.second;
-            auto key = std::any_cast<int>(smaller_table->data[i][idx]);
-            keys += (std::to_string(key) + " ");
-        }
-        int isNull = std::any_cast<int>(smaller_table->is_null[i]);
-        if (isNull == 0) {
-            hash_table[keys].push_back(&smaller_table->data[i]);
-        }
-    }
-
-    // log("Probing hash table");
-    for (int i = 0; i < bigger_table->data.size(); i++) {
-        int isNull = std::any_cast<int>(bigger_table->is_null[i]);
-
-        std::string bigger_keys;
-        for (const auto& pair : keyIndices) {
-            size_t idx = (n1 <= n2) ? pair.second : pair.first;
-            auto key = std::any_cast<int>(bigger_table->data[i][idx]);
-            bigger_keys += (std::to_string(key) + " ");
-        }
-        if (hash_table.count(bigger_keys) && isNull == 0) {
-            for (int j = 0; j < hash_table[bigger_keys].size(); j++) {
-                std::vector<std::any> joined_row = bigger_table->data[i];
-                for (int k = 0; k < smaller_table->headers.size(); k++) {
-                    if (std::find(commonHeaders.begin(), commonHeaders.end(), smaller_table->headers[k]) ==
-                        commonHeaders.end()) {
-                        joined_row.push_back((*hash_table[bigger_keys][j])[k]);
-                    }
-                }
-                result.data.push_back(std::move(joined_row));
-                result.is_null.push_back(0);
-            }
+    // 连接键在大小表中对应的列
+    std::vector<const int*> smaller_keys;
+    std::vector<const int*> bigger_keys;
+    for (const auto& pair : keyIndices) {
+        size_t smaller_idx = (n1 <= n2) ? pair.first : pair.second;
+        size_t bigger_idx = (n1 <= n2) ? pair.second : pair.first;
+        smaller_keys.push_back(smaller_table->columns[smaller_idx].part(0).data());
+        bigger_keys.push_back(bigger_table->columns[bigger_idx].part(0).data());
+    }
+    // smaller 中的非连接键列
+    std::vector<size_t> smaller_cols;
+    for (size_t k = 0; k < smaller_table->headers.size(); k++) {
+        if (std::find(commonHeaders.begin(), commonHeaders.end(), smaller_table->headers[k]) == commonHeaders.end()) {
+            smaller_cols.push_back(k);
         }
-
-        // log_process(i + 1, bigger_table->data.size());
     }
 
+    // 以小表建哈希表、大表探测，只记录匹配的行号对，最后逐列拼出结果
+    std::vector<size_t> bigger_rows;
+    std::vector<size_t> smaller_rows;
+    hashJoinRows(smaller_keys, smaller_table->is_null, smaller_table->size(),
+                 bigger_keys, bigger_table->is_null, bigger_table->size(), bigger_rows, smaller_rows);
+
+    gatherJoinResult(result, *bigger_table, bigger_rows, *smaller_table, smaller_cols, smaller_rows);
+
     return result;
 }
 
@@ -1200,24 +1922,24 @@ std::pair<Table, Index> BucketJoin(const Table& table1, const Table& table2, con
                     }
                 }
                 if (!isKey) {
-                    value_ranges.push_back({1, MOD - 1});
+                    value_ranges.push_back({1, MAX_SHARE_VALUE});
                 }
             }
 
             // 处理padding
             if (padding_to != 0) {
                 if (padding_to == CARTESIAN_BOUND) {
-                    bucket_result.padding(bucket1.data.size() * bucket2.data.size(), value_ranges);
+                    bucket_result.padding(bucket1.size() * bucket2.size(), value_ranges);
                 } else if (padding_to == MF_BOUND || padding_to == AGM_BOUND || padding_to == MIX_AGM_MF_BOUND) {
                     auto current_agm_bound = Utils::computeAGMBound(bucket1.headers, bucket2.headers, 
-                                                                  bucket1.data.size(), bucket2.data.size());
-                    auto current_mf_bound = Utils::computeMFBound(MFs, {bucket1.data.size(), bucket2.data.size()});
+                                                                  bucket1.size(), bucket2.size());
+                    auto current_mf_bound = Utils::computeMFBound(MFs, {bucket1.size(), bucket2.size()});
 
                     if (padding_to == MF_BOUND) {
                         bucket_result.padding(current_mf_bound, value_ranges);
                     } else if (padding_to == AGM_BOUND) {
                         if (AGM_BOUND_ == CARTESIAN_BOUND) {
-                            bucket_result.padding(bucket1.data.size() * bucket2.data.size(), value_ranges);
+                            bucket_result.padding(bucket1.size() * bucket2.size(), value_ranges);
                         } else {
                             bucket_result.padding(std::min(AGM_BOUND_, current_agm_bound), value_ranges);
                             #pragma omp critical(log_section)
@@ -1259,19 +1981,19 @@ std::pair<Table, Index> BucketJoin(const Table& table1, const Table& table2, con
                         }
                     }
                     // 计算 mixed bound
-                    auto mixed_bound = Utils::mixedUpperBound(edges, bucket2.data.size(), bucket2.max_freqs[0], { leaves });
+                    auto mixed_bound = Utils::mixedUpperBound(edges, bucket2.size(), bucket2.max_freqs[0], { leaves });
                     bucket_result.padding(mixed_bound, value_ranges);
                     #pragma omp critical(log_section)
                     {
                         log("Use MIX_BOUND Padding Strategy: Mix Bound = " + std::to_string(mixed_bound));
                     }
                 } else {
-                    bucket_result.padding(std::max(padding_to, bucket_result.data.size()), value_ranges);
+                    bucket_result.padding(std::max(padding_to, bucket_result.size()), value_ranges);
                 }
             }
 
             // 存储结果 - 使用unique_ptr避免拷贝问题
-            if (!bucket_result.data.empty()) {
+            if (!bucket_result.empty()) {
                 bucket_results[i] = std::make_unique<Table>(std::move(bucket_result));
                 bucket_has_result[i] = true;
             }
@@ -1293,14 +2015,14 @@ std::pair<Table, Index> BucketJoin(const Table& table1, const Table& table2, con
     for (int i = 0; i < bucket_count; i++) {
         if (bucket_has_result[i] && bucket_results[i]) {
             result_starts.push_back(current_pos);
-            current_pos += bucket_results[i]->data.size();
+            current_pos += bucket_results[i]->size();
             result_ends.push_back(current_pos);
             
             auto interval = table1_idx.getSortedIntervals()[i];
-            interval.second = bucket_results[i]->data.size();
+            interval.second = bucket_results[i]->size();
             result_intervals.push_back(interval);
 
-            if (result.data.empty()) {
+            if (result.empty()) {
                 result = std::move(*bucket_results[i]);
             } else {
                 result.concate(*bucket_results[i]);
@@ -1343,19 +2065,19 @@ std::pair<Table, Index> BucketJoin(const Table& table1, const Table& table2, con
     //             }
     //         }
     //         if (!isKey) {
-    //             value_ranges.push_back({1, MOD - 1});
+    //             value_ranges.push_back({1, MAX_SHARE_VALUE});
     //         }
     //     }
 
     //     if (padding_to != 0) {
     //         if (padding_to == CARTESIAN_BOUND) {
     //             // 填充到笛卡尔积大小
-    //             bucket_result.padding(bucket1.data.size() * bucket2.data.size(), value_ranges);
+    //             bucket_result.padding(bucket1.size() * bucket2.size(), value_ranges);
     //         } else if (padding_to == MF_BOUND || padding_to == AGM_BOUND || padding_to == MIX_AGM_MF_BOUND) {
-    //             AGM_BOUND_ = Utils::computeStarAGMBound(bucket1.headers.size(), bucket2.data.size());
+    //             AGM_BOUND_ = Utils::computeStarAGMBound(bucket1.headers.size(), bucket2.size());
     //             auto current_agm_bound =
-    //                 Utils::computeAGMBound(bucket1.headers, bucket2.headers, bucket1.data.size(), bucket2.data.size());
-    //             auto current_mf_bound = Utils::computeMFBound(MFs, {bucket1.data.size(), bucket2.data.size()});
+    //                 Utils::computeAGMBound(bucket1.headers, bucket2.headers, bucket1.size(), bucket2.size());
+    //             auto current_mf_bound = Utils::computeMFBound(MFs, {bucket1.size(), bucket2.size()});
 
     //             if (padding_to == MF_BOUND) {
     //                 // 填充到MF Bound需要计算此次桶连接的预估上界
@@ -1363,7 +2085,7 @@ std::pair<Table, Index> BucketJoin(const Table& table1, const Table& table2, con
     //             } else if (padding_to == AGM_BOUND) {
     //                 // 确保AGM Bound已经计算，否则使用笛卡尔积上界
     //                 if (AGM_BOUND_ == CARTESIAN_BOUND) {
-    //                     bucket_result.padding(bucket1.data.size() * bucket2.data.size(), value_ranges);
+    //                     bucket_result.padding(bucket1.size() * bucket2.size(), value_ranges);
     //                 } else {
     //                     bucket_result.padding(std::min(AGM_BOUND_, current_agm_bound), value_ranges);
     //                     log("Use AGM_BOUND Padding Strategy: Global AGM Bound = " + std::to_string(AGM_BOUND_) +
@@ -1378,24 +2100,24 @@ std::pair<Table, Index> BucketJoin(const Table& table1, const Table& table2, con
     //             }
     //         } else {
     //             // 填充到指定大小
-    //             bucket_result.padding(std::max(padding_to, bucket_result.data.size()), value_ranges);
+    //             bucket_result.padding(std::max(padding_to, bucket_result.size()), value_ranges);
     //         }
     //     }
 
     //     // 如果桶内连接结果非空，更新结果索引
-    //     if (!bucket_result.data.empty()) {
+    //     if (!bucket_result.empty()) {
     //         // 更新起止位置
     //         result_starts.push_back(current_pos);
-    //         current_pos += bucket_result.data.size();
+    //         current_pos += bucket_result.size();
     //         result_ends.push_back(current_pos);
     //         // 更新区间对应频次计数
     //         auto interval = table1_idx.getSortedIntervals()[i];
-    //         interval.second = bucket_result.data.size();
+    //         interval.second = bucket_result.size();
     //         result_intervals.push_back(interval);
     //     }
 
     //     // 将桶内结果添加到最终结果表
-    //     if (result.data.empty()) {
+    //     if (result.empty()) {
     //         result = bucket_result;
     //     } else {
     //         result.concate(bucket_result);
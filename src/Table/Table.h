@@ -11,10 +11,13 @@
 #include <any>
 #include <numeric>
 #include <random>
+#include <memory>
+#include <functional>
 #include <glpk.h>
 #include "../Share/Share.h"
 #include "../Statistic/Statistic.h"
 #include "../Function/Function.h"
+#include "../Message/Buffer.h"
 
 class Share;
 class ShareTuple;
@@ -29,14 +32,140 @@ extern uint64_t MIX_BOUND_;
 static const uint64_t MIX_AGM_MF_BOUND = UINT64_MAX - 3;
 static const uint64_t MIX_BOUND = UINT64_MAX - 4;
 
+// 列式存储的一列，按分量连续存放（SoA）：
+// INT_MODE 只有1个分量，SHARE_PAIR_MODE 为 {x_i, x_{i+1}} 2个分量，SHARE_TUPLE_MODE 为 {x1, x2, x3} 3个分量
+// 各分量的缓冲区按引用计数共享，拷贝Column（以及Table）只复制指针；通过非const接口写入时，若缓冲区仍被其他列共享则先复制一份（写时复制）
+class Column {
+public:
+    Column() = default;
+    Column(u_int part_num, size_t rows = 0);
+
+    size_t size() const { return parts.empty() ? 0 : parts[0]->size(); }
+    bool empty() const { return size() == 0; }
+    u_int partNum() const { return parts.size(); }
+
+    // 可写访问第k个分量，返回的引用在本列被再次拷贝前有效
+    std::vector<int>& part(u_int k) { detach(k); return *parts[k]; }
+    const std::vector<int>& part(u_int k) const { return *parts[k]; }
+    // 只读访问，在非const的列上也不会触发复制
+    const std::vector<int>& cpart(u_int k) const { return *parts[k]; }
+
+    // 以data中的各分量替换本列的数据
+    void setParts(std::vector<std::vector<int>> data);
+    // 以other的第other_k个分量作为本列的第k个分量，两列共享该缓冲区
+    void sharePart(u_int k, const Column& other, u_int other_k);
+
+    void resize(size_t rows);
+    void reserve(size_t rows);
+    void clear();
+
+    // 按行读写，type为该列的共享类型
+    int getInt(size_t row) const { return (*parts[0])[row]; }
+    SharePair getSharePair(size_t row, u_int type) const;
+    ShareTuple getShareTuple(size_t row, u_int type) const;
+    void set(size_t row, int value) { part(0)[row] = value; }
+    void set(size_t row, const SharePair& sp);
+    void set(size_t row, const ShareTuple& st);
+    void push_back(int value) { part(0).push_back(value); }
+    void push_back(const SharePair& sp);
+    void push_back(const ShareTuple& st);
+
+    // 追加other中[start, end)范围的行
+    void append(const Column& other, size_t start, size_t end);
+    // 按行号数组取出对应的行，组成新的列
+    Column gather(const std::vector<size_t>& rows) const;
+
+private:
+    std::vector<std::shared_ptr<std::vector<int>>> parts;   // *parts[k][row] 为第row行的第k个分量
+
+    // 第k个分量被其他列共享时，复制一份独占的缓冲区
+    void detach(u_int k) {
+        if (parts[k].use_count() > 1) {
+            parts[k] = std::make_shared<std::vector<int>>(*parts[k]);
+        }
+    }
+};
+
+// 按位压缩存储的布尔列，用于is_null：每个分量每64行占一个uint64_t字，第row行位于第row / 64个字的第row % 64位
+// 只保存每个值（或分量）的最低位；布尔共享下各分量按位异或即得秘密值，异或、与、或、非都可以按字计算
+// 与Column一样，各分量的缓冲区按引用计数共享，写入时复制
+class BitColumn {
+public:
+    static const size_t WORD_BITS = 64;
+    static size_t wordCount(size_t rows) { return (rows + WORD_BITS - 1) / WORD_BITS; }
+
+    BitColumn() = default;
+    BitColumn(u_int part_num, size_t rows = 0, int value = 0);
+
+    size_t size() const { return rows; }
+    bool empty() const { return rows == 0; }
+    u_int partNum() const { return parts.size(); }
+
+    // 可写访问第k个分量的压缩字，超出size()的位应保持为0
+    std::vector<uint64_t>& words(u_int k) { detach(k); return *parts[k]; }
+    const std::vector<uint64_t>& cwords(u_int k) const { return *parts[k]; }
+    // 以other的第other_k个分量作为本列的第k个分量，两列共享该缓冲区
+    void sharePart(u_int k, const BitColumn& other, u_int other_k);
+    // 只含第k个分量的单分量列，与本列共享缓冲区
+    BitColumn component(u_int k) const;
+    // 清零第k个分量最后一个字中超出size()的位
+    void clearTail(u_int k);
+
+    void resize(size_t rows, int value = 0);
+    void clear();
+
+    // 按行读写，分量只取最低位
+    int get(u_int k, size_t row) const { return ((*parts[k])[row / WORD_BITS] >> (row % WORD_BITS)) & 1; }
+    void set(u_int k, size_t row, int value);
+    int getInt(size_t row) const { return get(0, row); }
+    SharePair getSharePair(size_t row, u_int type) const;
+    ShareTuple getShareTuple(size_t row, u_int type) const;
+    void set(size_t row, int value) { set(0, row, value); }
+    void set(size_t row, const SharePair& sp);
+    void set(size_t row, const ShareTuple& st);
+    void push_back(int value);
+    void push_back(const SharePair& sp);
+    void push_back(const ShareTuple& st);
+
+    // 追加other中[start, end)范围的行
+    void append(const BitColumn& other, size_t start, size_t end);
+    // 以other覆盖本列从start开始的other.size()行
+    void assign(size_t start, const BitColumn& other);
+    // 按行号数组取出对应的行，组成新的列
+    BitColumn gather(const std::vector<size_t>& rows) const;
+
+    // 与int列之间的转换，转为BitColumn时只保留各值的最低位
+    static BitColumn fromColumn(const Column& column);
+    Column toColumn() const;
+
+    // 按分量逐字计算，两列的分量个数和行数需相同
+    BitColumn& operator^=(const BitColumn& other);
+    BitColumn& operator&=(const BitColumn& other);
+    BitColumn& operator|=(const BitColumn& other);
+    // 翻转第k个分量的所有位；布尔共享下只翻转x_0即为求非
+    void flip(u_int k);
+
+private:
+    std::vector<std::shared_ptr<std::vector<uint64_t>>> parts;  // *parts[k]为第k个分量的压缩字
+    size_t rows = 0;
+
+    void detach(u_int k) {
+        if (parts[k].use_count() > 1) {
+            parts[k] = std::make_shared<std::vector<uint64_t>>(*parts[k]);
+        }
+    }
+    template <typename Op>
+    BitColumn& combine(const BitColumn& other, Op op);
+};
+
 class Table {
 public:
     std::vector<std::string> headers;
     std::vector<u_int> share_types;
     u_int mode;  // int, SharePair or ShareTuple
-    std::vector<std::vector<std::any>> data;
+    std::vector<Column> columns;                    // 按列存储的数据，columns[j]与headers[j]对应
     std::vector<uint64_t> max_freqs;                // 为每一列设置属性值的最大频率 
-    std::vector<std::any> is_null;                  // 是否为NULL的标识符数组，非INT_MODE情况下，共享类型固定位布尔类型
+    BitColumn is_null;                              // 是否为NULL的标识符列，按位压缩存储，非INT_MODE情况下，共享类型固定为布尔类型
 
     static const TableMode INT_MODE = 0;
     static const TableMode SHARE_TUPLE_MODE = 1;
@@ -46,17 +175,38 @@ public:
 
     // 构造函数
     // 需要确定表的mode
-    Table(TableMode mode) : mode(mode) {};
+    Table(TableMode mode) : mode(mode) { is_null = BitColumn(partNum()); };
     // 拷贝构造
     Table(const Table&) = default;
+    Table(Table&&) = default;
+    Table& operator=(const Table&) = default;
+    Table& operator=(Table&&) = default;
 
     // 辅助函数，按空格分割字符串
     std::vector<std::string> split(const std::string& str);
-    // 辅助函数，验证某条记录的列数是否与表头匹配
-    void validateData(const std::vector<std::any>& row);
-    // 辅助函数，特定share类型的对象与string之间的相互转换
-    std::any convertStringToData(const std::string& str, u_int share_type);
-    std::string convertDataToString(const std::any& value) const;
+    // 辅助函数，每个值包含的分量个数，由表的mode决定
+    u_int partNum() const;
+    // 辅助函数，按headers重建空的列（含is_null），rows为初始行数
+    void initColumns(size_t rows = 0);
+    // 辅助函数，解析字符串表示的值并追加到指定列
+    void appendValueFromString(Column& column, const std::string& str);
+    void appendValueFromString(BitColumn& column, const std::string& str);
+    std::string valueToString(const Column& column, size_t row) const;
+    std::string valueToString(const BitColumn& column, size_t row) const;
+
+    // 行数
+    size_t size() const { return !columns.empty() ? columns[0].size() : is_null.size(); }
+    bool empty() const { return size() == 0; }
+    // 按行列读取单个值
+    int getInt(size_t row, size_t col) const { return columns[col].getInt(row); }
+    SharePair getSharePair(size_t row, size_t col) const { return columns[col].getSharePair(row, share_types[col]); }
+    ShareTuple getShareTuple(size_t row, size_t col) const { return columns[col].getShareTuple(row, share_types[col]); }
+    // 读取一整行
+    std::vector<int> getIntRow(size_t row) const;
+    std::vector<SharePair> getSharePairRow(size_t row) const;
+    // is_null 的读写
+    int getIsNullInt(size_t row) const { return is_null.getInt(row); }
+    SharePair getIsNullSharePair(size_t row) const { return is_null.getSharePair(row, BINARY_SHARING); }
 
     // 读取文件中的表
     void readFromFile(const std::string& filename);
@@ -64,26 +214,36 @@ public:
     void readFromString(const std::string& str);
     // 将表转为字符串
     std::string toString() const;
+    // 二进制列式编码：定长表头（列名、共享类型、max_freqs）后接各列的数据块
+    // 数据列的每个分量为原始小端int32数组；布尔共享列中取值全为0/1的分量按位压缩，is_null总是按位压缩
+    std::string toBinary() const;
+    // 与toBinary的编码相同，但每积累约block_bytes字节就交给sink，不在内存中拼出完整的编码
+    void writeBinary(size_t block_bytes, const std::function<void(std::string_view)>& sink) const;
+    void readFromBinary(std::string_view bin);
     // 插入新的一列，自动填充0值
     void addColumn(const std::string& column_name, u_int share_type);
     // 插入新的一列，且提供该列数据
-    void addColumn(const std::string& column_name, u_int share_type, const std::vector<std::any>& column_data);
-    // 取出指定单列，放在一个数组中输出
-    std::vector<std::any> getColumn(const std::string& col_name);
+    void addColumn(const std::string& column_name, u_int share_type, const Column& column_data);
+    // 取出指定单列
+    const Column& getColumn(const std::string& col_name) const;
     // 获取制定单列列号
     int getColumnIdx(const std::string& col_name) const;
-    // 取出指定多列（是不是也该换成用Table输出结果？）
-    std::vector<std::vector<std::any>> select(std::vector<std::string> col_names) const;
+    // 取出指定多列，结果仍为一个表（保留is_null）
+    Table select(std::vector<std::string> col_names) const;
     // 以Int类型取出多列
     std::vector<std::vector<int>> selectAsInt(std::vector<std::string> col_names) const;
     // 提取表中特定行范围
     Table slice(int start, int end) const;
     // 拼接表
     void concate(const Table& table);
+    // 按行号数组取出对应的行，组成新的表
+    Table gather(const std::vector<size_t>& rows) const;
     // 根据属性数组排序，数组表示排序时属性的优先级，只能对INT_MODE进行排序
     void sortBy(std::vector<std::string> attrs);
     // 设置表头
     void setHeaders(const std::vector<std::string>& new_headers);
+    // 返回仅表头不同的重命名视图，与本表共享各列的缓冲区，不复制数据
+    Table renamed(const std::vector<std::string>& new_headers) const;
     // 获取指定列的最大最小值
     Range getColumnValueRange(int col_idx) const;
     // 获取所有列的最大最小值
@@ -3,6 +3,7 @@
 #include <thread>
 #include <unistd.h>
 #include <limits.h>    // PATH_MAX
+#include <omp.h>
 
 #include "../Node/Server.h"
 #include "../Node/ThirdParty.h"
@@ -11,8 +12,176 @@
 
 static const std::string PROJECT_PATH = PROJECT_SOURCE_DIR;
 
+// 端到端测试中每个节点变量存储的内存预算（字节），超出后冷变量溢出到磁盘，0表示不限制
+static const uint64_t NODE_MEMORY_BUDGET = 0;
+
 // uint64_t AGM_BOUND_ = CARTESIAN_BOUND;
 
+// 比较两张INT_MODE表的表头、各列数据和isNull，不一致时抛出异常
+static void expectSameTable(const Table& expected, const Table& actual, const std::string& what) {
+    if (expected.headers != actual.headers || expected.size() != actual.size() || expected.columns.size() != actual.columns.size()) {
+        throw std::runtime_error("Test Error in " + what + ": Table shapes differ");
+    }
+    for (size_t j = 0; j < expected.columns.size(); j++) {
+        if (expected.columns[j].cpart(0) != actual.columns[j].cpart(0)) {
+            throw std::runtime_error("Test Error in " + what + ": Column " + expected.headers[j] + " differs");
+        }
+    }
+    for (size_t r = 0; r < expected.size(); r++) {
+        int expected_null = expected.is_null.size() == expected.size() ? expected.is_null.getInt(r) : 0;
+        int actual_null = actual.is_null.size() == actual.size() ? actual.is_null.getInt(r) : 0;
+        if (expected_null != actual_null) {
+            throw std::runtime_error("Test Error in " + what + ": isNull differs at row " + std::to_string(r));
+        }
+    }
+}
+
+// 比较两张任意mode的表的表头、共享类型、max_freqs、各列的所有分量和isNull的所有分量，不一致时抛出异常
+static void expectSameParts(const Table& expected, const Table& actual, const std::string& what) {
+    if (expected.mode != actual.mode || expected.headers != actual.headers || expected.share_types != actual.share_types ||
+        expected.max_freqs != actual.max_freqs || expected.size() != actual.size() || expected.columns.size() != actual.columns.size()) {
+        throw std::runtime_error("Test Error in " + what + ": Table metadata differs");
+    }
+    for (size_t j = 0; j < expected.columns.size(); j++) {
+        for (u_int k = 0; k < expected.partNum(); k++) {
+            if (expected.columns[j].cpart(k) != actual.columns[j].cpart(k)) {
+                throw std::runtime_error("Test Error in " + what + ": Part " + std::to_string(k) + " of column " + expected.headers[j] + " differs");
+            }
+        }
+    }
+    if (expected.is_null.size() != actual.is_null.size() || expected.is_null.partNum() != actual.is_null.partNum()) {
+        throw std::runtime_error("Test Error in " + what + ": isNull shapes differ");
+    }
+    for (u_int k = 0; k < expected.is_null.partNum(); k++) {
+        if (expected.is_null.cwords(k) != actual.is_null.cwords(k)) {
+            throw std::runtime_error("Test Error in " + what + ": Part " + std::to_string(k) + " of isNull differs");
+        }
+    }
+}
+
+// 按share_types生成一张随机表，各分量取自gen；INT_MODE下取值覆盖整个int范围，其余mode下为环上的份额，布尔共享列的分量只取0/1
+static Table randomTable(TableMode mode, const std::vector<u_int>& share_types, size_t rows, std::mt19937& gen) {
+    Table table(mode);
+    for (size_t j = 0; j < share_types.size(); j++) {
+        table.headers.push_back("col " + std::to_string(j));
+        table.max_freqs.push_back(gen());
+    }
+    table.share_types = share_types;
+    table.initColumns(rows);
+    std::uniform_int_distribution<int> dist(mode == Table::INT_MODE ? INT_MIN : 0, mode == Table::INT_MODE ? INT_MAX : MAX_SHARE_VALUE);
+    for (size_t j = 0; j < table.columns.size(); j++) {
+        for (u_int k = 0; k < table.partNum(); k++) {
+            for (auto& v : table.columns[j].part(k)) {
+                v = share_types[j] == BINARY_SHARING ? gen() & 1 : dist(gen);
+            }
+        }
+    }
+    for (u_int k = 0; k < table.is_null.partNum(); k++) {
+        for (size_t r = 0; r < rows; r++) {
+            table.is_null.set(k, r, gen() & 1);
+        }
+    }
+    return table;
+}
+
+// 编码后再解码，结果应与原表完全一致，且再次编码得到相同的字节
+static void expectBinaryRoundTrip(const Table& table, const std::string& what) {
+    std::string bin = table.toBinary();
+    Table decoded(table.mode);
+    decoded.readFromBinary(bin);
+    expectSameParts(table, decoded, what);
+    if (decoded.toBinary() != bin) {
+        throw std::runtime_error("Test Error in " + what + ": Re-encoding gives different bytes");
+    }
+}
+
+// 生成一张INT_MODE表用于连接测试：前key_num列为连接键k0, k1, ...，再加一列名为payload的非键列
+// 键取值在[-range, range)内，行数远大于键的取值组合数时会产生大量重复键；每隔null_every行置一行isNull
+static Table randomJoinTable(size_t key_num, const std::string& payload, size_t rows, int range, size_t null_every, std::mt19937& gen) {
+    Table table(Table::INT_MODE);
+    for (size_t c = 0; c < key_num; c++) {
+        table.headers.push_back("k" + std::to_string(c));
+    }
+    table.headers.push_back(payload);
+    table.share_types.assign(table.headers.size(), NO_SHARING);
+    table.max_freqs.assign(table.headers.size(), 1);
+    table.initColumns(rows);
+    std::uniform_int_distribution<int> dist(-range, range - 1);
+    for (size_t r = 0; r < rows; r++) {
+        for (size_t c = 0; c < key_num; c++) {
+            table.columns[c].part(0)[r] = dist(gen);
+        }
+        table.columns[key_num].part(0)[r] = r;
+        if (null_every != 0 && r % null_every == null_every - 1) {
+            table.is_null.set(0, r, 1);
+        }
+    }
+    return table;
+}
+
+// 以字符串拼接连接键的哈希连接，作为Join_Hash的对照，结果的表头、行序与Join_Hash的约定一致：
+// 小表建表、大表探测，按大表的行序输出，同一大表行的匹配按小表的行序排列，isNull的行不参与连接
+static Table stringKeyedJoin(const Table& table1, const Table& table2) {
+    const Table& smaller = table1.size() <= table2.size() ? table1 : table2;
+    const Table& bigger = table1.size() <= table2.size() ? table2 : table1;
+    // 连接键按table1中的列序
+    std::vector<std::string> common;
+    for (const auto& h : table1.headers) {
+        if (std::find(table2.headers.begin(), table2.headers.end(), h) != table2.headers.end()) {
+            common.push_back(h);
+        }
+    }
+    auto rowKey = [&](const Table& table, size_t row) {
+        std::string key;
+        for (const auto& h : common) {
+            key += std::to_string(table.columns[table.getColumnIdx(h)].cpart(0)[row]) + " ";
+        }
+        return key;
+    };
+
+    Table result(Table::INT_MODE);
+    result.headers = bigger.headers;
+    std::vector<size_t> smaller_cols;
+    for (size_t j = 0; j < smaller.headers.size(); j++) {
+        if (std::find(common.begin(), common.end(), smaller.headers[j]) == common.end()) {
+            result.headers.push_back(smaller.headers[j]);
+            smaller_cols.push_back(j);
+        }
+    }
+    result.share_types.assign(result.headers.size(), NO_SHARING);
+
+    std::unordered_map<std::string, std::vector<size_t>> hash_table;
+    for (size_t i = 0; i < smaller.size(); i++) {
+        if (smaller.is_null.getInt(i) == 0) {
+            hash_table[rowKey(smaller, i)].push_back(i);
+        }
+    }
+    std::vector<std::vector<int>> data(result.headers.size());
+    for (size_t i = 0; i < bigger.size(); i++) {
+        if (bigger.is_null.getInt(i) != 0) {
+            continue;
+        }
+        auto it = hash_table.find(rowKey(bigger, i));
+        if (it == hash_table.end()) {
+            continue;
+        }
+        for (size_t j : it->second) {
+            for (size_t c = 0; c < bigger.headers.size(); c++) {
+                data[c].push_back(bigger.columns[c].cpart(0)[i]);
+            }
+            for (size_t c = 0; c < smaller_cols.size(); c++) {
+                data[bigger.headers.size() + c].push_back(smaller.columns[smaller_cols[c]].cpart(0)[j]);
+            }
+        }
+    }
+    size_t rows = data[0].size();
+    result.initColumns(rows);
+    for (size_t c = 0; c < data.size(); c++) {
+        result.columns[c].part(0) = std::move(data[c]);
+    }
+    return result;
+}
+
 void basic_test() {
     // 创建节点对象
     Server s0(0, "SERVER 0");
@@ -267,13 +436,13 @@ void join_plan_test() {
     std::set<std::string> V;
     std::vector<std::set<std::string>> E;
     std::vector<uint64_t> N;
-    for (const auto& row : query_graph.data) {
-        auto u = std::to_string(std::any_cast<int>(row[0]));
-        auto v = std::to_string(std::any_cast<int>(row[1]));
+    for (size_t i = 0; i < query_graph.size(); i++) {
+        auto u = std::to_string(query_graph.getInt(i, 0));
+        auto v = std::to_string(query_graph.getInt(i, 1));
         V.insert(u);
         V.insert(v);
         E.push_back(std::set<std::string>({u, v}));
-        N.push_back(data_graph.data.size());
+        N.push_back(data_graph.size());
     }
     AGM_BOUND_ = Utils::computeAGMBound(V, E, N);
     std::cout << "Finish compute AGM Bound: " << AGM_BOUND_ << std::endl;
@@ -328,14 +497,7 @@ void table_index_test() {
     std::vector<std::string> attrs = {"ID", "Class"};
     std::vector<Range> ranges = {{1, 50}, {0, 7}};
 
-    auto rawRecords = table.select(attrs);
-    std::vector<std::vector<int>> records;
-    for (auto& item : rawRecords) {
-        std::vector<int> record;
-        record.push_back(std::any_cast<int>(item[0]));
-        record.push_back(std::any_cast<int>(item[1]));
-        records.push_back(record);
-    }
+    std::vector<std::vector<int>> records = table.selectAsInt(attrs);
 
     Histogram h(attrs, records, ranges);
     std::cout << h.toString() << std::endl;
@@ -609,6 +771,131 @@ void checkMatch_protocol_test() {
     tt.join();
 }
 
+void checkMatchMPC_protocol_test() {
+    // 创建节点对象
+    Server s0(0, "SERVER 0");
+    Server s1(1, "SERVER 1");
+    Server s2(2, "SERVER 2");
+    Node o(3, "OWNER");
+    ThirdParty t(4, "THIRDPARTY", {&s0, &s1, &s2});
+    
+    //为节点对象创建线程，开始监听
+    std::thread t0(&Node::startlistening, &s0);
+    std::thread t1(&Node::startlistening, &s1);
+    std::thread t2(&Node::startlistening, &s2);
+    std::thread to(&Node::startlistening, &o);
+    std::thread tt(&Node::startlistening, &t);
+    std::cout << "all servers are listening" << std::endl;
+    sleep(1);
+
+    // 连接各节点
+    Node::connectToPeers({&s0, &s1, &s2, &o, &t});
+    std::cout << "all servers have connected to peers" << std::endl;
+
+    Protocol protocol({&s0, &s1, &s2}, &t);
+
+    // 读取表
+    Table match_result(Table::INT_MODE);
+    try {
+        match_result.readFromFile(PROJECT_PATH + "/data/match_result_124.csv");
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+    }
+
+    // 生成表的附带信息
+    // 定义查询图中对称节点组，索引从0开始
+    std::vector<std::vector<int>> symmetries = {{2,4}, {1,3}};
+
+    // Owner把数据图共享给Servers
+    o.setVar("M", match_result);
+    o.shareTable("M", {BINARY_SHARING, BINARY_SHARING, BINARY_SHARING}, {&s0, &s1, &s2});
+
+    // 不经过第三方，由Servers用布尔电路完成验证
+    protocol.checkMatchMPC("[M]", symmetries);
+
+    t.revealTable("[M]");
+    t.printVars();
+
+    // 主动关闭所有节点，先关闭依赖其他节点的对象
+    o.stop();
+    t.stop();
+    s0.stop();
+    s1.stop();
+    s2.stop();
+
+    // Clean up threads
+    t0.join();
+    t1.join();
+    t2.join();
+    to.join();
+    tt.join();
+}
+
+void checkMatchMPC_graph_test() {
+    // 创建节点对象
+    Server s0(0, "SERVER 0");
+    Server s1(1, "SERVER 1");
+    Server s2(2, "SERVER 2");
+    Node o(3, "OWNER");
+    ThirdParty t(4, "THIRDPARTY", {&s0, &s1, &s2});
+    
+    //为节点对象创建线程，开始监听
+    std::thread t0(&Node::startlistening, &s0);
+    std::thread t1(&Node::startlistening, &s1);
+    std::thread t2(&Node::startlistening, &s2);
+    std::thread to(&Node::startlistening, &o);
+    std::thread tt(&Node::startlistening, &t);
+    std::cout << "all servers are listening" << std::endl;
+    sleep(1);
+
+    // 连接各节点
+    Node::connectToPeers({&s0, &s1, &s2, &o, &t});
+    std::cout << "all servers have connected to peers" << std::endl;
+
+    Protocol protocol({&s0, &s1, &s2}, &t);
+
+    // 读取表，以table1_data代替数据图，共享为Servers上的[G]
+    Table graph(Table::INT_MODE);
+    Table match_result(Table::INT_MODE);
+    graph.readFromFile(PROJECT_PATH + "/data/table1_data.csv");
+    match_result.readFromFile(PROJECT_PATH + "/data/match_result_124.csv");
+    o.setVar("G", graph);
+    o.shareTable("G", BINARY_SHARING, {&s0, &s1, &s2});
+    o.setVar("M", match_result);
+    o.shareTable("M", BINARY_SHARING, {&s0, &s1, &s2});
+
+    // 有对称节点组时会用到大于比较电路的中间变量，验证后数据图[G]应保持不变
+    std::vector<std::vector<int>> symmetries = {{2,4}, {1,3}};
+    protocol.checkMatchMPC("[M]", symmetries);
+
+    // [G]被删除时重构会一直等待，先检查各方都还持有，关闭节点后再报告结果
+    bool graph_kept = s0.hasVar("[G]") && s1.hasVar("[G]") && s2.hasVar("[G]");
+    Table revealed(Table::INT_MODE);
+    if (graph_kept) {
+        t.revealTable("[G]");
+        revealed = t.getVar<Table>("G");
+    }
+
+    // 主动关闭所有节点，先关闭依赖其他节点的对象
+    o.stop();
+    t.stop();
+    s0.stop();
+    s1.stop();
+    s2.stop();
+
+    // Clean up threads
+    t0.join();
+    t1.join();
+    t2.join();
+    to.join();
+    tt.join();
+
+    if (!graph_kept) {
+        throw std::runtime_error("Test Error in checkMatchMPC_graph_test(): [G] was removed from the servers");
+    }
+    expectSameTable(graph, revealed, "checkMatchMPC_graph_test()");
+}
+
 void star_decomposition_test() {
     // 示例输入
     // std::vector<std::vector<int>> edges = {
@@ -693,6 +980,427 @@ void hash_join_test() {
 
 }
 
+void table_binary_test() {
+    std::mt19937 gen(20240601);
+    const std::vector<u_int> int_types = {NO_SHARING, NO_SHARING, NO_SHARING};
+    const std::vector<u_int> share_types = {ARITHMETIC_SHARING, ARITHMETIC_SHARING};
+
+    // 各mode、不同行数（含0行）
+    for (size_t rows : {size_t(0), size_t(1), size_t(63), size_t(64), size_t(65), size_t(1000)}) {
+        std::string suffix = " with " + std::to_string(rows) + " rows";
+        expectBinaryRoundTrip(randomTable(Table::INT_MODE, int_types, rows, gen), "table_binary_test() INT_MODE" + suffix);
+        expectBinaryRoundTrip(randomTable(Table::SHARE_PAIR_MODE, share_types, rows, gen), "table_binary_test() SHARE_PAIR_MODE" + suffix);
+        expectBinaryRoundTrip(randomTable(Table::SHARE_TUPLE_MODE, share_types, rows, gen), "table_binary_test() SHARE_TUPLE_MODE" + suffix);
+    }
+
+    // 布尔共享列中取值全为0/1的分量按位压缩，跨越编码时的分段边界（1 << 16行）；其中一列混入一个非0/1的值，该分量退回int数组
+    const std::vector<u_int> mixed_types = {BINARY_SHARING, ARITHMETIC_SHARING, BINARY_SHARING};
+    for (size_t rows : {size_t(1), size_t(127), size_t((1 << 16) + 77)}) {
+        std::string suffix = " with " + std::to_string(rows) + " rows";
+        Table packed = randomTable(Table::SHARE_PAIR_MODE, mixed_types, rows, gen);
+        expectBinaryRoundTrip(packed, "table_binary_test() packed SHARE_PAIR_MODE" + suffix);
+        packed.columns[2].part(1)[rows / 2] = MAX_SHARE_VALUE;
+        expectBinaryRoundTrip(packed, "table_binary_test() partly packed SHARE_PAIR_MODE" + suffix);
+        expectBinaryRoundTrip(randomTable(Table::SHARE_TUPLE_MODE, mixed_types, rows, gen), "table_binary_test() packed SHARE_TUPLE_MODE" + suffix);
+    }
+    // 压缩后每行每个布尔分量只占1位：1列数据和isNull各2个分量，每个分量100个字，另加不到128字节的表头
+    Table flags = randomTable(Table::SHARE_PAIR_MODE, {BINARY_SHARING}, 64 * 100, gen);
+    if (flags.toBinary().size() > 2 * 2 * 100 * sizeof(uint64_t) + 128) {
+        throw std::runtime_error("Test Error in table_binary_test(): Boolean parts were not bit-packed");
+    }
+
+    // 没有列、没有isNull、列名中含空格和非ASCII字符
+    Table no_columns(Table::SHARE_PAIR_MODE);
+    no_columns.is_null = BitColumn(2, 10, 1);
+    expectBinaryRoundTrip(no_columns, "table_binary_test() without columns");
+    Table no_is_null = randomTable(Table::INT_MODE, int_types, 100, gen);
+    no_is_null.is_null.clear();
+    no_is_null.headers[0] = "a b\tc 列名";
+    expectBinaryRoundTrip(no_is_null, "table_binary_test() without isNull");
+
+    // mode不符或数据被截断时应抛出异常，而不是读出错误的表
+    std::string bin = randomTable(Table::SHARE_PAIR_MODE, share_types, 100, gen).toBinary();
+    bool mode_rejected = false;
+    try {
+        Table wrong_mode(Table::SHARE_TUPLE_MODE);
+        wrong_mode.readFromBinary(bin);
+    } catch (const std::exception&) {
+        mode_rejected = true;
+    }
+    bool truncation_rejected = false;
+    try {
+        Table truncated(Table::SHARE_PAIR_MODE);
+        truncated.readFromBinary(std::string_view(bin).substr(0, bin.size() - 1));
+    } catch (const std::exception&) {
+        truncation_rejected = true;
+    }
+    if (!mode_rejected || !truncation_rejected) {
+        throw std::runtime_error("Test Error in table_binary_test(): Malformed binary table was accepted");
+    }
+}
+
+void bit_column_test() {
+    std::mt19937 gen(20240602);
+    // 与BitColumn逐行对照的int向量，每个分量一个
+    auto randomBits = [&](u_int parts, size_t rows) {
+        std::vector<std::vector<int>> bits(parts, std::vector<int>(rows));
+        for (auto& part : bits) {
+            for (auto& b : part) {
+                b = gen() & 1;
+            }
+        }
+        return bits;
+    };
+    auto toBitColumn = [](const std::vector<std::vector<int>>& bits) {
+        Column column(bits.size(), bits[0].size());
+        column.setParts(bits);
+        return BitColumn::fromColumn(column);
+    };
+    auto expectBits = [](const BitColumn& column, const std::vector<std::vector<int>>& bits, const std::string& what) {
+        if (column.partNum() != bits.size() || column.size() != bits[0].size()) {
+            throw std::runtime_error("Test Error in bit_column_test(): Shape differs after " + what);
+        }
+        Column back = column.toColumn();
+        for (u_int k = 0; k < bits.size(); k++) {
+            if (back.cpart(k) != bits[k]) {
+                throw std::runtime_error("Test Error in bit_column_test(): Part " + std::to_string(k) + " differs after " + what);
+            }
+            // 最后一个字中超出size()的位必须为0，按字的运算和编码都依赖于此
+            size_t tail = column.size() % BitColumn::WORD_BITS;
+            if (tail != 0 && (column.cwords(k).back() >> tail) != 0) {
+                throw std::runtime_error("Test Error in bit_column_test(): Tail bits set after " + what);
+            }
+        }
+    };
+
+    // fromColumn只保留最低位
+    Column wide(2, 3);
+    wide.setParts({{2, 3, -1}, {5, 4, INT_MIN}});
+    expectBits(BitColumn::fromColumn(wide), {{0, 1, 1}, {1, 0, 0}}, "fromColumn of values wider than one bit");
+
+    const size_t sizes[] = {1, 63, 64, 65, 130, 200};
+    for (u_int parts = 1; parts <= 3; parts++) {
+        for (size_t n : sizes) {
+            auto bits = randomBits(parts, n);
+            expectBits(toBitColumn(bits), bits, "fromColumn of " + std::to_string(n) + " rows");
+
+            // 在不对齐的位置追加另一列的不对齐片段
+            for (size_t m : sizes) {
+                auto other_bits = randomBits(parts, m);
+                BitColumn other = toBitColumn(other_bits);
+                for (size_t start : {size_t(0), size_t(1), m / 2, m - 1}) {
+                    for (size_t end : {start, start + 1, (start + m + 1) / 2, m}) {
+                        if (end < start || end > m) {
+                            continue;
+                        }
+                        BitColumn column = toBitColumn(bits);
+                        column.append(other, start, end);
+                        auto expected = bits;
+                        for (u_int k = 0; k < parts; k++) {
+                            expected[k].insert(expected[k].end(), other_bits[k].begin() + start, other_bits[k].begin() + end);
+                        }
+                        expectBits(column, expected, "append [" + std::to_string(start) + ", " + std::to_string(end) + ") of " +
+                                   std::to_string(m) + " rows to " + std::to_string(n) + " rows");
+                    }
+                }
+
+                // 在不对齐的位置覆盖
+                if (m > n) {
+                    continue;
+                }
+                for (size_t start : {size_t(0), size_t(1), (n - m) / 2, n - m}) {
+                    if (start > n - m) {
+                        continue;
+                    }
+                    BitColumn column = toBitColumn(bits);
+                    BitColumn copy = column;
+                    column.assign(start, other);
+                    auto expected = bits;
+                    for (u_int k = 0; k < parts; k++) {
+                        std::copy(other_bits[k].begin(), other_bits[k].end(), expected[k].begin() + start);
+                    }
+                    expectBits(column, expected, "assign " + std::to_string(m) + " rows at " + std::to_string(start) + " of " + std::to_string(n) + " rows");
+                    // 写时复制，拷贝出的列不受影响
+                    expectBits(copy, bits, "assign to a copy");
+                }
+            }
+        }
+    }
+}
+
+void share_ring_test() {
+    const int top = static_cast<int>(RING_MASK);    // 环上的最大元素2^SHARE_RING_BITS - 1
+    auto inRing = [](int v) { return (static_cast<ring_t>(v) & ~RING_MASK) == 0; };
+
+    // 单个值的加减在2^SHARE_RING_BITS处回绕
+    if (ringAdd(top, 1) != 0 || ringAdd(top, top) != ringSub(top, 1) || ringSub(0, 1) != top || ringSub(0, top) != 1 ||
+        ringAdd(ringSub(5, 9), 9) != 5) {
+        throw std::runtime_error("Test Error in share_ring_test(): ringAdd/ringSub do not wrap around at 2^" + std::to_string(SHARE_RING_BITS));
+    }
+    for (int i = 0; i < 1000; i++) {
+        int a = ringRandom();
+        int b = ringRandom();
+        if (!inRing(a) || !inRing(ringAdd(a, b)) || !inRing(ringSub(a, b)) || ringSub(ringAdd(a, b), b) != a) {
+            throw std::runtime_error("Test Error in share_ring_test(): Ring arithmetic leaves the ring");
+        }
+    }
+
+    // 按列拆分和重构，取值包含环的两端；行数不是向量宽度的整数倍
+    for (size_t n : {size_t(1), size_t(7), size_t(17), size_t(1000)}) {
+        std::vector<int> values(n);
+        ringRandomFill(values.data(), n);
+        values[0] = top;
+        if (n > 1) {
+            values[1] = 0;
+        }
+        if (n > 2) {
+            values[2] = top - 1;
+        }
+        for (u_int type : {ARITHMETIC_SHARING, BINARY_SHARING}) {
+            std::string what = std::string(type == ARITHMETIC_SHARING ? "ARITHMETIC" : "BINARY") + " column of " + std::to_string(n) + " rows";
+            std::vector<int> x1, x2, x3, out;
+            splitColumn(values, type, x1, x2, x3);
+            for (size_t r = 0; r < n; r++) {
+                if (!inRing(x1[r]) || !inRing(x2[r]) || !inRing(x3[r])) {
+                    throw std::runtime_error("Test Error in share_ring_test(): Shares leave the ring in " + what);
+                }
+            }
+            reconstructColumn(x1, x2, x3, type, out);
+            if (out != values) {
+                throw std::runtime_error("Test Error in share_ring_test(): splitColumn/reconstructColumn round trip fails in " + what);
+            }
+            // 逐个分量累加，与一次重构的结果相同，不论分量到达的先后
+            std::vector<int> acc = x3;
+            accumulateColumn(acc, x1, type);
+            accumulateColumn(acc, x2, type);
+            if (acc != values) {
+                throw std::runtime_error("Test Error in share_ring_test(): accumulateColumn round trip fails in " + what);
+            }
+        }
+
+        // 构造和超过2^SHARE_RING_BITS的分量，重构时应回绕
+        std::vector<int> x1(n, top), x2(n, top), x3(n), out;
+        for (size_t r = 0; r < n; r++) {
+            x3[r] = ringAdd(values[r], 2);      // top + top + (v + 2) = v (mod 2^SHARE_RING_BITS)
+        }
+        reconstructColumn(x1, x2, x3, ARITHMETIC_SHARING, out);
+        if (out != values) {
+            throw std::runtime_error("Test Error in share_ring_test(): reconstructColumn does not wrap around for " + std::to_string(n) + " rows");
+        }
+    }
+}
+
+void share_reveal_test() {
+    // 创建节点对象
+    Server s0(0, "SERVER 0");
+    Server s1(1, "SERVER 1");
+    Server s2(2, "SERVER 2");
+    Node o(3, "OWNER");
+    ThirdParty t(4, "THIRDPARTY", {&s0, &s1, &s2});
+
+    //为节点对象创建线程，开始监听
+    std::thread t0(&Node::startlistening, &s0);
+    std::thread t1(&Node::startlistening, &s1);
+    std::thread t2(&Node::startlistening, &s2);
+    std::thread to(&Node::startlistening, &o);
+    std::thread tt(&Node::startlistening, &t);
+    std::cout << "all servers are listening" << std::endl;
+    sleep(1);
+
+    // 连接各节点
+    Node::connectToPeers({&s0, &s1, &s2, &o, &t});
+    std::cout << "all servers have connected to peers" << std::endl;
+
+    Protocol protocol({&s0, &s1, &s2}, &t);
+    std::mt19937 gen(20240603);
+    const std::vector<Node*> servers = {&s0, &s1, &s2};
+    const std::vector<std::pair<u_int, std::string>> types = {{BINARY_SHARING, "BINARY"}, {ARITHMETIC_SHARING, "ARITHMETIC"}};
+
+    // 节点线程运行期间抛出异常会直接终止进程，先记下失败原因，关闭节点后再报告
+    std::string failure;
+    try {
+        // Owner以种子分发的份额共享整数，由S_1重构：S_1持有[x]，只需S_0补上x_0
+        std::uniform_int_distribution<int> dist(0, MAX_SHARE_VALUE);
+        for (const auto& [type, type_name] : types) {
+            for (int secret : {0, 1, MAX_SHARE_VALUE, dist(gen), dist(gen)}) {
+                std::string name = "x" + std::to_string(gen());
+                o.shareInt(name, secret, type, servers);
+                protocol.revealInt("[" + name + "]", &s1);
+                if (s1.getVar<int>(name) != secret) {
+                    throw std::runtime_error("Test Error in share_reveal_test(): " + type_name + " int " + std::to_string(secret) +
+                                             " revealed as " + std::to_string(s1.getVar<int>(name)));
+                }
+            }
+        }
+
+        // 共享表：全为布尔共享、全为算术共享和混合的共享类型，其中一列只有0/1，布尔共享时按位压缩传输
+        Table table = randomTable(Table::INT_MODE, {NO_SHARING, NO_SHARING, NO_SHARING}, 1000, gen);
+        for (size_t j = 0; j < table.columns.size(); j++) {
+            for (auto& v : table.columns[j].part(0)) {
+                v = j == 2 ? v & 1 : v & MAX_SHARE_VALUE;
+            }
+        }
+        std::vector<std::pair<std::vector<u_int>, std::string>> table_types = {
+            {{BINARY_SHARING, BINARY_SHARING, BINARY_SHARING}, "BINARY"},
+            {{ARITHMETIC_SHARING, ARITHMETIC_SHARING, ARITHMETIC_SHARING}, "ARITHMETIC"},
+            {{ARITHMETIC_SHARING, BINARY_SHARING, BINARY_SHARING}, "mixed"}};
+        for (auto& [share_types, type_name] : table_types) {
+            std::string name = "T" + std::to_string(gen());
+            o.shareTable(name, table, share_types, servers);
+            protocol.revealTable("[" + name + "]", &s1);
+            expectSameTable(table, s1.getVar<Table>(name), "share_reveal_test() with " + type_name + " table");
+            // Owner和ThirdParty不持有份额，三方各发来一个分量，到达后逐列合并
+            protocol.revealTable("[" + name + "]", &o);
+            expectSameTable(table, o.getVar<Table>(name), "share_reveal_test() with " + type_name + " table revealed to owner");
+            protocol.revealTable("[" + name + "]", &t);
+            expectSameTable(table, t.getVar<Table>(name), "share_reveal_test() with " + type_name + " table revealed to third party");
+        }
+
+        // 按块流水线共享：行数为0、不足一块、恰好一块、跨块且不是块长（Node::SHARE_BLOCK_ROWS，1 << 16行）或字长的整数倍
+        for (size_t rows : {size_t(0), size_t(77), size_t(1 << 16), size_t((1 << 16) + 1), size_t(2 * (1 << 16) + 123)}) {
+            Table blocks = randomTable(Table::INT_MODE, {NO_SHARING, NO_SHARING}, rows, gen);
+            for (size_t j = 0; j < blocks.columns.size(); j++) {
+                for (auto& v : blocks.columns[j].part(0)) {
+                    v &= MAX_SHARE_VALUE;
+                }
+            }
+            std::string name = "B" + std::to_string(gen());
+            o.shareTable(name, blocks, {ARITHMETIC_SHARING, BINARY_SHARING}, servers);
+            protocol.revealTable("[" + name + "]", &s1);
+            expectSameTable(blocks, s1.getVar<Table>(name), "share_reveal_test() with " + std::to_string(rows) + " rows in blocks");
+            protocol.revealTable("[" + name + "]", &o);
+            expectSameTable(blocks, o.getVar<Table>(name), "share_reveal_test() with " + std::to_string(rows) + " rows revealed to owner");
+        }
+
+        // 种子按接收方缓存，owners不按S_0, S_1, S_2的顺序时必须拒绝
+        bool rejected = false;
+        try {
+            o.shareInt("bad_owners", 1, ARITHMETIC_SHARING, {&s1, &s0, &s2});
+        } catch (const std::runtime_error&) {
+            rejected = true;
+        }
+        if (!rejected) {
+            throw std::runtime_error("Test Error in share_reveal_test(): Sharing to owners out of order was accepted");
+        }
+    } catch (const std::exception& e) {
+        failure = e.what();
+    }
+
+    // 主动关闭所有节点，先关闭依赖其他节点的对象
+    o.stop();
+    t.stop();
+    s0.stop();
+    s1.stop();
+    s2.stop();
+
+    // Clean up threads
+    t0.join();
+    t1.join();
+    t2.join();
+    to.join();
+    tt.join();
+
+    if (!failure.empty()) {
+        throw std::runtime_error(failure);
+    }
+}
+
+void hash_join_kernel_test() {
+    std::mt19937 gen(20240611);
+    // 1~4列连接键走打包整数键的FlatJoinTable，5、6列走字符串键的路径
+    // 取值范围随键列数缩小，使各情形都有大量重复键和多对多的匹配
+    const int ranges[] = {0, 12, 4, 2, 2, 1, 1};
+    for (size_t key_num = 1; key_num <= 6; key_num++) {
+        for (auto sizes : {std::pair<size_t, size_t>{300, 700}, {700, 300}, {363, 400}, {0, 50}}) {
+            Table t1 = randomJoinTable(key_num, "a", sizes.first, ranges[key_num], 0, gen);
+            Table t2 = randomJoinTable(key_num, "b", sizes.second, ranges[key_num], 5, gen);
+            // t2的连接键换成与t1相反的列序，检查两表的键按列名对应
+            std::reverse(t2.headers.begin(), t2.headers.begin() + key_num);
+            if (t1.size() > 0 && t2.size() > 0) {
+                // 补齐时追加的dummy行，取值落在各列的取值范围内；padding会先清除已有的dummy，因此在置isNull之前补齐
+                size_t real_rows = t1.size();
+                t1.padding(real_rows + 37);
+                for (size_t r = 6; r < real_rows; r += 7) {
+                    t1.is_null.set(0, r, 1);
+                }
+                // 边界值，检查打包时负数和32位满值的处理
+                t1.columns[0].part(0)[0] = INT_MIN;
+                t2.columns[t2.getColumnIdx("k0")].part(0)[1] = INT_MIN;
+                t1.columns[key_num - 1].part(0)[1] = INT_MAX;
+                t2.columns[t2.getColumnIdx("k" + std::to_string(key_num - 1))].part(0)[0] = INT_MAX;
+                // 与对方真实行的键相同的dummy行，不能参与连接
+                for (size_t r = 2; r < std::min(t1.size(), t2.size()); r += 11) {
+                    for (size_t c = 0; c < key_num; c++) {
+                        std::string h = "k" + std::to_string(c);
+                        t2.columns[t2.getColumnIdx(h)].part(0)[r] = t1.columns[t1.getColumnIdx(h)].cpart(0)[r];
+                    }
+                    t2.is_null.set(0, r, 1);
+                }
+            }
+
+            std::string what = "hash_join_kernel_test() with " + std::to_string(key_num) + " keys, |T1| = " +
+                               std::to_string(t1.size()) + ", |T2| = " + std::to_string(t2.size());
+            Table expected = stringKeyedJoin(t1, t2);
+            Table actual = Join_Hash(t1, t2);
+            expectSameTable(expected, actual, what);
+            std::cout << what << ": " << actual.size() << " rows match" << std::endl;
+        }
+    }
+}
+
+void parallel_hash_join_test() {
+    std::mt19937 gen(20240612);
+    int max_threads = omp_get_max_threads();
+    const int thread_nums[] = {1, 2, 3, 4, 8};
+
+    // 两表合计超过并行连接的阈值（1 << 16行），1线程时走串行的连接核，其余走基数划分的并行连接，结果（含行序）需完全相同
+    auto checkThreads = [&](const Table& t1, const Table& t2, const std::string& what) {
+        omp_set_num_threads(1);
+        Table serial = Join_Hash(t1, t2);
+        expectSameTable(stringKeyedJoin(t1, t2), serial, what + " with 1 thread");
+        for (int threads : thread_nums) {
+            omp_set_num_threads(threads);
+            Table parallel = Join_Hash(t1, t2);
+            expectSameTable(serial, parallel, what + " with " + std::to_string(threads) + " threads");
+        }
+        omp_set_num_threads(max_threads);
+        std::cout << what << ": " << serial.size() << " rows match" << std::endl;
+    };
+
+    try {
+        // 均匀的键，1~4列连接键
+        const int ranges[] = {0, 20000, 150, 30, 12};
+        for (size_t key_num = 1; key_num <= 4; key_num++) {
+            Table t1 = randomJoinTable(key_num, "a", 30000, ranges[key_num], 9, gen);
+            Table t2 = randomJoinTable(key_num, "b", 60000, ranges[key_num], 13, gen);
+            checkThreads(t1, t2, "parallel_hash_join_test() with " + std::to_string(key_num) + " keys");
+        }
+
+        // 倾斜的键：建表一侧九成的行取同一个键，探测一侧九成的行取另一个键，两个分区拿到了大部分的行
+        // 两个热点键在对方表中各只出现少数几次，使结果的行数保持可控
+        Table t1 = randomJoinTable(1, "a", 30000, 50000, 9, gen);
+        Table t2 = randomJoinTable(1, "b", 60000, 50000, 13, gen);
+        auto& k1 = t1.columns[0].part(0);
+        auto& k2 = t2.columns[0].part(0);
+        for (size_t r = 0; r < k1.size(); r++) {
+            if (r % 10 != 0) {
+                k1[r] = 50000;
+            }
+        }
+        for (size_t r = 0; r < k2.size(); r++) {
+            if (r % 10 != 0) {
+                k2[r] = 50001;
+            }
+        }
+        k1[5] = k1[25] = 50001;
+        k2[5] = k2[15] = k2[35] = 50000;
+        checkThreads(t1, t2, "parallel_hash_join_test() with skewed keys");
+    } catch (...) {
+        omp_set_num_threads(max_threads);
+        throw;
+    }
+}
+
 void example_test() {
     // 创建节点对象
     Server s0(0, "SERVER 0");
@@ -954,7 +1662,8 @@ void Euroroads_test() {
     tt.join();
 }
 
-void end_to_end_test(const std::string& G_file_name, const std::string& Q_file_name, bool use_hierarchy, bool use_third_party, bool use_join_strategy, bool add_noise, double e_idx, double e_mf) {
+// 端到端全流程，profile为节点间模拟的网络条件
+static void run_end_to_end(const std::string& G_file_name, const std::string& Q_file_name, bool use_hierarchy, bool use_third_party, bool use_join_strategy, bool add_noise, double e_idx, double e_mf, const NetworkProfile& profile) {
     // 创建节点对象
     Server s0(0, "SERVER 0");
     Server s1(1, "SERVER 1");
@@ -971,12 +1680,19 @@ void end_to_end_test(const std::string& G_file_name, const std::string& Q_file_n
     // std::cout << "all servers are listening" << std::endl;
     // sleep(1);
 
-    // 连接各节点
-    Node::connectToPeers({&s0, &s1, &s2, &o, &t});
+    // 连接各节点，所有节点都在同一进程内，使用进程内传输，使计时反映协议本身的开销（及profile模拟的网络开销）
+    Node::connectToPeers({&s0, &s1, &s2, &o, &t}, IN_PROCESS_TRANSPORT, profile);
     // std::cout << "all servers have connected to peers" << std::endl;
 
     Protocol protocol({&s0, &s1, &s2}, &t);
 
+    std::vector<Node*> nodes = {&s0, &s1, &s2, &o, &t};
+    if (NODE_MEMORY_BUDGET > 0) {
+        for (auto node : nodes) {
+            node->setMemoryBudget(NODE_MEMORY_BUDGET);
+        }
+    }
+
     // 读取表
     Table data_graph(Table::INT_MODE);
     Table query_graph(Table::INT_MODE);
@@ -1047,6 +1763,14 @@ void end_to_end_test(const std::string& G_file_name, const std::string& Q_file_n
     result.normalize();
     t.printVarsInFile();
 
+    if (NODE_MEMORY_BUDGET > 0) {
+        for (auto node : nodes) {
+            SpillStats stats = node->spillStats();
+            std::cout << node->name << ": spills " << stats.spills << " (" << stats.spilled_bytes << " bytes), faults " << stats.faults
+                      << ", resident " << stats.resident_bytes << " bytes" << std::endl;
+        }
+    }
+
     // 主动关闭所有节点，先关闭依赖其他节点的对象
     o.stop();
     t.stop();
@@ -1060,4 +1784,31 @@ void end_to_end_test(const std::string& G_file_name, const std::string& Q_file_n
     t2.join();
     to.join();
     tt.join();
-}
\ No newline at end of file
+}
+
+void end_to_end_test(const std::string& G_file_name, const std::string& Q_file_name, bool use_hierarchy, bool use_third_party, bool use_join_strategy, bool add_noise, double e_idx, double e_mf) {
+    run_end_to_end(G_file_name, Q_file_name, use_hierarchy, use_third_party, use_join_strategy, add_noise, e_idx, e_mf, NetworkProfile());
+}
+
+void end_to_end_wan_benchmark(const std::string& G_file_name, const std::string& Q_file_name, bool use_hierarchy, bool use_third_party, bool use_join_strategy, bool add_noise, double e_idx, double e_mf) {
+    std::vector<std::pair<std::string, long long>> costs;
+    for (const auto& profile : NetworkProfile::wanProfiles()) {
+        NetMetrics::global().clear();
+        auto start = std::chrono::steady_clock::now();
+        run_end_to_end(G_file_name, Q_file_name, use_hierarchy, use_third_party, use_join_strategy, add_noise, e_idx, e_mf, profile);
+        auto end = std::chrono::steady_clock::now();
+        costs.emplace_back(profile.name, std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count());
+
+        std::cout << "-----------------------------------------" << std::endl;
+        std::cout << "Network profile: " << profile.name << " (one-way latency " << profile.shape.latency_ms << " ms, jitter "
+                  << profile.shape.jitter_ms << " ms, bandwidth " << profile.shape.bandwidth_mbps << " Mbps)" << std::endl;
+        std::cout << "Time cost: " << costs.back().second << " ms" << std::endl;
+        std::cout << NetMetrics::global().report();
+    }
+
+    std::cout << "-----------------------------------------" << std::endl;
+    std::cout << "WAN benchmark summary:" << std::endl;
+    for (const auto& [name, cost] : costs) {
+        std::cout << "  " << name << ": " << cost << " ms" << std::endl;
+    }
+}
@@ -8,6 +8,8 @@
 #include <fstream>
 #include <unistd.h>
 
+#include "../Node/NetStats.h"
+
 class Test {
 private:
     std::function<void()> test_func_;                       // 绑定的测试函数
@@ -55,6 +57,9 @@ public:
         success_ = true;
         exception_.clear();
 
+        // 清空上一次测试登记的网络统计
+        NetMetrics::global().clear();
+
         // 记录测试前的内存使用情况
         mem_usage_start_ = getCurrentMemoryUsage();
         // 记录测试前的时间
@@ -99,6 +104,19 @@ public:
         
         std::cout << "Time cost: " << getDuration() << " ms" << std::endl;
         std::cout << "Memory cost: " << getMemoryChange() << " MB" << std::endl;
+        // 协议各阶段按命令的网络统计
+        if (!NetMetrics::global().empty()) {
+            std::cout << NetMetrics::global().report();
+        }
+    }
+
+    // 以CSV格式导出网络统计
+    void dumpNetMetrics(const std::string& path) const {
+        std::ofstream out(path);
+        if (!out) {
+            throw std::runtime_error("Runtime Error in dumpNetMetrics(): Cannot open file: " + path);
+        }
+        out << NetMetrics::global().toCSV();
     }
 };
 
@@ -110,8 +128,16 @@ void limit_test();
 
 void basic_test();
 
+void share_reveal_test();
+
 void table_test();
 
+void table_binary_test();
+
+void bit_column_test();
+
+void share_ring_test();
+
 void graph_submatch_test();
 
 void join_plan_test();
@@ -126,12 +152,20 @@ void compute_AGMBound_test();
 
 void checkMatch_protocol_test();
 
+void checkMatchMPC_protocol_test();
+
+void checkMatchMPC_graph_test();
+
 void star_decomposition_test();
 
 void mix_upper_bound_test();
 
 void hash_join_test();
 
+void hash_join_kernel_test();
+
+void parallel_hash_join_test();
+
 // ------------------------ DataSet Test ------------------------
 
 void example_test(); 
@@ -149,4 +183,7 @@ void Euroroads_test();
 /// @param add_noise 是否对统计结果加噪
 /// @param e_idx 
 /// @param e_mf 
-void end_to_end_test(const std::string& G_file_name, const std::string& Q_file_name, bool use_hierarchy, bool use_third_party, bool use_join_strategy, bool add_noise, double e_idx, double e_mf);
\ No newline at end of file
+void end_to_end_test(const std::string& G_file_name, const std::string& Q_file_name, bool use_hierarchy, bool use_third_party, bool use_join_strategy, bool add_noise, double e_idx, double e_mf);
+
+/// @brief 在一组模拟的广域网条件下分别运行端到端全流程，报告各条件下的耗时和各阶段的网络统计，参数同end_to_end_test
+void end_to_end_wan_benchmark(const std::string& G_file_name, const std::string& Q_file_name, bool use_hierarchy, bool use_third_party, bool use_join_strategy, bool add_noise, double e_idx, double e_mf);
\ No newline at end of file
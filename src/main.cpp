@@ -6,21 +6,30 @@ int main() {
     // Test test(graph_submatch_test);
     // Test test(join_plan_test);
     // Test test(basic_test);
+    // Test test(share_reveal_test);
     // Test test(table_test);
+    // Test test(table_binary_test);
+    // Test test(bit_column_test);
+    // Test test(share_ring_test);
     // Test test(table_index_test);
     // Test test(table_bucketjoin_test);
     // Test test(get_symmetries_test);
     // Test test(compute_AGMBound_test);
     // Test test(checkMatch_protocol_test);
+    // Test test(checkMatchMPC_protocol_test);
+    // Test test(checkMatchMPC_graph_test);
     // Test test(star_decomposition_test);
     // Test test(mix_upper_bound_test);
     // Test test(hash_join_test);
+    // Test test(hash_join_kernel_test);
+    // Test test(parallel_hash_join_test);
 
     // Test test(example_test);
     // Test test(GRQC_test);
     // Test test(Euroroads_test);
     // Test test(end_to_end_test, "data_example_SWW12", "query_example_SWW12", true, true);
     Test test(end_to_end_test, "data_Dolphins", "query_K4", true, true, true, true, 0.2, 1.8);
+    // Test test(end_to_end_wan_benchmark, "data_Dolphins", "query_K4", true, true, true, true, 0.2, 1.8);
 
     test.run();
     test.printMetrics();